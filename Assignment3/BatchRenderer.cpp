@@ -0,0 +1,989 @@
+//
+//  BatchRenderer.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include "glPlatform.h"
+#include "BatchRenderer.h"
+#include "GLStateCache.h"
+
+using namespace std;
+using namespace earshooter;
+
+const int NB_BATCHES = static_cast<int>(RenderBatch::NB_BATCHES);
+
+//	The depths of a batch go from DEPTH_NEAR_LIMIT up to DEPTH_FAR_LIMIT
+//	(the projection keeps the z of the world between -1 and 1), each one a
+//	few steps of the depth buffer above the previous one, so that rounding
+//	can't swap them.
+const float DEPTH_NEAR_LIMIT = -0.5f;
+const float DEPTH_FAR_LIMIT = 0.5f;
+const int DEPTH_STEP_BITS = 2;
+
+//	The legacy (OpenGL 2.1) context that GLUT creates on macOS has no
+//	instancing: the unit meshes are always expanded there.
+#if !defined(__APPLE__)
+	#define INSTANCED_MESHES
+#endif
+
+#ifdef INSTANCED_MESHES
+//	Attribute locations of the instancing program
+const GLuint UNIT_POS_ATTRIB = 0;
+const GLuint MESH_COLOR_ATTRIB = 1;
+const GLuint TINT_ATTRIB = 2;
+const GLuint ROW_X_ATTRIB = 3;
+const GLuint ROW_Y_ATTRIB = 4;
+const GLuint COLOR_ATTRIB = 5;
+const GLuint DEPTH_ATTRIB = 6;
+
+//	Each instance maps the vertices of the mesh to world coordinates, which
+//	the fixed-function modelview and projection then handle as usual.
+//	Unit meshes have no color of their own: they leave meshColor and tint
+//	to constant values that select the instance's color.
+const char* INSTANCE_VERTEX_SHADER =
+	"#version 120\n"
+	"attribute vec2 unitPos;\n"
+	"attribute vec4 meshColor;\n"
+	"attribute float tint;\n"
+	"attribute vec3 rowX;\n"
+	"attribute vec3 rowY;\n"
+	"attribute vec4 color;\n"
+	"attribute float depth;\n"
+	"varying vec4 instanceColor;\n"
+	"void main() {\n"
+	"	vec3 p = vec3(unitPos, 1.0);\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * vec4(dot(rowX, p), dot(rowY, p), depth, 1.0);\n"
+	"	instanceColor = vec4(clamp(meshColor.rgb + tint * color.rgb, 0.0, 1.0), 1.0);\n"
+	"}\n";
+
+const char* INSTANCE_FRAGMENT_SHADER =
+	"#version 120\n"
+	"varying vec4 instanceColor;\n"
+	"void main() {\n"
+	"	gl_FragColor = instanceColor;\n"
+	"}\n";
+
+//	Attribute names of the instancing program, by location
+const char* INSTANCE_ATTRIBUTES[] = {"unitPos", "meshColor", "tint", "rowX", "rowY", "color",
+									 "depth"};
+
+//	The shape program draws a quad per instance, covering the shape's
+//	extent in unit space.  The corners of the quad share the location of
+//	the mesh vertices.
+const GLuint CORNER_ATTRIB = UNIT_POS_ATTRIB;
+const char* SHAPE_ATTRIBUTES[] = {"corner", nullptr, nullptr, "rowX", "rowY", "color", "depth"};
+
+const char* SHAPE_VERTEX_SHADER =
+	"#version 120\n"
+	"attribute vec2 corner;\n"
+	"attribute vec3 rowX;\n"
+	"attribute vec3 rowY;\n"
+	"attribute vec4 color;\n"
+	"attribute float depth;\n"
+	"uniform vec4 extent;\n"
+	"varying vec2 local;\n"
+	"varying vec4 instanceColor;\n"
+	"void main() {\n"
+	"	local = mix(extent.xy, extent.zw, corner);\n"
+	"	vec3 p = vec3(local, 1.0);\n"
+	"	gl_Position = gl_ModelViewProjectionMatrix * vec4(dot(rowX, p), dot(rowY, p), depth, 1.0);\n"
+	"	instanceColor = color;\n"
+	"}\n";
+
+//	Distances are computed in unit space, then converted to pixels by their
+//	screen-space gradient, which also accounts for non-uniform scaling.
+//	The smiling face follows the layout of SmilingFace's baked mesh.
+const char* SHAPE_FRAGMENT_SHADER =
+	"#version 120\n"
+	"uniform int shape;\n"
+	"uniform float lineWidth;\n"
+	"varying vec2 local;\n"
+	"varying vec4 instanceColor;\n"
+	"const float TWO_PI = 6.28318531;\n"
+	"float box(vec2 p) {\n"
+	"	vec2 q = abs(p) - vec2(0.5);\n"
+	"	return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0);\n"
+	"}\n"
+	//	(0, 0), (1, 0), (0, 1)
+	"float unitTriangle(vec2 p) {\n"
+	"	float inside = max(max(-p.x, -p.y), (p.x + p.y - 1.0) * 0.70710678);\n"
+	"	if (inside <= 0.0) return inside;\n"
+	"	vec2 q0 = vec2(clamp(p.x, 0.0, 1.0), 0.0);\n"
+	"	vec2 q1 = vec2(0.0, clamp(p.y, 0.0, 1.0));\n"
+	"	float t = clamp(0.5 * (p.x - p.y + 1.0), 0.0, 1.0);\n"
+	"	vec2 q2 = vec2(t, 1.0 - t);\n"
+	"	return min(min(distance(p, q0), distance(p, q1)), distance(p, q2));\n"
+	"}\n"
+	"float arc(vec2 p, vec2 center, vec2 radii, float startFrac, float endFrac) {\n"
+	"	vec2 q = (p - center) / radii;\n"
+	"	float r = max(length(q), 1e-4);\n"
+	"	float frac = fract(atan(q.y, q.x) / TWO_PI);\n"
+	"	if (frac >= startFrac && frac <= endFrac)\n"
+	"		return abs(r - 1.0) / length(q / (r * radii));\n"
+	"	vec2 start = center + radii * vec2(cos(TWO_PI * startFrac), sin(TWO_PI * startFrac));\n"
+	"	vec2 end = center + radii * vec2(cos(TWO_PI * endFrac), sin(TWO_PI * endFrac));\n"
+	"	return min(distance(p, start), distance(p, end));\n"
+	"}\n"
+	"void main() {\n"
+	"	float unitsPerPixel = 0.5 * (length(dFdx(local)) + length(dFdy(local)));\n"
+	"	if (shape == 3) {\n"
+	"		vec2 eye = vec2(abs(local.x), local.y);\n"
+	"		float head = min(length(local) - 1.0, distance(eye, vec2(0.9, 0.6)) - 0.5);\n"
+	"		if (head > 0.0) discard;\n"
+	"		vec3 rgb = instanceColor.rgb;\n"
+	"		float eyeDistance = distance(eye, vec2(0.4, 0.4));\n"
+	"		if (eyeDistance <= 1.0 / 6.0) rgb = vec3(0.0);\n"
+	"		else if (eyeDistance <= 0.25) rgb = vec3(1.0);\n"
+	"		float mouth = arc(local, vec2(0.0, -0.04), vec2(1.0 / 1.5, 0.5), 0.7, 0.85);\n"
+	"		if (mouth <= 0.5 * lineWidth * unitsPerPixel) rgb = vec3(0.0);\n"
+	"		gl_FragColor = vec4(rgb, 1.0);\n"
+	"		return;\n"
+	"	}\n"
+	"	float d;\n"
+	"	if (shape == 0) d = length(local) - 1.0;\n"
+	"	else if (shape == 1) d = box(local);\n"
+	"	else d = unitTriangle(local);\n"
+	"	float pixels = d / max(length(vec2(dFdx(d), dFdy(d))), 1e-6);\n"
+	"	if (d > 0.0) discard;\n"
+	"	vec3 rgb = instanceColor.rgb;\n"
+	"	if (instanceColor.a > 0.5 && pixels > -lineWidth) rgb = vec3(1.0) - rgb;\n"
+	"	gl_FragColor = vec4(rgb, 1.0);\n"
+	"}\n";
+
+//	Extent of each shape in unit space (xmin, ymin, xmax, ymax), by UnitShape
+const float SHAPE_EXTENT[][4] = {
+	{-1.f, -1.f, 1.f, 1.f},			//	DISK
+	{-0.5f, -0.5f, 0.5f, 0.5f},		//	SQUARE
+	{0.f, 0.f, 1.f, 1.f},			//	TRIANGLE (unit right triangle)
+	{-1.4f, -1.f, 1.4f, 1.1f}		//	SMILING_FACE (the ears stick out)
+};
+
+//	Corners of the quad, as a triangle strip
+const float QUAD_CORNERS[4][2] = {{0.f, 0.f}, {1.f, 0.f}, {0.f, 1.f}, {1.f, 1.f}};
+
+GLuint compileShader(GLenum type, const char* source);
+GLuint buildProgram(const char* vertexSource, const char* fragmentSource,
+					const char* const attribute[], int nbAttributes);
+#endif
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+BatchRenderer::BatchRenderer()
+	:	nbMeshes_(0),
+		meshBufferIsDirty_(false),
+		nbBaked_(0),
+		bakedBufferIsDirty_(false),
+		initialized_(false),
+		useBufferObject_(false),
+		useInstancing_(false),
+		useShapes_(false),
+		shapesEnabled_(true),
+		useDepth_(false),
+		depthStep_(0.f),
+		maxDepths_(1),
+		bufferID_(0),
+		meshBufferID_(0),
+		bakedBufferID_(0),
+		instanceBufferID_(0),
+		quadBufferID_(0),
+		programID_(0),
+		shapeProgramID_(0),
+		shapeUniform_(-1),
+		extentUniform_(-1),
+		lineWidthUniform_(-1),
+		drawCallCount_(0),
+		vertexCount_(0),
+		instanceCount_(0)
+{
+}
+
+BatchRenderer::~BatchRenderer()
+{
+	//	The GL context may be gone by the time global objects are destroyed,
+	//	so the buffers and program are left for the context to release.
+}
+
+void BatchRenderer::initialize()
+{
+	if (initialized_)
+		return;
+	initialized_ = true;
+
+#if defined(_MSC_VER)
+	//	opengl32 only exports OpenGL 1.1: get the rest through GLEW
+	bool glewReady = (glewInit() == GLEW_OK);
+	useBufferObject_ = glewReady && GLEW_VERSION_1_5;
+	useInstancing_ = glewReady && GLEW_VERSION_3_3;
+#else
+	int major = 0, minor = 0;
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	if (version != nullptr)
+		sscanf(version, "%d.%d", &major, &minor);
+	useBufferObject_ = (major > 1) || (major == 1 && minor >= 5);
+	useInstancing_ = (major > 3) || (major == 3 && minor >= 3);
+#endif
+#ifndef INSTANCED_MESHES
+	useInstancing_ = false;
+#endif
+
+	//	Without a depth buffer, the fills of a batch end up under all its lines
+	GLint depthBits = 0;
+	glGetIntegerv(GL_DEPTH_BITS, &depthBits);
+	useDepth_ = depthBits > DEPTH_STEP_BITS;
+	if (useDepth_)
+	{
+		//	a step of the window depth (0 to 1) is half the world's (-1 to 1)
+		depthStep_ = ldexpf(2.f, DEPTH_STEP_BITS - depthBits);
+		maxDepths_ = static_cast<unsigned int>((DEPTH_FAR_LIMIT - DEPTH_NEAR_LIMIT) / depthStep_);
+	}
+	else
+		cout << "No depth buffer: lines may get drawn over the fills added after them" << endl;
+
+	if (useBufferObject_)
+	{
+		GLuint bufferID;
+		glGenBuffers(1, &bufferID);
+		bufferID_ = bufferID;
+	}
+	else
+		cout << "Buffer objects not supported: drawing from client-side arrays" << endl;
+
+	if (useInstancing_)
+		useInstancing_ = createInstancingProgram_();
+	if (useInstancing_)
+	{
+		GLuint bufferID[4];
+		glGenBuffers(4, bufferID);
+		meshBufferID_ = bufferID[0];
+		bakedBufferID_ = bufferID[1];
+		instanceBufferID_ = bufferID[2];
+		quadBufferID_ = bufferID[3];
+
+		useShapes_ = createShapeProgram_();
+		if (!useShapes_)
+			cout << "Could not build the shape program: tessellating basic shapes" << endl;
+	}
+	else
+		cout << "Instancing not supported: expanding disks, ellipses, and meshes on the CPU" << endl;
+}
+
+bool BatchRenderer::createInstancingProgram_()
+{
+#ifdef INSTANCED_MESHES
+	programID_ = buildProgram(INSTANCE_VERTEX_SHADER, INSTANCE_FRAGMENT_SHADER,
+							  INSTANCE_ATTRIBUTES, 7);
+	return programID_ != 0;
+#else
+	return false;
+#endif
+}
+
+bool BatchRenderer::createShapeProgram_()
+{
+#ifdef INSTANCED_MESHES
+	shapeProgramID_ = buildProgram(SHAPE_VERTEX_SHADER, SHAPE_FRAGMENT_SHADER,
+								   SHAPE_ATTRIBUTES, 7);
+	if (shapeProgramID_ == 0)
+		return false;
+	shapeUniform_ = glGetUniformLocation(shapeProgramID_, "shape");
+	extentUniform_ = glGetUniformLocation(shapeProgramID_, "extent");
+	lineWidthUniform_ = glGetUniformLocation(shapeProgramID_, "lineWidth");
+	GLStateCache::bindArrayBuffer(quadBufferID_);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD_CORNERS), QUAD_CORNERS, GL_STATIC_DRAW);
+	GLStateCache::bindArrayBuffer(0);
+	return true;
+#else
+	return false;
+#endif
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Geometry
+//--------------------------------------
+#endif
+
+inline void BatchRenderer::pushVertex_(vector<BatchVertex>& vertices,
+									   const Transform2D& transform, float x, float y,
+									   float z, const uint8_t rgba[4])
+{
+	BatchVertex v;
+	transform.apply(x, y, v.x, v.y);
+	v.z = z;
+	v.rgba[0] = rgba[0];
+	v.rgba[1] = rgba[1];
+	v.rgba[2] = rgba[2];
+	v.rgba[3] = rgba[3];
+	vertices.push_back(v);
+}
+
+//	Past the resolution of the depth buffer, the last additions share the
+//	last depth, and are drawn in the order of their type.
+inline float BatchRenderer::nextDepth_(Batch& batch) const
+{
+	if (batch.nbAdded < maxDepths_)
+		batch.nbAdded++;
+	return DEPTH_NEAR_LIMIT + batch.nbAdded * depthStep_;
+}
+
+void BatchRenderer::addPolygon(RenderBatch batch, const Transform2D& transform,
+							   const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	if (nbPts < 3)
+		return;
+
+	uint8_t rgba[4];
+	packColor_(r, g, b, rgba);
+	Batch& target = batch_[static_cast<int>(batch)];
+	vector<BatchVertex>& fill = target.fill;
+	float z = nextDepth_(target);
+	//	the first vertex is shared by all the triangles of the fan
+	BatchVertex first;
+	transform.apply(xy[0][0], xy[0][1], first.x, first.y);
+	first.z = z;
+	for (int k = 0; k < 4; k++)
+		first.rgba[k] = rgba[k];
+	BatchVertex previous;
+	transform.apply(xy[1][0], xy[1][1], previous.x, previous.y);
+	previous.z = z;
+	for (int k = 0; k < 4; k++)
+		previous.rgba[k] = rgba[k];
+	for (int k = 2; k < nbPts; k++)
+	{
+		fill.push_back(first);
+		fill.push_back(previous);
+		pushVertex_(fill, transform, xy[k][0], xy[k][1], z, rgba);
+		previous = fill.back();
+	}
+}
+
+void BatchRenderer::addTriangles(RenderBatch batch, const Transform2D& transform,
+								 const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	uint8_t rgba[4];
+	packColor_(r, g, b, rgba);
+	Batch& target = batch_[static_cast<int>(batch)];
+	vector<BatchVertex>& fill = target.fill;
+	float z = nextDepth_(target);
+	for (int k = 0; k + 2 < nbPts; k += 3)
+	{
+		pushVertex_(fill, transform, xy[k][0], xy[k][1], z, rgba);
+		pushVertex_(fill, transform, xy[k+1][0], xy[k+1][1], z, rgba);
+		pushVertex_(fill, transform, xy[k+2][0], xy[k+2][1], z, rgba);
+	}
+}
+
+void BatchRenderer::addLineLoop(RenderBatch batch, const Transform2D& transform,
+								const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	if (nbPts < 2)
+		return;
+
+	addLineStrip(batch, transform, xy, nbPts, r, g, b);
+	//	close the loop, at the depth of the strip
+	uint8_t rgba[4];
+	packColor_(r, g, b, rgba);
+	vector<BatchVertex>& lines = batch_[static_cast<int>(batch)].lines;
+	BatchVertex last = lines.back();
+	lines.push_back(last);
+	pushVertex_(lines, transform, xy[0][0], xy[0][1], last.z, rgba);
+}
+
+void BatchRenderer::addLineStrip(RenderBatch batch, const Transform2D& transform,
+								 const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	if (nbPts < 2)
+		return;
+
+	uint8_t rgba[4];
+	packColor_(r, g, b, rgba);
+	Batch& target = batch_[static_cast<int>(batch)];
+	vector<BatchVertex>& lines = target.lines;
+	float z = nextDepth_(target);
+	pushVertex_(lines, transform, xy[0][0], xy[0][1], z, rgba);
+	for (int k = 1; k < nbPts; k++)
+	{
+		pushVertex_(lines, transform, xy[k][0], xy[k][1], z, rgba);
+		//	GL_LINES: each inner vertex ends a segment and starts the next one
+		if (k < nbPts - 1)
+		{
+			BatchVertex last = lines.back();
+			lines.push_back(last);
+		}
+	}
+}
+
+void BatchRenderer::addMeshFill(RenderBatch batch, const Transform2D& transform,
+								const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	int index = useInstancing_ ? findMesh_(xy, nbPts) : -1;
+	if (index < 0)
+		addPolygon(batch, transform, xy, nbPts, r, g, b);
+	else
+	{
+		Batch& target = batch_[static_cast<int>(batch)];
+		addInstance_(target.meshFill[index], transform, nextDepth_(target), r, g, b);
+	}
+}
+
+void BatchRenderer::addMeshOutline(RenderBatch batch, const Transform2D& transform,
+								   const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	int index = useInstancing_ ? findMesh_(xy, nbPts) : -1;
+	if (index < 0)
+		addLineLoop(batch, transform, xy, nbPts, r, g, b);
+	else
+	{
+		Batch& target = batch_[static_cast<int>(batch)];
+		addInstance_(target.meshOutline[index], transform, nextDepth_(target), r, g, b);
+	}
+}
+
+void BatchRenderer::addMesh(RenderBatch batch, const Transform2D& transform,
+							const BatchMesh& mesh, float r, float g, float b)
+{
+	Batch& target = batch_[static_cast<int>(batch)];
+	float z = nextDepth_(target);
+	int index = useInstancing_ ? findBakedMesh_(mesh) : -1;
+	if (index >= 0)
+	{
+		addInstance_(target.bakedMesh[index], transform, z, r, g, b);
+		return;
+	}
+
+	//	Expand the mesh into the batch, resolving the tinted colors
+	float rgb[3] = {r, g, b};
+	const vector<MeshVertex>* source[2] = {&mesh.getFill(), &mesh.getLines()};
+	vector<BatchVertex>* destination[2] = {&target.fill, &target.lines};
+	for (int k = 0; k < 2; k++)
+	{
+		for (const MeshVertex& vertex : *source[k])
+		{
+			BatchVertex v;
+			transform.apply(vertex.x, vertex.y, v.x, v.y);
+			v.z = z;
+			packColor_(vertex.rgba[0] / 255.f + vertex.tint * rgb[0],
+					   vertex.rgba[1] / 255.f + vertex.tint * rgb[1],
+					   vertex.rgba[2] / 255.f + vertex.tint * rgb[2], v.rgba);
+			destination[k]->push_back(v);
+		}
+	}
+}
+
+void BatchRenderer::addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+							 const float (*xy)[2], int nbPts, bool contour,
+							 float r, float g, float b)
+{
+	if (!usesShapes() || (shape == UnitShape::TRIANGLE && nbPts != 3))
+	{
+		Renderer2D::addShape(batch, transform, shape, xy, nbPts, contour, r, g, b);
+		return;
+	}
+
+	Batch& target = batch_[static_cast<int>(batch)];
+	vector<MeshInstance>& instances = target.shape[static_cast<int>(shape)];
+	float z = nextDepth_(target);
+	if (shape == UnitShape::TRIANGLE)
+	{
+		//	the unit right triangle, mapped onto the triangle's vertices
+		Transform2D corner{xy[1][0] - xy[0][0], xy[1][1] - xy[0][1],
+						   xy[2][0] - xy[0][0], xy[2][1] - xy[0][1], xy[0][0], xy[0][1]};
+		Transform2D toWorld;
+		toWorld.a = transform.a * corner.a + transform.c * corner.b;
+		toWorld.b = transform.b * corner.a + transform.d * corner.b;
+		toWorld.c = transform.a * corner.c + transform.c * corner.d;
+		toWorld.d = transform.b * corner.c + transform.d * corner.d;
+		transform.apply(corner.tx, corner.ty, toWorld.tx, toWorld.ty);
+		addInstance_(instances, toWorld, z, r, g, b);
+	}
+	else
+		addInstance_(instances, transform, z, r, g, b);
+	instances.back().rgba[3] = contour ? 255 : 0;
+}
+
+void BatchRenderer::addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+							 const BatchMesh& mesh, float r, float g, float b)
+{
+	if (!usesShapes())
+	{
+		Renderer2D::addShape(batch, transform, shape, mesh, r, g, b);
+		return;
+	}
+	Batch& target = batch_[static_cast<int>(batch)];
+	addInstance_(target.shape[static_cast<int>(shape)], transform, nextDepth_(target), r, g, b);
+}
+
+int BatchRenderer::findMesh_(const float (*xy)[2], int nbPts)
+{
+	for (int k = 0; k < nbMeshes_; k++)
+		if (mesh_[k].xy == xy && mesh_[k].nbPts == nbPts)
+			return k;
+
+	//	Not seen yet: append it to the mesh buffer (if there is room left)
+	if (nbMeshes_ == MAX_MESHES || nbPts < 3)
+		return -1;
+	UnitMesh& mesh = mesh_[nbMeshes_];
+	mesh.xy = xy;
+	mesh.nbPts = nbPts;
+	mesh.first = (nbMeshes_ == 0) ? 0 : mesh_[nbMeshes_-1].first + mesh_[nbMeshes_-1].nbPts;
+	meshBufferIsDirty_ = true;
+	return nbMeshes_++;
+}
+
+int BatchRenderer::findBakedMesh_(const BatchMesh& mesh)
+{
+	for (int k = 0; k < nbBaked_; k++)
+		if (baked_[k].mesh == &mesh)
+			return k;
+
+	if (nbBaked_ == MAX_MESHES)
+		return -1;
+	BakedMesh& baked = baked_[nbBaked_];
+	baked.mesh = &mesh;
+	if (nbBaked_ == 0)
+		baked.firstFill = 0;
+	else
+	{
+		const BakedMesh& previous = baked_[nbBaked_-1];
+		baked.firstFill = previous.firstLine + static_cast<int>(previous.mesh->getLines().size());
+	}
+	baked.firstLine = baked.firstFill + static_cast<int>(mesh.getFill().size());
+	bakedBufferIsDirty_ = true;
+	return nbBaked_++;
+}
+
+inline void BatchRenderer::addInstance_(vector<MeshInstance>& instances,
+										const Transform2D& transform, float z,
+										float r, float g, float b)
+{
+	MeshInstance instance;
+	instance.rowX[0] = transform.a;
+	instance.rowX[1] = transform.c;
+	instance.rowX[2] = transform.tx;
+	instance.rowY[0] = transform.b;
+	instance.rowY[1] = transform.d;
+	instance.rowY[2] = transform.ty;
+	packColor_(r, g, b, instance.rgba);
+	instance.z = z;
+	instances.push_back(instance);
+}
+
+void BatchRenderer::setLineWidth(RenderBatch batch, float width)
+{
+	batch_[static_cast<int>(batch)].lineWidth = width;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Rendering
+//--------------------------------------
+#endif
+
+void BatchRenderer::flush()
+{
+	drawCallCount_ = 0;
+	vertexCount_ = 0;
+	instanceCount_ = 0;
+
+	//	Lay out all the batches back to back, and their instances likewise
+	size_t fillStart[NB_BATCHES], lineStart[NB_BATCHES];
+	size_t fillInstanceStart[NB_BATCHES][MAX_MESHES], outlineInstanceStart[NB_BATCHES][MAX_MESHES];
+	size_t bakedInstanceStart[NB_BATCHES][MAX_MESHES];
+	size_t shapeInstanceStart[NB_BATCHES][NB_SHAPES];
+	stream_.clear();
+	instanceStream_.clear();
+	for (int k = 0; k < NB_BATCHES; k++)
+	{
+		Batch& batch = batch_[k];
+		fillStart[k] = stream_.size();
+		stream_.insert(stream_.end(), batch.fill.begin(), batch.fill.end());
+		lineStart[k] = stream_.size();
+		stream_.insert(stream_.end(), batch.lines.begin(), batch.lines.end());
+		for (int m = 0; m < nbMeshes_; m++)
+		{
+			fillInstanceStart[k][m] = instanceStream_.size();
+			instanceStream_.insert(instanceStream_.end(),
+								   batch.meshFill[m].begin(), batch.meshFill[m].end());
+			outlineInstanceStart[k][m] = instanceStream_.size();
+			instanceStream_.insert(instanceStream_.end(),
+								   batch.meshOutline[m].begin(), batch.meshOutline[m].end());
+		}
+		for (int m = 0; m < nbBaked_; m++)
+		{
+			bakedInstanceStart[k][m] = instanceStream_.size();
+			instanceStream_.insert(instanceStream_.end(),
+								   batch.bakedMesh[m].begin(), batch.bakedMesh[m].end());
+		}
+		for (int s = 0; s < NB_SHAPES; s++)
+		{
+			shapeInstanceStart[k][s] = instanceStream_.size();
+			instanceStream_.insert(instanceStream_.end(),
+								   batch.shape[s].begin(), batch.shape[s].end());
+		}
+	}
+	if (stream_.empty() && instanceStream_.empty())
+		return;
+	vertexCount_ = static_cast<unsigned int>(stream_.size());
+	instanceCount_ = static_cast<unsigned int>(instanceStream_.size());
+
+	//	With a buffer object, the vertex pointers are offsets in the buffer.
+	//	Re-specifying the whole buffer every frame lets the driver hand us
+	//	fresh storage rather than wait for the previous frame's draws.
+	uintptr_t base;
+	if (useBufferObject_)
+	{
+		GLStateCache::bindArrayBuffer(bufferID_);
+		glBufferData(GL_ARRAY_BUFFER, stream_.size() * sizeof(BatchVertex),
+					 stream_.data(), GL_STREAM_DRAW);
+		base = 0;
+	}
+	else
+		base = reinterpret_cast<uintptr_t>(stream_.data());
+
+	if (!instanceStream_.empty())
+	{
+		uploadMeshes_();
+		GLStateCache::bindArrayBuffer(instanceBufferID_);
+		glBufferData(GL_ARRAY_BUFFER, instanceStream_.size() * sizeof(MeshInstance),
+					 instanceStream_.data(), GL_STREAM_DRAW);
+	}
+
+	//	Within a batch, the filled triangles come first, then the filled
+	//	instances, then the shapes (with their contour), then all the lines.
+	//	A baked mesh's triangles and lines are drawn with the other ones.
+	//	The depth test puts them back in the order they were added: each
+	//	batch starts from a cleared depth buffer, and at equal depth (the
+	//	parts of a single addition), what is drawn last wins.
+	if (useDepth_)
+	{
+		glEnable(GL_DEPTH_TEST);
+		glDepthFunc(GL_LEQUAL);
+	}
+	for (int k = 0; k < NB_BATCHES; k++)
+	{
+		Batch& batch = batch_[k];
+		if (batch.nbAdded == 0)
+			continue;
+		if (useDepth_)
+			glClear(GL_DEPTH_BUFFER_BIT);
+		if (!batch.fill.empty())
+		{
+			enableArrays_(base);
+			glDrawArrays(GL_TRIANGLES, static_cast<GLint>(fillStart[k]),
+						 static_cast<GLsizei>(batch.fill.size()));
+			drawCallCount_++;
+		}
+		for (int m = 0; m < nbMeshes_; m++)
+		{
+			if (!batch.meshFill[m].empty())
+			{
+				disableArrays_();
+				drawInstances_(GL_TRIANGLE_FAN, false, mesh_[m].first, mesh_[m].nbPts,
+							   fillInstanceStart[k][m], batch.meshFill[m].size());
+			}
+		}
+		for (int m = 0; m < nbBaked_; m++)
+		{
+			const BatchMesh& mesh = *baked_[m].mesh;
+			if (!batch.bakedMesh[m].empty() && !mesh.getFill().empty())
+			{
+				disableArrays_();
+				drawInstances_(GL_TRIANGLES, true, baked_[m].firstFill,
+							   static_cast<int>(mesh.getFill().size()),
+							   bakedInstanceStart[k][m], batch.bakedMesh[m].size());
+			}
+		}
+		for (int s = 0; s < NB_SHAPES; s++)
+		{
+			if (!batch.shape[s].empty())
+			{
+				disableArrays_();
+				drawShapes_(s, batch.lineWidth, shapeInstanceStart[k][s], batch.shape[s].size());
+			}
+		}
+		GLStateCache::setLineWidth(batch.lineWidth);
+		for (int m = 0; m < nbMeshes_; m++)
+		{
+			if (!batch.meshOutline[m].empty())
+			{
+				disableArrays_();
+				drawInstances_(GL_LINE_LOOP, false, mesh_[m].first, mesh_[m].nbPts,
+							   outlineInstanceStart[k][m], batch.meshOutline[m].size());
+			}
+		}
+		for (int m = 0; m < nbBaked_; m++)
+		{
+			const BatchMesh& mesh = *baked_[m].mesh;
+			if (!batch.bakedMesh[m].empty() && !mesh.getLines().empty())
+			{
+				disableArrays_();
+				drawInstances_(GL_LINES, true, baked_[m].firstLine,
+							   static_cast<int>(mesh.getLines().size()),
+							   bakedInstanceStart[k][m], batch.bakedMesh[m].size());
+			}
+		}
+		if (!batch.lines.empty())
+		{
+			enableArrays_(base);
+			glDrawArrays(GL_LINES, static_cast<GLint>(lineStart[k]),
+						 static_cast<GLsizei>(batch.lines.size()));
+			drawCallCount_++;
+		}
+		GLStateCache::setLineWidth(1.f);
+
+		batch.fill.clear();
+		batch.lines.clear();
+		for (int m = 0; m < nbMeshes_; m++)
+		{
+			batch.meshFill[m].clear();
+			batch.meshOutline[m].clear();
+		}
+		for (int m = 0; m < nbBaked_; m++)
+			batch.bakedMesh[m].clear();
+		for (int s = 0; s < NB_SHAPES; s++)
+			batch.shape[s].clear();
+		batch.nbAdded = 0;
+	}
+	if (useDepth_)
+		glDisable(GL_DEPTH_TEST);
+
+	//	The programs stay bound from one instanced draw to the next: only
+	//	the fixed-function draws, and the end of the frame, go back to none.
+	disableArrays_();
+	if (useInstancing_)
+		GLStateCache::useProgram(0);
+	if (useBufferObject_)
+		GLStateCache::bindArrayBuffer(0);
+}
+
+void BatchRenderer::enableArrays_(uintptr_t base)
+{
+	//	(Re)specified before each draw, since the instancing attributes may
+	//	alias the fixed-function vertex array.
+	if (useInstancing_)
+		GLStateCache::useProgram(0);
+	if (useBufferObject_)
+		GLStateCache::bindArrayBuffer(bufferID_);
+	GLStateCache::setClientState(GL_VERTEX_ARRAY, true);
+	GLStateCache::setClientState(GL_COLOR_ARRAY, true);
+	glVertexPointer(3, GL_FLOAT, sizeof(BatchVertex),
+					reinterpret_cast<const GLvoid*>(base + offsetof(BatchVertex, x)));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex),
+				   reinterpret_cast<const GLvoid*>(base + offsetof(BatchVertex, rgba)));
+}
+
+void BatchRenderer::disableArrays_()
+{
+	GLStateCache::setClientState(GL_COLOR_ARRAY, false);
+	GLStateCache::setClientState(GL_VERTEX_ARRAY, false);
+}
+
+void BatchRenderer::uploadMeshes_()
+{
+	if (meshBufferIsDirty_)
+	{
+		vector<float> xy;
+		for (int m = 0; m < nbMeshes_; m++)
+			for (int k = 0; k < mesh_[m].nbPts; k++)
+			{
+				xy.push_back(mesh_[m].xy[k][0]);
+				xy.push_back(mesh_[m].xy[k][1]);
+			}
+		GLStateCache::bindArrayBuffer(meshBufferID_);
+		glBufferData(GL_ARRAY_BUFFER, xy.size() * sizeof(float), xy.data(), GL_STATIC_DRAW);
+		meshBufferIsDirty_ = false;
+	}
+
+	if (bakedBufferIsDirty_)
+	{
+		vector<MeshVertex> vertices;
+		for (int m = 0; m < nbBaked_; m++)
+		{
+			const BatchMesh& mesh = *baked_[m].mesh;
+			vertices.insert(vertices.end(), mesh.getFill().begin(), mesh.getFill().end());
+			vertices.insert(vertices.end(), mesh.getLines().begin(), mesh.getLines().end());
+		}
+		GLStateCache::bindArrayBuffer(bakedBufferID_);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(MeshVertex), vertices.data(),
+					 GL_STATIC_DRAW);
+		bakedBufferIsDirty_ = false;
+	}
+}
+
+void BatchRenderer::drawInstances_(unsigned int mode, bool baked, int first, int nbVertices,
+								   size_t start, size_t count)
+{
+#ifdef INSTANCED_MESHES
+	GLStateCache::useProgram(programID_);
+
+	//	per-vertex: the mesh
+	glEnableVertexAttribArray(UNIT_POS_ATTRIB);
+	if (baked)
+	{
+		GLStateCache::bindArrayBuffer(bakedBufferID_);
+		glVertexAttribPointer(UNIT_POS_ATTRIB, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+							  reinterpret_cast<const GLvoid*>(offsetof(MeshVertex, x)));
+		glVertexAttribPointer(MESH_COLOR_ATTRIB, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(MeshVertex),
+							  reinterpret_cast<const GLvoid*>(offsetof(MeshVertex, rgba)));
+		glVertexAttribPointer(TINT_ATTRIB, 1, GL_FLOAT, GL_FALSE, sizeof(MeshVertex),
+							  reinterpret_cast<const GLvoid*>(offsetof(MeshVertex, tint)));
+		glEnableVertexAttribArray(MESH_COLOR_ATTRIB);
+		glEnableVertexAttribArray(TINT_ATTRIB);
+	}
+	else
+	{
+		GLStateCache::bindArrayBuffer(meshBufferID_);
+		glVertexAttribPointer(UNIT_POS_ATTRIB, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+		//	all of the instance's color
+		glVertexAttrib4f(MESH_COLOR_ATTRIB, 0.f, 0.f, 0.f, 1.f);
+		glVertexAttrib1f(TINT_ATTRIB, 1.f);
+	}
+
+	//	per-instance: transformation rows, color, and depth
+	uintptr_t offset = start * sizeof(MeshInstance);
+	GLStateCache::bindArrayBuffer(instanceBufferID_);
+	glVertexAttribPointer(ROW_X_ATTRIB, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, rowX)));
+	glVertexAttribPointer(ROW_Y_ATTRIB, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, rowY)));
+	glVertexAttribPointer(COLOR_ATTRIB, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, rgba)));
+	glVertexAttribPointer(DEPTH_ATTRIB, 1, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, z)));
+	for (GLuint attrib = ROW_X_ATTRIB; attrib <= DEPTH_ATTRIB; attrib++)
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+
+	glDrawArraysInstanced(mode, first, nbVertices, static_cast<GLsizei>(count));
+	drawCallCount_++;
+
+	for (GLuint attrib = ROW_X_ATTRIB; attrib <= DEPTH_ATTRIB; attrib++)
+	{
+		glVertexAttribDivisor(attrib, 0);
+		glDisableVertexAttribArray(attrib);
+	}
+	glDisableVertexAttribArray(TINT_ATTRIB);
+	glDisableVertexAttribArray(MESH_COLOR_ATTRIB);
+	glDisableVertexAttribArray(UNIT_POS_ATTRIB);
+#endif
+}
+
+void BatchRenderer::drawShapes_(int shape, float lineWidth, size_t start, size_t count)
+{
+#ifdef INSTANCED_MESHES
+	GLStateCache::useProgram(shapeProgramID_);
+	glUniform1i(shapeUniform_, shape);
+	glUniform4fv(extentUniform_, 1, SHAPE_EXTENT[shape]);
+	glUniform1f(lineWidthUniform_, lineWidth);
+
+	//	per-vertex: the corners of the quad
+	GLStateCache::bindArrayBuffer(quadBufferID_);
+	glVertexAttribPointer(CORNER_ATTRIB, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+	glEnableVertexAttribArray(CORNER_ATTRIB);
+
+	//	per-instance: transformation rows, color, contour flag, and depth
+	uintptr_t offset = start * sizeof(MeshInstance);
+	GLStateCache::bindArrayBuffer(instanceBufferID_);
+	glVertexAttribPointer(ROW_X_ATTRIB, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, rowX)));
+	glVertexAttribPointer(ROW_Y_ATTRIB, 3, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, rowY)));
+	glVertexAttribPointer(COLOR_ATTRIB, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, rgba)));
+	glVertexAttribPointer(DEPTH_ATTRIB, 1, GL_FLOAT, GL_FALSE, sizeof(MeshInstance),
+						  reinterpret_cast<const GLvoid*>(offset + offsetof(MeshInstance, z)));
+	for (GLuint attrib = ROW_X_ATTRIB; attrib <= DEPTH_ATTRIB; attrib++)
+	{
+		glEnableVertexAttribArray(attrib);
+		glVertexAttribDivisor(attrib, 1);
+	}
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+	drawCallCount_++;
+
+	for (GLuint attrib = ROW_X_ATTRIB; attrib <= DEPTH_ATTRIB; attrib++)
+	{
+		glVertexAttribDivisor(attrib, 0);
+		glDisableVertexAttribArray(attrib);
+	}
+	glDisableVertexAttribArray(CORNER_ATTRIB);
+#endif
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Free functions
+//--------------------------------------
+#endif
+
+#ifdef INSTANCED_MESHES
+GLuint compileShader(GLenum type, const char* source)
+{
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, nullptr);
+	glCompileShader(shader);
+
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (compiled != GL_TRUE)
+	{
+		char log[512];
+		glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+		cout << "Could not compile a shader: " << log << endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+GLuint buildProgram(const char* vertexSource, const char* fragmentSource,
+					const char* const attribute[], int nbAttributes)
+{
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	if (vertexShader == 0 || fragmentShader == 0)
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return 0;
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	//	each attribute at the location of its index (null for unused ones)
+	for (int k = 0; k < nbAttributes; k++)
+		if (attribute[k] != nullptr)
+			glBindAttribLocation(program, k, attribute[k]);
+	glLinkProgram(program);
+	//	the program keeps the shaders alive for as long as it needs them
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		char log[512];
+		glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+		cout << "Could not link a shader program: " << log << endl;
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+#endif
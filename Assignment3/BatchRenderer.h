@@ -0,0 +1,258 @@
+//
+//  BatchRenderer.h
+//  Week 08 - Earshooter
+//
+//	OpenGL implementation of Renderer2D.
+//	Collects the geometry of all the objects of a frame, already transformed
+//	to world coordinates on the CPU, into one vertex batch per type of
+//	object, then submits each batch with one glDrawArrays call for its
+//	filled triangles and one for its lines.  So that overlapping objects
+//	still cover one another in the order they were added, and not fills
+//	under lines, each addition to a batch gets the next depth, and the
+//	batch is drawn with the depth test on: an object's contour stays under
+//	the objects added after it.  All the batches are streamed
+//	through a single vertex buffer object.  If the OpenGL implementation
+//	doesn't support buffer objects (OpenGL < 1.5), the same batches are
+//	drawn from client-side vertex arrays instead.
+//	Shapes that are instances of a shared unit mesh (disks and ellipses are
+//	all instances of the unit circle) are not expanded on the CPU: the mesh
+//	is uploaded once, and each shape only adds its transformation and color
+//	to an instance buffer.  Each batch then draws all its instances of a
+//	mesh with one glDrawArraysInstanced call.  Instancing requires OpenGL 3.3
+//	(for glVertexAttribDivisor); with older versions, the instances are
+//	expanded into the regular batches.
+//	Composite shapes are baked once into a BatchMesh, in unit space, with
+//	per-part colors, and drawn the same way, as instances of their mesh.
+//	Basic shapes (disks and ellipses, rectangles, triangles, and smiling
+//	faces) can instead be drawn from their signed distance function: each
+//	one is a single instanced quad, and the fragment shader decides, from
+//	the distance to the shape's edge, whether a fragment is outside, in its
+//	contour, or inside (and in which part of a face).  Edges are then exact
+//	at any scale, with no tessellation at all.  A triangle is drawn as the
+//	affine image of a unit right triangle, so that all the triangles share
+//	the same quad and program.
+
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <cstdint>
+#include <vector>
+#include "Renderer2D.h"
+
+namespace earshooter
+{
+	/**	Vertex of a batch: world coordinates, depth, and RGBA color
+	 */
+	struct BatchVertex
+	{
+		float x, y, z;
+		uint8_t rgba[4];
+	};
+
+	/**	Instance of a unit mesh: rows of its local to world transformation,
+	 *	RGBA color, and depth
+	 */
+	struct MeshInstance
+	{
+		float rowX[3];		//	a, c, tx
+		float rowY[3];		//	b, d, ty
+		uint8_t rgba[4];
+		float z;
+	};
+
+	class BatchRenderer : public Renderer2D
+	{
+		private:
+
+			/**	largest number of unit meshes drawn by instancing
+			 */
+			static const int MAX_MESHES = 8;
+
+			static const int NB_SHAPES = static_cast<int>(UnitShape::NB_SHAPES);
+
+			struct Batch
+			{
+				std::vector<BatchVertex> fill;		//	GL_TRIANGLES
+				std::vector<BatchVertex> lines;		//	GL_LINES
+				float lineWidth = 1.f;
+				//	instances of each unit mesh, filled and outlined
+				std::vector<MeshInstance> meshFill[MAX_MESHES];
+				std::vector<MeshInstance> meshOutline[MAX_MESHES];
+				//	instances of each baked mesh
+				std::vector<MeshInstance> bakedMesh[MAX_MESHES];
+				//	instances of each shape drawn from its distance function
+				//	(alpha is 255 for the ones with a contour, 0 otherwise)
+				std::vector<MeshInstance> shape[NB_SHAPES];
+				//	number of additions so far, which sets the depth of the next one
+				unsigned int nbAdded = 0;
+			};
+
+			/**	A unit mesh, registered the first time it is instanced
+			 */
+			struct UnitMesh
+			{
+				const float (*xy)[2];
+				int nbPts;
+				int first;		//	index of its first vertex in the mesh buffer
+			};
+
+			/**	A baked mesh, registered the first time it is instanced
+			 */
+			struct BakedMesh
+			{
+				const BatchMesh* mesh;
+				int firstFill;		//	index of its first triangle vertex in the buffer
+				int firstLine;		//	index of its first line vertex in the buffer
+			};
+
+			Batch batch_[static_cast<int>(RenderBatch::NB_BATCHES)];
+
+			/**	All the batches of a frame, back to back, as uploaded
+			 */
+			std::vector<BatchVertex> stream_;
+
+			/**	All the instances of a frame, back to back, as uploaded
+			 */
+			std::vector<MeshInstance> instanceStream_;
+
+			UnitMesh mesh_[MAX_MESHES];
+			int nbMeshes_;
+			bool meshBufferIsDirty_;
+
+			BakedMesh baked_[MAX_MESHES];
+			int nbBaked_;
+			bool bakedBufferIsDirty_;
+
+			bool initialized_;
+			bool useBufferObject_;
+			bool useInstancing_;
+			bool useShapes_;
+			bool shapesEnabled_;
+			bool useDepth_;
+			float depthStep_;
+			unsigned int maxDepths_;
+			unsigned int bufferID_;
+			unsigned int meshBufferID_;
+			unsigned int bakedBufferID_;
+			unsigned int instanceBufferID_;
+			unsigned int quadBufferID_;
+			unsigned int programID_;
+			unsigned int shapeProgramID_;
+			int shapeUniform_, extentUniform_, lineWidthUniform_;
+
+			unsigned int drawCallCount_;
+			unsigned int vertexCount_;
+			unsigned int instanceCount_;
+
+			static void pushVertex_(std::vector<BatchVertex>& vertices,
+									const Transform2D& transform, float x, float y,
+									float z, const uint8_t rgba[4]);
+
+			float nextDepth_(Batch& batch) const;
+
+			int findMesh_(const float (*xy)[2], int nbPts);
+			int findBakedMesh_(const BatchMesh& mesh);
+			void addInstance_(std::vector<MeshInstance>& instances,
+							  const Transform2D& transform, float z, float r, float g, float b);
+			bool createInstancingProgram_();
+			bool createShapeProgram_();
+			void uploadMeshes_();
+			void enableArrays_(uintptr_t base);
+			void disableArrays_();
+			void drawInstances_(unsigned int mode, bool baked, int first, int nbVertices,
+								size_t start, size_t count);
+			void drawShapes_(int shape, float lineWidth, size_t start, size_t count);
+
+		public:
+
+			BatchRenderer();
+			~BatchRenderer();
+
+			/**	Checks for buffer object support and creates the vertex buffer.
+			 *	Must be called once the OpenGL context exists (after the window
+			 *	was created).
+			 */
+			void initialize();
+
+			void addPolygon(RenderBatch batch, const Transform2D& transform,
+							const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addTriangles(RenderBatch batch, const Transform2D& transform,
+							  const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addLineLoop(RenderBatch batch, const Transform2D& transform,
+							 const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addLineStrip(RenderBatch batch, const Transform2D& transform,
+							  const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addMeshFill(RenderBatch batch, const Transform2D& transform,
+							 const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addMeshOutline(RenderBatch batch, const Transform2D& transform,
+								const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addMesh(RenderBatch batch, const Transform2D& transform, const BatchMesh& mesh,
+						 float r, float g, float b) override;
+			void addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+						  const float (*xy)[2], int nbPts, bool contour,
+						  float r, float g, float b) override;
+			void addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+						  const BatchMesh& mesh, float r, float g, float b) override;
+			void setLineWidth(RenderBatch batch, float width) override;
+			void flush() override;
+
+			/**	Number of draw calls issued by the last flush
+			 */
+			inline unsigned int getDrawCallCount() const
+			{
+				return drawCallCount_;
+			}
+
+			/**	Number of vertices submitted by the last flush
+			 */
+			inline unsigned int getVertexCount() const
+			{
+				return vertexCount_;
+			}
+
+			/**	Number of unit and baked mesh instances drawn by the last flush
+			 */
+			inline unsigned int getInstanceCount() const
+			{
+				return instanceCount_;
+			}
+
+			/**	Reports whether the batches go through a buffer object (or
+			 *	client-side arrays)
+			 */
+			inline bool usesBufferObject() const
+			{
+				return useBufferObject_;
+			}
+
+			/**	Reports whether the instances of unit and baked meshes are drawn
+			 *	by instancing (or expanded on the CPU)
+			 */
+			inline bool usesInstancing() const
+			{
+				return useInstancing_;
+			}
+
+			/**	Selects whether basic shapes are drawn from their distance
+			 *	function (if supported) or from their tessellation
+			 */
+			inline void setShapesEnabled(bool enabled)
+			{
+				shapesEnabled_ = enabled;
+			}
+
+			/**	Reports whether basic shapes are currently drawn from their
+			 *	distance function
+			 */
+			inline bool usesShapes() const
+			{
+				return useShapes_ && shapesEnabled_;
+			}
+
+			//	Disabled constructors & operators
+			BatchRenderer(const BatchRenderer&) = delete;
+			BatchRenderer& operator = (const BatchRenderer&) = delete;
+	};
+}
+
+#endif	//	BATCH_RENDERER_H
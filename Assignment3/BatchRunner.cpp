@@ -0,0 +1,76 @@
+//
+//  BatchRunner.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "BatchRunner.h"
+
+using namespace std;
+using namespace earshooter;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+BatchRunner::BatchRunner(unsigned int nbThreads)
+	:	nbThreads_(nbThreads > 0 ? nbThreads : max(1u, thread::hardware_concurrency()))
+{
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Running a batch
+//--------------------------------------
+#endif
+
+double BatchRunner::run(vector<unique_ptr<Simulation>>& simulations, int nbSteps, float dt) const
+{
+	return runTasks_(simulations.size(), [&simulations, nbSteps, dt](size_t k)
+	{
+		Simulation& simulation = *simulations[k];
+		for (int step = 0; step < nbSteps; step++)
+			simulation.step(dt);
+	});
+}
+
+double BatchRunner::run(vector<unique_ptr<WorldBatch>>& batches, int nbSteps, float dt) const
+{
+	return runTasks_(batches.size(), [&batches, nbSteps, dt](size_t k)
+	{
+		WorldBatch& batch = *batches[k];
+		for (int step = 0; step < nbSteps; step++)
+			batch.step(dt);
+	});
+}
+
+double BatchRunner::runTasks_(size_t nbTasks, const function<void(size_t)>& task) const
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	atomic<size_t> nextTask(0);
+	auto work = [nbTasks, &task, &nextTask]()
+	{
+		for (size_t k = nextTask.fetch_add(1, memory_order_relaxed); k < nbTasks;
+			 k = nextTask.fetch_add(1, memory_order_relaxed))
+			task(k);
+	};
+
+	//	no more workers than tasks; this thread is one of them
+	unsigned int nbWorkers = static_cast<unsigned int>(min<size_t>(nbThreads_, nbTasks));
+	vector<thread> worker;
+	for (unsigned int k = 1; k < nbWorkers; k++)
+		worker.emplace_back(work);
+	work();
+	for (thread& t : worker)
+		t.join();
+
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,74 @@
+//
+//  BatchRunner.h
+//  Week 08 - Earshooter
+//
+//	Steps a batch of independent simulations (parameter sweeps, Monte-Carlo
+//	balance tests) in one process, on a pool of worker threads.  The worlds
+//	share nothing, so no lock is needed: each worker takes the next world
+//	not yet started, runs all of its steps (its objects stay in that core's
+//	cache), then takes another one, until the batch is done.  Which thread
+//	runs a world doesn't change its results, only its seed does.
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "Simulation.h"
+#include "WorldBatch.h"
+
+namespace earshooter
+{
+	class BatchRunner
+	{
+		private:
+
+			unsigned int nbThreads_;
+
+			/**	Runs tasks 0 to nbTasks-1 on the workers, each one taking the
+			 *	next task not yet started
+			 *	@RETURN	the (wall clock) duration of the batch, in s
+			 */
+			double runTasks_(size_t nbTasks, const std::function<void(size_t)>& task) const;
+
+		public:
+
+			/**	Creates a runner
+			 *	@PARAM nbThreads	number of worker threads (0: one per hardware thread)
+			 */
+			explicit BatchRunner(unsigned int nbThreads = 0);
+
+			~BatchRunner() = default;
+
+			/**	Runs the same number of steps on each simulation of a batch,
+			 *	and returns when they are all done
+			 *	@PARAM simulations	the simulations to run
+			 *	@PARAM nbSteps		number of steps run on each simulation
+			 *	@PARAM dt			duration of a step (in s)
+			 *	@RETURN	the (wall clock) duration of the batch, in s
+			 */
+			double run(std::vector<std::unique_ptr<Simulation>>& simulations, int nbSteps,
+					   float dt) const;
+
+			/**	Same, for batches of worlds stepped in SIMD lanes (one
+			 *	WorldBatch per task)
+			 */
+			double run(std::vector<std::unique_ptr<WorldBatch>>& batches, int nbSteps,
+					   float dt) const;
+
+			inline unsigned int getThreadCount() const
+			{
+				return nbThreads_;
+			}
+
+			//	Disabled constructors & operators
+			BatchRunner(const BatchRunner&) = delete;
+			BatchRunner(BatchRunner&&) = delete;
+			BatchRunner& operator =(const BatchRunner&) = delete;
+			BatchRunner& operator =(BatchRunner&&) = delete;
+	};
+}
+
+#endif	//	BATCH_RUNNER_H
@@ -4,7 +4,6 @@
 
 #include <iostream>
 #include <cfloat>
-#include "glPlatform.h"
 #include "BoundingBox.h"
 
 using namespace earshooter;
@@ -60,18 +59,11 @@ void BoundingBox::setDimensions(const WorldPoint& cornerUL, const WorldPoint& co
 	ymax_ = cornerUL.y;
 }
 
-void BoundingBox::draw(void) const
+void BoundingBox::draw(Renderer2D& renderer, const Transform2D& transform) const
 {
- 	glPushMatrix();
-	glLineWidth(1.f);
-	glColor4fv(COLOR[static_cast<int>(color_)]);
-	glBegin(GL_LINE_LOOP);
-		glVertex2f(xmin_, ymin_);
-		glVertex2f(xmax_, ymin_);
-		glVertex2f(xmax_, ymax_);
-		glVertex2f(xmin_, ymax_);
-	glEnd();
-	glPopMatrix();
+	const float* color = COLOR[static_cast<int>(color_)];
+	const float corner[4][2] = {{xmin_, ymin_}, {xmax_, ymin_}, {xmax_, ymax_}, {xmin_, ymax_}};
+	renderer.addLineLoop(RenderBatch::DEBUG, transform, corner, 4, color[0], color[1], color[2]);
 }
 
 bool BoundingBox::intersects(const BoundingBox& other) const {
@@ -7,6 +7,8 @@
 
 #include "commonTypes.h"
 #include "World2D.h"
+#include "Renderer2D.h"
+#include "MemoryTracker.h"
 
 namespace earshooter
 {
@@ -20,6 +22,19 @@ namespace earshooter
 			static bool drawAbsoluteBoxes_;
 	
 		public:
+
+			/**	Bounding boxes are charged to the memory category of the
+			 *	object being built (see MemoryScope).
+			 */
+			static inline void* operator new(std::size_t bytes)
+			{
+				return MemoryTracker::allocate(bytes);
+			}
+
+			static inline void operator delete(void* ptr)
+			{
+				MemoryTracker::deallocate(ptr);
+			}
 		
 			bool intersects(const BoundingBox& other) const;
 
@@ -144,9 +159,11 @@ namespace earshooter
 				return isInside(pt.x, pt.y);
 			}
 		
-			/** Renders the object
+			/** Adds the contour of the box to the debug batch of a renderer
+			 *	@PARAM renderer		the renderer collecting the frame's geometry
+			 *	@PARAM transform	box to world transformation
 			 */
-			void draw() const;
+			void draw(Renderer2D& renderer, const Transform2D& transform) const;
 						
 			static bool boxesAreDrawn();
 			static bool relativeBoxesAreDrawn();
@@ -0,0 +1,76 @@
+//
+//  Camera2D.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include "Camera2D.h"
+
+using namespace std;
+using namespace earshooter;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+Camera2D::Camera2D(float width, float height)
+	:	cx_(0.f),
+		cy_(0.f),
+		width_(width),
+		height_(height)
+{
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Following an object
+//--------------------------------------
+#endif
+
+void Camera2D::follow(const World2D& world, float x, float y)
+{
+	bool wrapsX = world.getType() == WorldType::CYLINDER_WORLD ||
+				  world.getType() == WorldType::SPHERE_WORLD;
+	bool wrapsY = world.getType() == WorldType::SPHERE_WORLD;
+
+	//	along an edge that doesn't wrap around, the view stays within the
+	//	world (centered on it if it is the larger of the two)
+	if (wrapsX)
+		cx_ = x;
+	else if (width_ >= world.getWidth())
+		cx_ = 0.5f * (world.getXmin() + world.getXmax());
+	else
+		cx_ = min(max(x, world.getXmin() + 0.5f * width_), world.getXmax() - 0.5f * width_);
+
+	if (wrapsY)
+		cy_ = y;
+	else if (height_ >= world.getHeight())
+		cy_ = 0.5f * (world.getYmin() + world.getYmax());
+	else
+		cy_ = min(max(y, world.getYmin() + 0.5f * height_), world.getYmax() - 0.5f * height_);
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Conversions
+//--------------------------------------
+#endif
+
+WorldPoint Camera2D::pixelToWorld(float ix, float iy) const
+{
+	return WorldPoint{	getXmin() + ix*World2D::pixelToWorldRatio,
+						getYmax() - iy*World2D::pixelToWorldRatio
+					 };
+}
+
+PixelPoint Camera2D::worldToPixel(float wx, float wy) const
+{
+	return PixelPoint{	(wx - getXmin())*World2D::worldToPixelRatio,
+						(getYmax() - wy)*World2D::worldToPixelRatio
+					 };
+}
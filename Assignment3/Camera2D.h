@@ -0,0 +1,94 @@
+//
+//  Camera2D.h
+//  Week 08 - Earshooter
+//
+//	The part of a world that is in view: a rectangle of fixed size, that
+//	follows an object (the player's ship) through a world that may be much
+//	larger.  Where the world wraps around, the view crosses the edges
+//	freely; where it doesn't, the view stays within the world.
+//	The frames are drawn in view coordinates, with the center of the view at
+//	the origin, so that the projection never changes as the camera moves.
+
+#ifndef CAMERA_2D_H
+#define CAMERA_2D_H
+
+#include "World2D.h"
+
+namespace earshooter
+{
+	class Camera2D
+	{
+		private:
+
+			float cx_, cy_;
+			float width_, height_;
+
+		public:
+
+			/**	Creates a camera centered on the origin
+			 *	@PARAM width, height	dimensions of the view (in world units)
+			 */
+			Camera2D(float width, float height);
+
+			~Camera2D() = default;
+
+			/**	Centers the view on a point of a world, or as close to it as
+			 *	the edges of the world that don't wrap around allow
+			 *	@PARAM world	the world in view
+			 *	@PARAM x, y		the point to follow
+			 */
+			void follow(const World2D& world, float x, float y);
+
+			inline float getCenterX() const
+			{
+				return cx_;
+			}
+			inline float getCenterY() const
+			{
+				return cy_;
+			}
+			inline float getWidth() const
+			{
+				return width_;
+			}
+			inline float getHeight() const
+			{
+				return height_;
+			}
+			inline float getXmin() const
+			{
+				return cx_ - 0.5f * width_;
+			}
+			inline float getXmax() const
+			{
+				return cx_ + 0.5f * width_;
+			}
+			inline float getYmin() const
+			{
+				return cy_ - 0.5f * height_;
+			}
+			inline float getYmax() const
+			{
+				return cy_ + 0.5f * height_;
+			}
+
+			/**	Converts a position in the pane (in pixels, y pointing down)
+			 *	to world coordinates
+			 */
+			WorldPoint pixelToWorld(float ix, float iy) const;
+
+			/**	Converts a position in the world to pane coordinates (in
+			 *	pixels, y pointing down)
+			 */
+			PixelPoint worldToPixel(float wx, float wy) const;
+
+			//	Disabled constructors & operators
+			Camera2D() = delete;
+			Camera2D(const Camera2D&) = delete;
+			Camera2D(Camera2D&&) = delete;
+			Camera2D& operator =(const Camera2D&) = delete;
+			Camera2D& operator =(Camera2D&&) = delete;
+	};
+}
+
+#endif	//	CAMERA_2D_H
@@ -20,10 +20,19 @@ using namespace earshooter;
 
 #endif
 //	Prototypes for "file-level private" functions
-const int Ellipse2D::numCirclePts_ = 24;
-float** Ellipse2D::circlePts_;
-unsigned int Ellipse2D::count_ = 0;
-unsigned int Ellipse2D::liveCount_ = 0;
+const int Ellipse2D::lodNumPts_[Ellipse2D::NB_LOD_LEVELS] = {6, 12, 24, 48, 96};
+float (*Ellipse2D::lodPts_[Ellipse2D::NB_LOD_LEVELS])[2];
+const int Ellipse2D::DEFAULT_LOD_LEVEL = 2;
+const int Ellipse2D::numCirclePts_ = Ellipse2D::lodNumPts_[Ellipse2D::DEFAULT_LOD_LEVEL];
+float (*Ellipse2D::circlePts_)[2];
+atomic<unsigned int> Ellipse2D::count_(0);
+atomic<unsigned int> Ellipse2D::liveCount_(0);
+//	Largest number of points of an arc drawn by drawArc (a full turn at the
+//	finest level)
+const int MAX_ARC_PTS = 96;
+//	Largest distance (in pixels) between a chord and the arc of circle it
+//	replaces
+const float LOD_TOLERANCE = 0.5f;
 
 //	Ensures that the vertices defining ellipses' contours are initialized
 //	before action starts
@@ -44,6 +53,8 @@ Ellipse2D::Ellipse2D(float centerX, float centerY, float angle, float radiusX, f
 		radiusY_(radiusY),
 		index_(count_++)
 {
+	MemoryScope memoryScope(MemoryCategory::ELLIPSE);
+
 	liveCount_++;
 	
 	//	set the bounding boxes
@@ -93,35 +104,16 @@ Ellipse2D::~Ellipse2D()
 //-----------------------------------------
 #endif
 
-void Ellipse2D::draw_() const
+void Ellipse2D::draw_(Renderer2D& renderer, const Transform2D& transform) const
 {
 	float r = getR(), g = getG(), b = getB();
 	
-	//	save the current coordinate system (origin, axes)
-	glPushMatrix();
-	
 	//	apply the radius as a scale
-	glScalef(radiusX_, radiusY_, 1.f);
-	
-	glColor3f(r, g, b);
-	glBegin(GL_POLYGON);
-		for (int k=0; k<numCirclePts_; k++)
-			glVertex2f(circlePts_[k][0],
-						circlePts_[k][1]);
-	glEnd();
+	Transform2D scaled = transform.scaled(radiusX_, radiusY_);
 	
-	if (getDrawContour())
-	{
-		glColor3f(1.f - r, 1.f - g, 1.f - b);
-		glBegin(GL_LINE_LOOP);
-		for (int k=0; k<numCirclePts_; k++)
-			glVertex2f(circlePts_[k][0],
-						circlePts_[k][1]);
-		glEnd();
-	}
-
-	//	restore the original scale
-	glPopMatrix();
+	int level = getLodLevel_(scaled);
+	renderer.addShape(RenderBatch::ELLIPSE, scaled, UnitShape::DISK,
+					  lodPts_[level], lodNumPts_[level], getDrawContour(), r, g, b);
 }
 
 
@@ -138,25 +130,31 @@ bool Ellipse2D::isInside(float x, float y) const
 
 
 void Ellipse2D::updateAbsoluteBox_()
+{
+	BoundingBox box = computeAbsoluteBox(getX(), getY(), getAngle(), radiusX_, radiusY_);
+	setAbsoluteBoundingBox(box.getXmin(), box.getXmax(), box.getYmin(), box.getYmax());
+}
+
+BoundingBox Ellipse2D::computeAbsoluteBox(float cx, float cy, float angle,
+										  float radiusX, float radiusY)
 {
 	//	could definitely be optimized
-	float angle = M_PI*getAngle()/180.f;
-	float cx = getX(), cy = getY();
-	float cA = cosf(angle), sA = sinf(angle);
+	float radAngle = M_PI*angle/180.f;
+	float cA = cosf(radAngle), sA = sinf(radAngle);
 	//	parametric equation of the elipse in global reference frame
 	//		x(t) = cx + radiusX*cos(angle)*cos(t) - radiusY*sin(angle)*sin(t)
 	//		y(t) = cy + radiusX*cos(angle)*cos(t) - radiusY*sin(angle)*sin(t)
 	//	The x extrema are reached for +/-
-	float tx = atan2f(radiusY_*sA, -radiusX_*cA);
+	float tx = atan2f(radiusY*sA, -radiusX*cA);
 	float ctx = cosf(tx), stx = sinf(tx);
 	//	The y extrema are reached for +/-
-	float ty = atan2f(-radiusY_*cA, -radiusX_*sA);
+	float ty = atan2f(-radiusY*cA, -radiusX*sA);
 	float cty = cosf(ty), sty = sinf(ty);
 	//	Now we can compute the extremal displacements from the center
-	float dx = fabsf(radiusX_*cA*ctx - radiusY_*sA*stx),
-		  dy = fabsf(radiusX_*sA*cty + radiusY_*cA*sty);
+	float dx = fabsf(radiusX*cA*ctx - radiusY*sA*stx),
+		  dy = fabsf(radiusX*sA*cty + radiusY*cA*sty);
 	//	And compute the min and max
-	setAbsoluteBoundingBox(cx - dx, cx + dx, cy - dy, cy + dy);
+	return BoundingBox(cx - dx, cx + dx, cy - dy, cy + dy);
 }
 
 
@@ -192,42 +190,91 @@ unsigned int Ellipse2D::getLiveCount(void)
 // I want this code to run only once
 bool earshooter::initEllipseFunc()
 {
-	Ellipse2D::circlePts_ = new float*[Ellipse2D::numCirclePts_];
-	for (int k=0; k<Ellipse2D::numCirclePts_; k++)
-		Ellipse2D::circlePts_[k] = new float[2];
-		
-	//	Initialize the array of coordinates of the disk or radius 1 centered at (0, 0)
-	float angleStep = 2.f*M_PI/Ellipse2D::numCirclePts_;
-	for (int k=0; k<Ellipse2D::numCirclePts_; k++)
+	//	Initialize the arrays of coordinates of the disk or radius 1 centered at (0, 0),
+	//	one per tessellation level
+	for (int level=0; level<Ellipse2D::NB_LOD_LEVELS; level++)
 	{
-		float theta = k*angleStep;
-		Ellipse2D::circlePts_[k][0] = cosf(theta);
-		Ellipse2D::circlePts_[k][1] = sinf(theta);
+		int nbPts = Ellipse2D::lodNumPts_[level];
+		float (*pts)[2] = new float[nbPts][2];
+		float angleStep = 2.f*M_PI/nbPts;
+		for (int k=0; k<nbPts; k++)
+		{
+			float theta = k*angleStep;
+			pts[k][0] = cosf(theta);
+			pts[k][1] = sinf(theta);
+		}
+		Ellipse2D::lodPts_[level] = pts;
 	}
+	Ellipse2D::circlePts_ = Ellipse2D::lodPts_[Ellipse2D::DEFAULT_LOD_LEVEL];
 	return true;
 }
 
-void earshooter::drawDisk()
+void earshooter::drawDisk(Renderer2D& renderer, RenderBatch batch,
+						  const Transform2D& transform, float r, float g, float b)
+{
+	//	every disk is an instance of one of the unit circles
+	int level = Ellipse2D::getLodLevel_(transform);
+	renderer.addMeshFill(batch, transform, Ellipse2D::lodPts_[level], Ellipse2D::lodNumPts_[level],
+						 r, g, b);
+}
+
+void earshooter::drawArc(Renderer2D& renderer, RenderBatch batch,
+						 const Transform2D& transform, float r, float g, float b,
+						 float startFrac, float endFrac)
+{
+	float arcPts[MAX_ARC_PTS][2];
+	int nbPts = Ellipse2D::getArcPoints_(Ellipse2D::getLodLevel_(transform),
+										 startFrac, endFrac, arcPts);
+	renderer.addLineStrip(batch, transform, arcPts, nbPts, r, g, b);
+}
+
+void earshooter::drawDisk(BatchMesh& mesh, const Transform2D& transform,
+						  float r, float g, float b, float tint)
+{
+	mesh.addPolygon(transform, Ellipse2D::circlePts_, Ellipse2D::numCirclePts_, r, g, b, tint);
+}
+
+void earshooter::drawArc(BatchMesh& mesh, const Transform2D& transform,
+						 float r, float g, float b, float tint,
+						 float startFrac, float endFrac)
+{
+	float arcPts[MAX_ARC_PTS][2];
+	int nbPts = Ellipse2D::getArcPoints_(Ellipse2D::DEFAULT_LOD_LEVEL, startFrac, endFrac, arcPts);
+	mesh.addLineStrip(transform, arcPts, nbPts, r, g, b, tint);
+}
+
+int Ellipse2D::getLodLevel_(const Transform2D& transform)
 {
-	glBegin(GL_POLYGON);
-			for (int k=0; k<Ellipse2D::numCirclePts_; k++)
-				glVertex2fv(Ellipse2D::circlePts_[k]);
-	glEnd();
+	//	on-screen radius: the longer of the images of the two unit axes
+	float radius = World2D::worldToPixelRatio *
+					sqrtf(max(transform.a*transform.a + transform.b*transform.b,
+							  transform.c*transform.c + transform.d*transform.d));
+	//	A chord spanning an angle 2*pi/n strays from the arc by about
+	//	radius*(pi/n)^2/2, hence the n required for the tolerance
+	float minNbPts = static_cast<float>(M_PI) * sqrtf(0.5f * radius / LOD_TOLERANCE);
+	int level = 0;
+	while (level < NB_LOD_LEVELS-1 && lodNumPts_[level] < minNbPts)
+		level++;
+	return level;
 }
 
-void earshooter::drawArc(float startFrac, float endFrac)
+int Ellipse2D::getArcPoints_(int level, float startFrac, float endFrac, float (*arcPts)[2])
 {
+	int nbPts = 0;
 	if ((startFrac < endFrac) && (startFrac > -100) && (endFrac < +100))
 	{
-		int startIndex = static_cast<int>(roundf(startFrac*(Ellipse2D::numCirclePts_-1)));
-		int endIndex = static_cast<int>(roundf(endFrac*(Ellipse2D::numCirclePts_-1)));
+		int numPts = lodNumPts_[level];
+		const float (*pts)[2] = lodPts_[level];
+		int startIndex = static_cast<int>(roundf(startFrac*(numPts-1)));
+		int endIndex = static_cast<int>(roundf(endFrac*(numPts-1)));
 		
-		glBegin(GL_LINE_STRIP);
-			for (int k=startIndex; k<=endIndex; k++)
-			{
-				int index = k < 0 ? k + Ellipse2D::numCirclePts_ : k;
-				glVertex2fv(Ellipse2D::circlePts_[index]);
-			}
-		glEnd();
+		for (int k=startIndex; k<=endIndex && nbPts<MAX_ARC_PTS; k++)
+		{
+			int index = k < 0 ? k + numPts : k;
+			arcPts[nbPts][0] = pts[index][0];
+			arcPts[nbPts][1] = pts[index][1];
+			nbPts++;
+		}
 	}
+	return nbPts;
 }
@@ -14,8 +14,16 @@ namespace earshooter
 	class Ellipse2D : public GraphicObject2D
 	{
 		friend bool initEllipseFunc();
-		friend void drawDisk();
-		friend void drawArc(float startFrac, float endFrac);
+		friend void drawDisk(Renderer2D& renderer, RenderBatch batch,
+							 const Transform2D& transform, float r, float g, float b);
+		friend void drawArc(Renderer2D& renderer, RenderBatch batch,
+							const Transform2D& transform, float r, float g, float b,
+							float startFrac, float endFrac);
+		friend void drawDisk(BatchMesh& mesh, const Transform2D& transform,
+							 float r, float g, float b, float tint);
+		friend void drawArc(BatchMesh& mesh, const Transform2D& transform,
+							float r, float g, float b, float tint,
+							float startFrac, float endFrac);
 		
 		private:
 		
@@ -25,22 +33,48 @@ namespace earshooter
 			 */
 			unsigned int index_;
 			
+			/**	Tessellation levels of the unit circle, from coarsest to finest.
+			 *	Each level has its own precomputed table of points.
+			 */
+			static const int NB_LOD_LEVELS = 5;
+			static const int lodNumPts_[NB_LOD_LEVELS];
+			static float (*lodPts_[NB_LOD_LEVELS])[2];
+
+			/**	Level used when the on-screen size is unknown (baked meshes)
+			 */
+			static const int DEFAULT_LOD_LEVEL;
 			static const int numCirclePts_;
-			static float** circlePts_;
+			static float (*circlePts_)[2];
+
+			/**	Picks the coarsest tessellation level whose chords stay within
+			 *	half a pixel of the curve, from the on-screen radius of the
+			 *	unit circle once transformed
+			 *	@PARAM transform	unit circle to world transformation
+			 *	@RETURN	the index of the level
+			 */
+			static int getLodLevel_(const Transform2D& transform);
+
+			/**	Collects the points of the unit circle between two fractions
+			 *	of a turn (indices may wrap around)
+			 *	@PARAM level	tessellation level of the points
+			 *	@PARAM arcPts	receives the points (MAX_ARC_PTS at most)
+			 *	@RETURN	the number of points of the arc
+			 */
+			static int getArcPoints_(int level, float startFrac, float endFrac, float (*arcPts)[2]);
 
 			/**	Counter of the number of Ellipse2D objects created
 			 */
-			static unsigned int count_;
+			static std::atomic<unsigned int> count_;
 
 			/**	Counter of the number of Ellipse2D objects still "alive"
 			 */
-			static unsigned int liveCount_;
+			static std::atomic<unsigned int> liveCount_;
 
 			/**	Private rendering function for this class.  Translation and rotation
 			 *	have already been applied by the root class, so this function only applies
 			 *	scaling prior to rendering.
 			 */
-			void draw_() const override;
+			void draw_(Renderer2D& renderer, const Transform2D& transform) const override;
 
 			/** Update the object's absolute bounding box
 			 */
@@ -131,6 +165,18 @@ namespace earshooter
 			 */
 			bool isInside(float x, float y) const override;
 
+			/** Computes the absolute bounding box of an ellipse in a given pose
+			 *	(the one updateAbsoluteBox_ sets, also used by WorldBatch)
+			 *	@PARAM cx	x coordinate of the center of the ellipse
+			 *	@PARAM cy	y coordinate of the center of the ellipse
+			 *	@PARAM angle	orientation of the ellipse (in degree)
+			 *	@PARAM radiusX x radius of the ellipse
+			 *	@PARAM radiusY y radius of the ellipse
+			 *	@RETURN the box of the ellipse
+			 */
+			static BoundingBox computeAbsoluteBox(float cx, float cy, float angle,
+												  float radiusX, float radiusY);
+
 			/** Returns this ellipse's unique Ellipse2D creation index
 			 *	@RETURN this ellipse's unique SmilingFace creation index
 			 */
@@ -159,9 +205,14 @@ namespace earshooter
 	 */
 	bool initEllipseFunc();
 	
-	/** Free function that draws a colored disk
+	/** Free function that adds a colored disk of radius 1 to a batch
+	 *	@PARAM renderer		the renderer collecting the frame's geometry
+	 *	@PARAM batch		the batch the disk belongs to
+	 *	@PARAM transform	local to world transformation of the disk
+	 *	@PARAM r, g, b		color of the disk
      */
-	void drawDisk();
+	void drawDisk(Renderer2D& renderer, RenderBatch batch,
+				  const Transform2D& transform, float r, float g, float b);
 	
 	/** Free function that draws an arc of a circle from a start fraction to
 	 *	an end fraction (0 --> angle 0, 1.0 --> angle 360).  This is a very crude,
@@ -169,7 +220,25 @@ namespace earshooter
 	 *	@PARAM startFrac start fraction in range [0, 1]
 	 *	@PARAM endFrac end fraction in range [startFrac, 1]
 	 */
-	void drawArc(float startFrac, float endFrac);
+	void drawArc(Renderer2D& renderer, RenderBatch batch,
+				 const Transform2D& transform, float r, float g, float b,
+				 float startFrac, float endFrac);
+
+	/** Free function that bakes a disk of radius 1 into a composite mesh
+	 *	@PARAM mesh			the mesh being built
+	 *	@PARAM transform	disk to mesh transformation
+	 *	@PARAM r, g, b		fixed part of the color of the disk
+	 *	@PARAM tint			weight of the color of the instance
+	 */
+	void drawDisk(BatchMesh& mesh, const Transform2D& transform,
+				  float r, float g, float b, float tint);
+
+	/** Free function that bakes an arc of a circle into a composite mesh
+	 *	@see drawArc(Renderer2D&, ...)
+	 */
+	void drawArc(BatchMesh& mesh, const Transform2D& transform,
+				 float r, float g, float b, float tint,
+				 float startFrac, float endFrac);
 
 }
 
@@ -0,0 +1,368 @@
+//
+//  FrameCapture.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cstring>
+#include <iostream>
+#include "glPlatform.h"
+#include "FrameCapture.h"
+
+using namespace std;
+using namespace earshooter;
+
+//	Nominal frame rate written in the header of a .y4m stream
+const int Y4M_FRAME_RATE = 60;
+
+bool hasSuffix(const string& str, const string& suffix);
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+FrameCapture::FrameCapture()
+	:	segment_(0),
+		isY4M_(true),
+		file_(nullptr),
+		width_(0),
+		height_(0),
+		running_(false),
+		nextBuffer_(0),
+		stopWriter_(false),
+		nbCaptured_(0),
+		nbDropped_(0),
+		nbWritten_(0),
+		writeFailed_(false)
+{
+	for (int k = 0; k < NB_PIXEL_BUFFERS; k++)
+	{
+		pixelBuffer_[k] = 0;
+		isPending_[k] = false;
+	}
+}
+
+FrameCapture::~FrameCapture()
+{
+	//	The GL context may be gone by the time global objects are destroyed:
+	//	only the writer is finished here.
+	finishWriter_();
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Capture control
+//--------------------------------------
+#endif
+
+bool FrameCapture::start(const string& path, int width, int height)
+{
+	if (running_)
+		return false;
+
+	basePath_ = path;
+	segment_ = 0;
+	return open_(path, width, height);
+}
+
+bool FrameCapture::open_(const string& path, int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return false;
+
+	path_ = path;
+	isY4M_ = !hasSuffix(path, ".ppm");
+	width_ = width;
+	height_ = height;
+	if (isY4M_)
+	{
+		file_ = fopen(path.c_str(), "wb");
+		if (file_ == nullptr)
+		{
+			cerr << "Could not open capture file " << path << endl;
+			return false;
+		}
+		fprintf(file_, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, Y4M_FRAME_RATE);
+	}
+
+	size_t frameBytes = 4 * static_cast<size_t>(width) * height;
+	freeFrame_.clear();
+	queue_.clear();
+	for (int k = 0; k < MAX_QUEUED_FRAMES; k++)
+	{
+		frame_[k].rgba.resize(frameBytes);
+		freeFrame_.push_back(frame_ + k);
+	}
+
+	GLuint bufferID[NB_PIXEL_BUFFERS];
+	glGenBuffers(NB_PIXEL_BUFFERS, bufferID);
+	for (int k = 0; k < NB_PIXEL_BUFFERS; k++)
+	{
+		pixelBuffer_[k] = bufferID[k];
+		isPending_[k] = false;
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, bufferID[k]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, frameBytes, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	nextBuffer_ = 0;
+
+	nbCaptured_ = 0;
+	nbDropped_ = 0;
+	nbWritten_ = 0;
+	writeFailed_ = false;
+	stopWriter_ = false;
+	writer_ = thread(&FrameCapture::writerLoop_, this);
+	running_ = true;
+	cout << "Frame capture started (" << width << "x" << height << ") to " << path << endl;
+	return true;
+}
+
+void FrameCapture::captureFrame(int width, int height)
+{
+	if (!running_)
+		return;
+	//	a minimized window has nothing to capture
+	if (width <= 0 || height <= 0)
+	{
+		nbDropped_++;
+		return;
+	}
+	//	The frames in flight have the old size: finish the output with them
+	if (width != width_ || height != height_)
+	{
+		stop();
+		segment_++;
+		if (!open_(getSegmentPath_(), width, height))
+			return;
+	}
+
+	//	The oldest buffer of the ring was read back NB_PIXEL_BUFFERS frames
+	//	ago: its pixels should be there by now.
+	if (isPending_[nextBuffer_])
+		collect_(nextBuffer_);
+
+	//	Reading into a bound pack buffer only queues the transfer
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer_[nextBuffer_]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	isPending_[nextBuffer_] = true;
+	nbCaptured_++;
+	nextBuffer_ = (nextBuffer_ + 1) % NB_PIXEL_BUFFERS;
+}
+
+string FrameCapture::getSegmentPath_() const
+{
+	if (segment_ == 0)
+		return basePath_;
+
+	//	the number goes before the extension, if there is one
+	size_t dot = basePath_.rfind('.');
+	size_t slash = basePath_.find_last_of("/\\");
+	if (dot == string::npos || (slash != string::npos && dot < slash))
+		dot = basePath_.size();
+	return basePath_.substr(0, dot) + "_" + to_string(segment_) + basePath_.substr(dot);
+}
+
+void FrameCapture::collect_(int buffer)
+{
+	isPending_[buffer] = false;
+
+	Frame* frame = nullptr;
+	{
+		lock_guard<mutex> guard(lock_);
+		if (!freeFrame_.empty())
+		{
+			frame = freeFrame_.back();
+			freeFrame_.pop_back();
+		}
+	}
+	//	The writer can't keep up: drop the frame without even mapping it
+	if (frame == nullptr)
+	{
+		nbDropped_++;
+		return;
+	}
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer_[buffer]);
+	const void* pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if (pixels != nullptr)
+	{
+		memcpy(frame->rgba.data(), pixels, frame->rgba.size());
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	{
+		lock_guard<mutex> guard(lock_);
+		if (pixels != nullptr)
+			queue_.push_back(frame);
+		else
+		{
+			freeFrame_.push_back(frame);
+			nbDropped_++;
+		}
+	}
+	wake_.notify_one();
+}
+
+void FrameCapture::stop()
+{
+	if (!running_)
+		return;
+
+	//	Collect the frames still in flight, oldest first
+	for (int k = 0; k < NB_PIXEL_BUFFERS; k++)
+	{
+		int buffer = (nextBuffer_ + k) % NB_PIXEL_BUFFERS;
+		if (isPending_[buffer])
+		{
+			//	wait for room in the pool rather than drop the last frames
+			while (true)
+			{
+				{
+					lock_guard<mutex> guard(lock_);
+					if (!freeFrame_.empty())
+						break;
+				}
+				this_thread::yield();
+			}
+			collect_(buffer);
+		}
+	}
+
+	GLuint bufferID[NB_PIXEL_BUFFERS];
+	for (int k = 0; k < NB_PIXEL_BUFFERS; k++)
+		bufferID[k] = pixelBuffer_[k];
+	glDeleteBuffers(NB_PIXEL_BUFFERS, bufferID);
+
+	finishWriter_();
+	cout << "Frame capture stopped: " << nbWritten_ << " frames written to " << path_
+		 << ", " << nbDropped_ << " dropped" << endl;
+}
+
+void FrameCapture::finishWriter_()
+{
+	if (!writer_.joinable())
+		return;
+
+	{
+		lock_guard<mutex> guard(lock_);
+		stopWriter_ = true;
+	}
+	wake_.notify_one();
+	writer_.join();
+
+	if (file_ != nullptr)
+	{
+		fclose(file_);
+		file_ = nullptr;
+	}
+	running_ = false;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Writer thread
+//--------------------------------------
+#endif
+
+void FrameCapture::writerLoop_()
+{
+	vector<uint8_t> scratch;
+	while (true)
+	{
+		Frame* frame;
+		{
+			unique_lock<mutex> guard(lock_);
+			wake_.wait(guard, [this]{ return stopWriter_ || !queue_.empty(); });
+			if (queue_.empty())
+				return;
+			frame = queue_.front();
+			queue_.pop_front();
+		}
+
+		if (!writeFailed_)
+		{
+			if (writeFrame_(*frame, scratch))
+				nbWritten_++;
+			else
+			{
+				cerr << "Could not write captured frame " << nbWritten_ << " to " << path_ << endl;
+				writeFailed_ = true;
+			}
+		}
+
+		lock_guard<mutex> guard(lock_);
+		freeFrame_.push_back(frame);
+	}
+}
+
+bool FrameCapture::writeFrame_(const Frame& frame, vector<uint8_t>& scratch)
+{
+	//	OpenGL rows go bottom to top, image rows top to bottom
+	const size_t nbPixels = static_cast<size_t>(width_) * height_;
+	const uint8_t* rgba = frame.rgba.data();
+	if (isY4M_)
+	{
+		//	Planar Y, Cb, Cr (BT.601, video range), one sample of each per pixel
+		scratch.resize(3 * nbPixels);
+		uint8_t* y = scratch.data();
+		uint8_t* cb = y + nbPixels;
+		uint8_t* cr = cb + nbPixels;
+		for (int row = 0; row < height_; row++)
+		{
+			const uint8_t* src = rgba + 4 * static_cast<size_t>(height_ - 1 - row) * width_;
+			for (int col = 0; col < width_; col++, src += 4)
+			{
+				int r = src[0], g = src[1], b = src[2];
+				*y++ = static_cast<uint8_t>(((66*r + 129*g + 25*b + 128) >> 8) + 16);
+				*cb++ = static_cast<uint8_t>(((-38*r - 74*g + 112*b + 128) >> 8) + 128);
+				*cr++ = static_cast<uint8_t>(((112*r - 94*g - 18*b + 128) >> 8) + 128);
+			}
+		}
+		return fputs("FRAME\n", file_) >= 0 &&
+			   fwrite(scratch.data(), 1, scratch.size(), file_) == scratch.size();
+	}
+
+	scratch.resize(3 * nbPixels);
+	uint8_t* rgb = scratch.data();
+	for (int row = 0; row < height_; row++)
+	{
+		const uint8_t* src = rgba + 4 * static_cast<size_t>(height_ - 1 - row) * width_;
+		for (int col = 0; col < width_; col++, src += 4)
+		{
+			*rgb++ = src[0];
+			*rgb++ = src[1];
+			*rgb++ = src[2];
+		}
+	}
+
+	//	path_00000.ppm, path_00001.ppm, ...
+	char index[16];
+	snprintf(index, sizeof(index), "_%05llu", static_cast<unsigned long long>(nbWritten_));
+	string framePath = path_.substr(0, path_.size() - 4) + index + ".ppm";
+	FILE* file = fopen(framePath.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+	fprintf(file, "P6\n%d %d\n255\n", width_, height_);
+	bool written = fwrite(scratch.data(), 1, scratch.size(), file) == scratch.size();
+	return (fclose(file) == 0) && written;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Free functions
+//--------------------------------------
+#endif
+
+bool hasSuffix(const string& str, const string& suffix)
+{
+	return str.size() >= suffix.size() &&
+		   str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
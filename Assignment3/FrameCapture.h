@@ -0,0 +1,156 @@
+//
+//  FrameCapture.h
+//  Week 08 - Earshooter
+//
+//	Records the frames presented in the window to disk, without stalling
+//	the rendering.  Each frame is read back into one of a ring of pixel
+//	buffer objects: glReadPixels then returns immediately, and the pixels
+//	are only mapped a few frames later, once the GPU is done with them.
+//	They are copied into a frame of a fixed pool and queued for a writer
+//	thread, which converts them and streams them to a YUV4MPEG2 (.y4m) file
+//	or to a sequence of PPM images.  When the writer falls behind and the
+//	queue is full, the new frames are dropped (and counted) rather than
+//	blocking the rendering thread.  When the window is resized, the output
+//	is finished at the old size, and the capture goes on in a new one, at
+//	the new size.
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace earshooter
+{
+	class FrameCapture
+	{
+		private:
+
+			/**	Number of pixel buffers in the ring, i.e., of frames between
+			 *	the read back of a frame and the mapping of its pixels
+			 */
+			static const int NB_PIXEL_BUFFERS = 3;
+
+			/**	Number of frames in the pool: the longest the queue can get
+			 */
+			static const int MAX_QUEUED_FRAMES = 8;
+
+			/**	Pixels of a read back frame, RGBA, bottom row first
+			 */
+			struct Frame
+			{
+				std::vector<uint8_t> rgba;
+			};
+
+			std::string path_;
+			std::string basePath_;		//	path given to start
+			int segment_;				//	number of resizes since start
+			bool isY4M_;
+			FILE* file_;
+			int width_, height_;
+			bool running_;
+
+			//	ring of pixel buffers, owned by the thread of the GL context
+			unsigned int pixelBuffer_[NB_PIXEL_BUFFERS];
+			bool isPending_[NB_PIXEL_BUFFERS];
+			int nextBuffer_;
+
+			//	shared with the writer thread
+			std::mutex lock_;
+			std::condition_variable wake_;
+			Frame frame_[MAX_QUEUED_FRAMES];
+			std::vector<Frame*> freeFrame_;
+			std::deque<Frame*> queue_;
+			bool stopWriter_;
+			std::thread writer_;
+
+			uint64_t nbCaptured_;
+			uint64_t nbDropped_;
+			uint64_t nbWritten_;		//	only touched by the writer thread
+			bool writeFailed_;			//	only touched by the writer thread
+
+			/**	Opens an output of the given size and starts the writer thread
+			 */
+			bool open_(const std::string& path, int width, int height);
+
+			/**	Path of the current segment: the base path, then path_1.y4m,
+			 *	path_2.y4m, ... (path_1.ppm, ... for a sequence of images)
+			 */
+			std::string getSegmentPath_() const;
+
+			/**	Maps a pixel buffer and queues a copy of its pixels, or drops
+			 *	them if no frame of the pool is free
+			 */
+			void collect_(int buffer);
+
+			/**	Body of the writer thread: writes the queued frames until
+			 *	asked to stop, and the queue is empty
+			 */
+			void writerLoop_();
+
+			bool writeFrame_(const Frame& frame, std::vector<uint8_t>& scratch);
+
+			/**	Lets the writer thread write the frames still queued, then
+			 *	closes the file.  Doesn't need the GL context.
+			 */
+			void finishWriter_();
+
+		public:
+
+			FrameCapture();
+
+			/**	Finishes writing the frames already queued (the ones still in
+			 *	pixel buffers are lost if stop wasn't called)
+			 */
+			~FrameCapture();
+
+			/**	Opens the output and starts the writer thread.  Must be called
+			 *	from the thread of the GL context.
+			 *	@PARAM path		output file: a path ending in ".ppm" gives a
+			 *					sequence of images (path_00000.ppm, ...), any
+			 *					other path a single .y4m stream
+			 *	@PARAM width	width of the frames, in pixels
+			 *	@PARAM height	height of the frames, in pixels
+			 *	@RETURN	true if the capture started
+			 */
+			bool start(const std::string& path, int width, int height);
+
+			/**	Starts the read back of the frame just drawn in the back
+			 *	buffer, and queues the pixels of the frame read back
+			 *	NB_PIXEL_BUFFERS frames ago.  To be called before the buffers
+			 *	are swapped.  If the window was resized, the output is closed
+			 *	and the capture restarts in a new one, at the new size.
+			 *	@PARAM width	current width of the window, in pixels
+			 *	@PARAM height	current height of the window, in pixels
+			 */
+			void captureFrame(int width, int height);
+
+			/**	Queues the frames still in pixel buffers, waits for the writer
+			 *	to write all of them, and closes the output.  Must be called
+			 *	from the thread of the GL context.
+			 */
+			void stop();
+
+			inline bool isRunning() const
+			{
+				return running_;
+			}
+
+			inline const std::string& getPath() const
+			{
+				return path_;
+			}
+
+			//	Disabled constructors & operators
+			FrameCapture(const FrameCapture&) = delete;
+			FrameCapture& operator = (const FrameCapture&) = delete;
+	};
+}
+
+#endif	//	FRAME_CAPTURE_H
@@ -0,0 +1,195 @@
+//
+//  FrameScheduler.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include "FrameScheduler.h"
+
+using namespace std;
+using namespace earshooter;
+
+const float FrameScheduler::HEADROOM = 0.1f;
+const float FrameScheduler::SMOOTHING = 0.1f;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+FrameScheduler::FrameScheduler(float stepDuration, float frameBudget,
+							   float maxFrameInterval, int maxStepsPerTick)
+	:	stepDuration_(stepDuration),
+		frameBudget_(frameBudget),
+		maxFrameInterval_(max(maxFrameInterval, frameBudget)),
+		maxStepsPerTick_(max(maxStepsPerTick, 1)),
+		accumulator_(0.f),
+		lastTick_(Clock::now()),
+		lastRender_(lastTick_),
+		clockStarted_(false),
+		stepCost_(0.f),
+		renderCost_(0.f),
+		renderInterval_(frameBudget),
+		windowStart_(lastTick_),
+		windowSteps_(0),
+		windowFrames_(0),
+		windowDropped_(0.f),
+		stepsPerSecond_(0.f),
+		framesPerSecond_(0.f),
+		simSpeed_(1.f),
+		behind_(false)
+{
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Scheduling
+//--------------------------------------
+#endif
+
+int FrameScheduler::beginTick()
+{
+	lock_guard<mutex> guard(lock_);
+	Clock::time_point now = Clock::now();
+	if (!clockStarted_)
+	{
+		lastTick_ = now;
+		clockStarted_ = true;
+	}
+	accumulator_ += chrono::duration<float>(now - lastTick_).count();
+	lastTick_ = now;
+
+	//	Don't let a heartbeat run for so long that no frame could be rendered
+	//	within the longest interval allowed.
+	int maxSteps = maxStepsPerTick_;
+	if (stepCost_ > 0.f)
+	{
+		float simBudget = max(maxFrameInterval_ - renderCost_, stepDuration_);
+		maxSteps = min(maxSteps, max(1, static_cast<int>(simBudget / stepCost_)));
+	}
+
+	int nbSteps = static_cast<int>(accumulator_ / stepDuration_);
+	if (nbSteps > maxSteps)
+	{
+		//	The simulation cannot catch up: drop the time we won't simulate
+		//	rather than carry an ever-growing debt into the next heartbeat.
+		float dropped = accumulator_ - maxSteps * stepDuration_;
+		windowDropped_ += dropped;
+		nbSteps = maxSteps;
+	}
+	accumulator_ -= nbSteps * stepDuration_;
+	windowSteps_ += nbSteps;
+
+	if (now - windowStart_ >= chrono::seconds(1))
+		closeWindow_(now);
+
+	return nbSteps;
+}
+
+void FrameScheduler::endTick(int nbSteps, uint64_t ns)
+{
+	if (nbSteps <= 0)
+		return;
+
+	lock_guard<mutex> guard(lock_);
+	float cost = 1.e-9f * ns / nbSteps;
+	stepCost_ = (stepCost_ == 0.f) ? cost : stepCost_ + SMOOTHING * (cost - stepCost_);
+	updateRenderInterval_();
+}
+
+bool FrameScheduler::shouldRender()
+{
+	lock_guard<mutex> guard(lock_);
+	Clock::time_point now = Clock::now();
+	if (chrono::duration<float>(now - lastRender_).count() < renderInterval_)
+		return false;
+
+	lastRender_ = now;
+	return true;
+}
+
+void FrameScheduler::recordRenderCost(uint64_t ns)
+{
+	lock_guard<mutex> guard(lock_);
+	float cost = 1.e-9f * ns;
+	renderCost_ = (renderCost_ == 0.f) ? cost : renderCost_ + SMOOTHING * (cost - renderCost_);
+	windowFrames_++;
+	updateRenderInterval_();
+}
+
+void FrameScheduler::restartClock()
+{
+	lock_guard<mutex> guard(lock_);
+	clockStarted_ = false;
+	accumulator_ = 0.f;
+}
+
+void FrameScheduler::setFrameBudget(float frameBudget)
+{
+	lock_guard<mutex> guard(lock_);
+	frameBudget_ = frameBudget;
+	maxFrameInterval_ = max(maxFrameInterval_, frameBudget);
+	updateRenderInterval_();
+}
+
+void FrameScheduler::updateRenderInterval_()
+{
+	//	Fraction of the CPU time that the simulation needs to keep real time,
+	//	and what remains for rendering.  The render interval is the shortest
+	//	one (no shorter than the frame budget) at which the frames fit in
+	//	that remainder.
+	float simLoad = stepCost_ / stepDuration_;
+	float available = 1.f - HEADROOM - simLoad;
+	if (available * maxFrameInterval_ <= renderCost_)
+		renderInterval_ = maxFrameInterval_;
+	else
+		renderInterval_ = min(max(renderCost_ / available, frameBudget_), maxFrameInterval_);
+}
+
+void FrameScheduler::closeWindow_(Clock::time_point now)
+{
+	float duration = chrono::duration<float>(now - windowStart_).count();
+	stepsPerSecond_ = windowSteps_ / duration;
+	framesPerSecond_ = windowFrames_ / duration;
+	simSpeed_ = windowSteps_ * stepDuration_ / duration;
+
+	bool behind = windowDropped_ > 0.f;
+	if (behind && !behind_)
+		cout << "Simulation cannot keep real time (running at " << lroundf(100.f * simSpeed_)
+			 << "% speed, render interval " << lroundf(1000.f * renderInterval_) << " ms)" << endl;
+	else if (!behind && behind_)
+		cout << "Simulation back to real time" << endl;
+	behind_ = behind;
+
+	windowStart_ = now;
+	windowSteps_ = 0;
+	windowFrames_ = 0;
+	windowDropped_ = 0.f;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Reporting
+//--------------------------------------
+#endif
+
+string FrameScheduler::getSummaryLine() const
+{
+	lock_guard<mutex> guard(lock_);
+	char line[192];
+	int length = snprintf(line, sizeof(line),
+						  "Sched: %.0f steps/s (%.1f us) | %.0f fps (%.2f ms, every %.1f ms)",
+						  stepsPerSecond_, 1.e6f * stepCost_,
+						  framesPerSecond_, 1.e3f * renderCost_, 1.e3f * renderInterval_);
+	if (behind_ && length > 0 && length < static_cast<int>(sizeof(line)))
+		snprintf(line + length, sizeof(line) - length,
+				 " | BEHIND real time (%.0f%% speed)", 100.f * simSpeed_);
+	return line;
+}
@@ -0,0 +1,155 @@
+//
+//  FrameScheduler.h
+//  Week 08 - Earshooter
+//
+//	Decides, at each heartbeat of the timer, how many fixed-duration
+//	simulation steps to run and whether a frame should be rendered.
+//	The scheduler keeps moving averages of the cost of a simulation step
+//	and of a rendered frame.  When the two no longer fit in real time, the
+//	render interval is stretched first (up to a maximum), and only then is
+//	simulated time dropped, with the scheduler reporting that the
+//	simulation runs behind real time.  The number of steps of a heartbeat
+//	is capped, so that a slow frame cannot snowball into ever longer
+//	catch-up batches.
+//	The simulation thread schedules the steps and the frames, while the
+//	render thread reports the cost of the frames: all the methods lock the
+//	scheduler.
+
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace earshooter
+{
+	class FrameScheduler
+	{
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			/**	fraction of the CPU time left unscheduled, as a safety margin
+			 */
+			static const float HEADROOM;
+
+			/**	weight of the last measure in the moving averages
+			 */
+			static const float SMOOTHING;
+
+			const float stepDuration_;	//	simulated time of one step (s)
+			float frameBudget_;			//	preferred time between two frames (s)
+			float maxFrameInterval_;	//	longest time between two frames (s)
+			int maxStepsPerTick_;
+
+			float accumulator_;			//	real time not simulated yet (s)
+			Clock::time_point lastTick_;
+			Clock::time_point lastRender_;
+			bool clockStarted_;
+
+			float stepCost_;			//	moving average of a step's cost (s)
+			float renderCost_;			//	moving average of a frame's cost (s)
+			float renderInterval_;		//	current time between two frames (s)
+
+			//	statistics of the current one-second window
+			Clock::time_point windowStart_;
+			uint64_t windowSteps_;
+			uint64_t windowFrames_;
+			float windowDropped_;
+
+			//	statistics of the last complete window
+			float stepsPerSecond_;
+			float framesPerSecond_;
+			float simSpeed_;			//	simulated time / real time
+			bool behind_;
+
+			mutable std::mutex lock_;
+
+			void updateRenderInterval_();
+			void closeWindow_(Clock::time_point now);
+
+		public:
+
+			/**	Creates a scheduler
+			 *	@PARAM stepDuration		simulated time of one step, in seconds
+			 *	@PARAM frameBudget		preferred time between two frames, in seconds
+			 *	@PARAM maxFrameInterval	longest time between two frames, in seconds
+			 *	@PARAM maxStepsPerTick	largest number of steps run in one heartbeat
+			 */
+			FrameScheduler(float stepDuration, float frameBudget,
+						   float maxFrameInterval, int maxStepsPerTick);
+
+			/**	Computes the number of steps to run for this heartbeat, from
+			 *	the real time elapsed since the previous one.
+			 *	@RETURN	the number of steps to run
+			 */
+			int beginTick();
+
+			/**	Records the cost of the steps run in a heartbeat
+			 *	@PARAM nbSteps	the number of steps that were run
+			 *	@PARAM ns		their total duration, in nanoseconds
+			 */
+			void endTick(int nbSteps, uint64_t ns);
+
+			/**	Reports whether a frame is due, and if so, starts a new render
+			 *	interval.
+			 */
+			bool shouldRender();
+
+			/**	Records the cost of a rendered frame
+			 *	@PARAM ns	duration of the frame, in nanoseconds
+			 */
+			void recordRenderCost(uint64_t ns);
+
+			/**	Forgets the real time elapsed since the last heartbeat (e.g.
+			 *	while the animation was paused).
+			 */
+			void restartClock();
+
+			/**	Changes the preferred time between two frames
+			 *	@PARAM frameBudget	time in seconds
+			 */
+			void setFrameBudget(float frameBudget);
+
+			inline float getStepDuration() const
+			{
+				return stepDuration_;
+			}
+
+			inline float getRenderInterval() const
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+				return renderInterval_;
+			}
+
+			/**	Reports whether simulated time was dropped during the last
+			 *	complete one-second window
+			 */
+			inline bool isBehind() const
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+				return behind_;
+			}
+
+			/**	Returns the simulated time per second of real time measured
+			 *	over the last complete window (1 when keeping real time)
+			 */
+			inline float getSimSpeed() const
+			{
+				std::lock_guard<std::mutex> guard(lock_);
+				return simSpeed_;
+			}
+
+			/**	Builds the one-line summary displayed on the HUD
+			 */
+			std::string getSummaryLine() const;
+
+			//	Disabled constructors & operators
+			FrameScheduler() = delete;
+			FrameScheduler(const FrameScheduler&) = delete;
+			FrameScheduler& operator = (const FrameScheduler&) = delete;
+	};
+}
+
+#endif	//	FRAME_SCHEDULER_H
@@ -0,0 +1,244 @@
+//
+//  GLStateCache.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cstdio>
+#include "glPlatform.h"
+#include "GLStateCache.h"
+
+using namespace std;
+using namespace earshooter;
+
+const int NB_CALLS = static_cast<int>(GLStateCall::NB_CALLS);
+
+//	Values that no GL call can set: the next call is always issued
+const float UNKNOWN_WIDTH = -1.f;
+const unsigned int UNKNOWN_NAME = ~0u;
+
+bool GLStateCache::colorIsKnown_ = false;
+float GLStateCache::color_[3] = {0.f, 0.f, 0.f};
+float GLStateCache::lineWidth_ = UNKNOWN_WIDTH;
+unsigned int GLStateCache::matrixMode_ = UNKNOWN_NAME;
+unsigned int GLStateCache::program_ = UNKNOWN_NAME;
+unsigned int GLStateCache::arrayBuffer_ = UNKNOWN_NAME;
+unsigned int GLStateCache::clientState_ = 0;
+unsigned int GLStateCache::knownClientState_ = 0;
+uint64_t GLStateCache::issued_[NB_CALLS];
+uint64_t GLStateCache::elided_[NB_CALLS];
+uint64_t GLStateCache::lastIssued_[NB_CALLS];
+uint64_t GLStateCache::lastElided_[NB_CALLS];
+uint64_t GLStateCache::totalIssued_[NB_CALLS];
+uint64_t GLStateCache::totalElided_[NB_CALLS];
+
+static const char* const CALL_NAME[NB_CALLS] = {
+									"color",		//	COLOR
+									"line width",	//	LINE_WIDTH
+									"matrix mode",	//	MATRIX_MODE
+									"program",		//	PROGRAM
+									"buffer",		//	ARRAY_BUFFER
+									"client array"};	//	CLIENT_STATE
+
+unsigned int clientStateBit(unsigned int array);
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark State setters
+//--------------------------------------
+#endif
+
+inline bool GLStateCache::filter_(GLStateCall call, bool isRedundant)
+{
+	int index = static_cast<int>(call);
+	if (isRedundant)
+	{
+		elided_[index]++;
+		totalElided_[index]++;
+	}
+	else
+	{
+		issued_[index]++;
+		totalIssued_[index]++;
+	}
+	return !isRedundant;
+}
+
+void GLStateCache::setColor(float r, float g, float b)
+{
+	if (filter_(GLStateCall::COLOR,
+				colorIsKnown_ && r == color_[0] && g == color_[1] && b == color_[2]))
+	{
+		glColor3f(r, g, b);
+		color_[0] = r;
+		color_[1] = g;
+		color_[2] = b;
+		colorIsKnown_ = true;
+	}
+}
+
+void GLStateCache::setColor(const float rgb[3])
+{
+	setColor(rgb[0], rgb[1], rgb[2]);
+}
+
+void GLStateCache::setLineWidth(float width)
+{
+	if (filter_(GLStateCall::LINE_WIDTH, width == lineWidth_))
+	{
+		glLineWidth(width);
+		lineWidth_ = width;
+	}
+}
+
+void GLStateCache::setMatrixMode(unsigned int mode)
+{
+	if (filter_(GLStateCall::MATRIX_MODE, mode == matrixMode_))
+	{
+		glMatrixMode(mode);
+		matrixMode_ = mode;
+	}
+}
+
+void GLStateCache::useProgram(unsigned int program)
+{
+	if (filter_(GLStateCall::PROGRAM, program == program_))
+	{
+		glUseProgram(program);
+		program_ = program;
+	}
+	//	(some drivers alias generic attributes with the current color)
+	if (program != 0)
+		colorIsKnown_ = false;
+}
+
+void GLStateCache::bindArrayBuffer(unsigned int buffer)
+{
+	if (filter_(GLStateCall::ARRAY_BUFFER, buffer == arrayBuffer_))
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		arrayBuffer_ = buffer;
+	}
+}
+
+void GLStateCache::setClientState(unsigned int array, bool enabled)
+{
+	unsigned int bit = clientStateBit(array);
+	bool isRedundant = (knownClientState_ & bit) != 0 &&
+					   ((clientState_ & bit) != 0) == enabled;
+	if (filter_(GLStateCall::CLIENT_STATE, isRedundant))
+	{
+		if (enabled)
+			glEnableClientState(array);
+		else
+			glDisableClientState(array);
+		knownClientState_ |= bit;
+		if (enabled)
+			clientState_ |= bit;
+		else
+			clientState_ &= ~bit;
+	}
+	//	the draws that use a color array leave the current color undefined
+	if (enabled && array == GL_COLOR_ARRAY)
+		colorIsKnown_ = false;
+}
+
+void GLStateCache::invalidate()
+{
+	colorIsKnown_ = false;
+	lineWidth_ = UNKNOWN_WIDTH;
+	matrixMode_ = UNKNOWN_NAME;
+	program_ = UNKNOWN_NAME;
+	arrayBuffer_ = UNKNOWN_NAME;
+	knownClientState_ = 0;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Counts
+//--------------------------------------
+#endif
+
+void GLStateCache::beginFrame()
+{
+	for (int k = 0; k < NB_CALLS; k++)
+	{
+		lastIssued_[k] = issued_[k];
+		lastElided_[k] = elided_[k];
+		issued_[k] = 0;
+		elided_[k] = 0;
+	}
+}
+
+uint64_t GLStateCache::getIssuedCount(GLStateCall call)
+{
+	return lastIssued_[static_cast<int>(call)];
+}
+
+uint64_t GLStateCache::getElidedCount(GLStateCall call)
+{
+	return lastElided_[static_cast<int>(call)];
+}
+
+const char* GLStateCache::getCallName(GLStateCall call)
+{
+	return CALL_NAME[static_cast<int>(call)];
+}
+
+string GLStateCache::getSummaryLine()
+{
+	uint64_t issued = 0, elided = 0;
+	for (int k = 0; k < NB_CALLS; k++)
+	{
+		issued += lastIssued_[k];
+		elided += lastElided_[k];
+	}
+	char line[200];
+	int length = snprintf(line, sizeof(line), "GL state: %llu issued, %llu elided |",
+						  static_cast<unsigned long long>(issued),
+						  static_cast<unsigned long long>(elided));
+	for (int k = 0; k < NB_CALLS && length < static_cast<int>(sizeof(line)); k++)
+		length += snprintf(line + length, sizeof(line) - length, " %s %llu/%llu", CALL_NAME[k],
+						   static_cast<unsigned long long>(lastIssued_[k]),
+						   static_cast<unsigned long long>(lastIssued_[k] + lastElided_[k]));
+	return line;
+}
+
+void GLStateCache::report(ostream& out)
+{
+	out << "GL state calls (issued / elided):" << endl;
+	for (int k = 0; k < NB_CALLS; k++)
+	{
+		uint64_t total = totalIssued_[k] + totalElided_[k];
+		char line[128];
+		snprintf(line, sizeof(line), "  %-13s %10llu / %-10llu (%.1f%% elided)", CALL_NAME[k],
+				 static_cast<unsigned long long>(totalIssued_[k]),
+				 static_cast<unsigned long long>(totalElided_[k]),
+				 total > 0 ? 100.0 * totalElided_[k] / total : 0.0);
+		out << line << endl;
+	}
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Free functions
+//--------------------------------------
+#endif
+
+unsigned int clientStateBit(unsigned int array)
+{
+	switch (array)
+	{
+		case GL_VERTEX_ARRAY:
+			return 1u;
+		case GL_COLOR_ARRAY:
+			return 2u;
+		case GL_TEXTURE_COORD_ARRAY:
+			return 4u;
+		default:
+			//	not tracked: never known, so always issued
+			return 0u;
+	}
+}
@@ -0,0 +1,110 @@
+//
+//  GLStateCache.h
+//  Week 08 - Earshooter
+//
+//	Thin layer between the drawing code and the OpenGL state it sets most
+//	often: current color, line width, matrix mode, program, array buffer
+//	binding, and fixed-function client arrays.  Each setter remembers the
+//	last value issued and skips the GL call when the state wouldn't change.
+//	The calls issued and elided are counted per type of call, for the
+//	profiling HUD and report.
+//	All the code that sets one of these states must go through the cache
+//	(or call invalidate afterwards), and only from the thread of the GL
+//	context.  The current color is forgotten whenever a color array or a
+//	program gets enabled, since drawing with them may overwrite it.
+
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace earshooter
+{
+	/**	The types of state calls filtered by the cache
+	 */
+	enum class GLStateCall
+	{
+		COLOR = 0,			//	glColor3f
+		LINE_WIDTH,			//	glLineWidth
+		MATRIX_MODE,		//	glMatrixMode
+		PROGRAM,			//	glUseProgram
+		ARRAY_BUFFER,		//	glBindBuffer(GL_ARRAY_BUFFER, ...)
+		CLIENT_STATE,		//	glEnableClientState, glDisableClientState
+		//
+		NB_CALLS
+	};
+
+	/**	Application-wide cache of the current GL state, in the same "struct
+	 *	of statics" spirit as Profiler.
+	 */
+	struct GLStateCache
+	{
+		static void setColor(float r, float g, float b);
+		static void setColor(const float rgb[3]);
+		static void setLineWidth(float width);
+		static void setMatrixMode(unsigned int mode);
+		static void useProgram(unsigned int program);
+		static void bindArrayBuffer(unsigned int buffer);
+
+		/**	Enables or disables one of GL_VERTEX_ARRAY, GL_COLOR_ARRAY, and
+		 *	GL_TEXTURE_COORD_ARRAY (other arrays are passed through)
+		 */
+		static void setClientState(unsigned int array, bool enabled);
+
+		/**	Forgets all the cached state, so that the next call of each
+		 *	type is issued.  To be called after code that changes the state
+		 *	behind the cache's back (glPopAttrib, a new context, ...).
+		 */
+		static void invalidate();
+
+		/**	Starts the counts of a new frame.  The counts of the frame that
+		 *	just ended are those returned by the getters.
+		 */
+		static void beginFrame();
+
+		/**	Number of calls of a type issued during the last frame
+		 */
+		static uint64_t getIssuedCount(GLStateCall call);
+
+		/**	Number of calls of a type elided during the last frame
+		 */
+		static uint64_t getElidedCount(GLStateCall call);
+
+		/**	Returns the display name of a type of call
+		 */
+		static const char* getCallName(GLStateCall call);
+
+		/**	Builds the one-line summary of the last frame's issued and
+		 *	elided calls, displayed in the HUD
+		 */
+		static std::string getSummaryLine();
+
+		/**	Prints the calls issued and elided since the start of the
+		 *	application, by type
+		 */
+		static void report(std::ostream& out);
+
+		private:
+			static const int NB_CALLS = static_cast<int>(GLStateCall::NB_CALLS);
+
+			static bool colorIsKnown_;
+			static float color_[3];
+			static float lineWidth_;
+			static unsigned int matrixMode_;
+			static unsigned int program_;
+			static unsigned int arrayBuffer_;
+			//	client arrays enabled, and client arrays whose state is known
+			static unsigned int clientState_, knownClientState_;
+
+			//	counts of the current frame, of the last one, and in total
+			static uint64_t issued_[NB_CALLS], elided_[NB_CALLS];
+			static uint64_t lastIssued_[NB_CALLS], lastElided_[NB_CALLS];
+			static uint64_t totalIssued_[NB_CALLS], totalElided_[NB_CALLS];
+
+			static bool filter_(GLStateCall call, bool isRedundant);
+	};
+}
+
+#endif	//	GL_STATE_CACHE_H
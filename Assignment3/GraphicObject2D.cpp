@@ -5,14 +5,19 @@
 //  Created by Jean-Yves Hervé on 2024-09-19.
 //
 
+#include <cmath>
 #include "glPlatform.h"
 #include "GraphicObject2D.h"
 
 using namespace std;
 using namespace earshooter;
 
-unsigned int GraphicObject2D::count_ = 0;
-unsigned int GraphicObject2D::liveCount_ = 0;
+//	The edges are checked again after that fraction of the predicted time
+//	to the nearest one
+const float EDGE_TIME_SAFETY = 0.95f;
+
+atomic<unsigned int> GraphicObject2D::count_(0);
+atomic<unsigned int> GraphicObject2D::liveCount_(0);
 
 #if 0
 //--------------------------------------
@@ -36,7 +41,9 @@ GraphicObject2D::GraphicObject2D(float cx, float cy, float angle,
 		spin_(spin),
 		relativeBox_(nullptr),
 		absoluteBox_(nullptr),
-		index_(count_++)
+		index_(count_++),
+		world_(nullptr),
+		timeToEdge_(0.f)
 {
 	liveCount_++;
 }
@@ -98,16 +105,26 @@ UpdateStatus GraphicObject2D::update(float dt)
 	cy_ += vy_*dt;
 	angle_ += spin_*dt;
 	
-	//	different behaviors based on World2D::worldType
-	switch(World2D::worldType)
+	//	Not in a world yet, or no edge within reach yet: no edges to deal with
+	timeToEdge_ -= dt;
+	if (world_ == nullptr || timeToEdge_ > 0.f)
+	{
+		if (absoluteBox_ != nullptr)
+			updateAbsoluteBox_();
+		return status;
+	}
+	const World2D& world = *world_;
+
+	//	different behaviors based on the world's type
+	switch(world.getType())
 	{
 		case WorldType::WINDOW_WORLD:
 			//	I add (a lot of) "padding" to my out of bounds test
 			//
-			if (cx_ > World2D::X_MAX + 0.5f*World2D::WIDTH ||
-				cx_ < World2D::X_MIN - 0.5f*World2D::WIDTH ||
-				cy_ > World2D::Y_MAX + 0.5f*World2D::HEIGHT ||
-				cy_ < World2D::Y_MIN - 0.5f*World2D::HEIGHT)
+			if (cx_ > world.getXmax() + 0.5f*world.getWidth() ||
+				cx_ < world.getXmin() - 0.5f*world.getWidth() ||
+				cy_ > world.getYmax() + 0.5f*world.getHeight() ||
+				cy_ < world.getYmin() - 0.5f*world.getHeight())
 			{
 				status = UpdateStatus::DEAD;
 			}
@@ -115,26 +132,26 @@ UpdateStatus GraphicObject2D::update(float dt)
 
 		case WorldType::BOX_WORLD:
 			//	hit the right edge
-			if (getX() >= World2D::X_MAX) {
-				cx_ = World2D::X_MAX;
+			if (getX() >= world.getXmax()) {
+				cx_ = world.getXmax();
 				vx_ = -vx_;
 				status = UpdateStatus::BOUNCE;
 			}
 			//	hit the left edge
-			if (getX() <= World2D::X_MIN) {
-				cx_ = World2D::X_MIN;
+			if (getX() <= world.getXmin()) {
+				cx_ = world.getXmin();
 				vx_ = -vx_;
 				status = UpdateStatus::BOUNCE;
 			}
 			//	hit the top edge
-			if (getY() >= World2D::Y_MAX) {
-				cy_ = World2D::Y_MAX;
+			if (getY() >= world.getYmax()) {
+				cy_ = world.getYmax();
 				vy_ = -vy_;
 				status = UpdateStatus::BOUNCE;
 			}
 			//	hit the bottom edge
-			if (getY() <= World2D::Y_MIN) {
-				cy_ = World2D::Y_MIN;
+			if (getY() <= world.getYmin()) {
+				cy_ = world.getYmin();
 				vy_ = -vy_;
 				status = UpdateStatus::BOUNCE;
 			}
@@ -142,24 +159,24 @@ UpdateStatus GraphicObject2D::update(float dt)
 
 		case WorldType::CYLINDER_WORLD:
 			//	hit the right edge
-			if (getX() >= World2D::X_MAX) {
-				cx_ -= World2D::WIDTH;
+			if (getX() >= world.getXmax()) {
+				cx_ -= world.getWidth();
 				status = UpdateStatus::WRAPAROUND;
 			}
 			//	hit the left edge
-			if (getX() <= World2D::X_MIN) {
-				cx_ += World2D::WIDTH;
+			if (getX() <= world.getXmin()) {
+				cx_ += world.getWidth();
 				status = UpdateStatus::WRAPAROUND;
 			}
 			//	hit the top edge
-			if (getY() >= World2D::Y_MAX) {
-				cy_ = World2D::Y_MAX;
+			if (getY() >= world.getYmax()) {
+				cy_ = world.getYmax();
 				vy_ = -vy_;
 				status = UpdateStatus::BOUNCE;
 			}
 			//	hit the bottom edge
-			if (getY() <= World2D::Y_MIN) {
-				cy_ = World2D::Y_MIN;
+			if (getY() <= world.getYmin()) {
+				cy_ = world.getYmin();
 				vy_ = -vy_;
 				status = UpdateStatus::BOUNCE;
 			}
@@ -167,24 +184,24 @@ UpdateStatus GraphicObject2D::update(float dt)
 
 		case WorldType::SPHERE_WORLD:
 			// hit the right edge
-			if (getX() >= World2D::X_MAX) {
-				cx_ -= World2D::WIDTH;
+			if (getX() >= world.getXmax()) {
+				cx_ -= world.getWidth();
 				status = UpdateStatus::WRAPAROUND;
 			}
 			// hit the left edge
-			else if (getX() <= World2D::X_MIN) {
-				cx_ += World2D::WIDTH;
+			else if (getX() <= world.getXmin()) {
+				cx_ += world.getWidth();
 				status = UpdateStatus::WRAPAROUND;
 			}
 
 			// hit the top edge
-			if (getY() >= World2D::Y_MAX) {
-				cy_ -= World2D::HEIGHT;  // Adjust cy_ to wrap vertically
+			if (getY() >= world.getYmax()) {
+				cy_ -= world.getHeight();  // Adjust cy_ to wrap vertically
 				status = UpdateStatus::WRAPAROUND;
 			}
 			// hit the bottom edge
-			else if (getY() <= World2D::Y_MIN) {
-				cy_ += World2D::HEIGHT;  // Adjust cy_ to wrap vertically
+			else if (getY() <= world.getYmin()) {
+				cy_ += world.getHeight();  // Adjust cy_ to wrap vertically
 				status = UpdateStatus::WRAPAROUND;
 			}
 			break;
@@ -192,6 +209,7 @@ UpdateStatus GraphicObject2D::update(float dt)
 		default:
 			break;
 	}
+	timeToEdge_ = predictTimeToEdge_();
 	
 	//	Update the bounding boxes (if they exist)
 	//	Simple (i.e. not complex, not made up of parts) objects' relative bounding
@@ -203,32 +221,34 @@ UpdateStatus GraphicObject2D::update(float dt)
 }
 
 
-void GraphicObject2D::draw() const
+void GraphicObject2D::draw(Renderer2D& renderer, const Transform2D& world) const
 {
-	glPushMatrix();
-	glTranslatef(cx_, cy_, 0.f);
-	glRotatef(angle_, 0, 0, 1);
-	
 	//	call the object's private drawing function
-	draw_();
-	
+	draw_(renderer, world.translated(cx_, cy_).rotated(angle_));
+}
+
+void GraphicObject2D::drawDebug(Renderer2D& renderer, const Transform2D& world) const
+{
+	if (!BoundingBox::relativeBoxesAreDrawn() && !BoundingBox::absoluteBoxesAreDrawn() &&
+		!World2D::drawReferenceFrames)
+		return;
+
+	//	relative boxes are in the object's frame, absolute ones in the world's
+	Transform2D local = world.translated(cx_, cy_).rotated(angle_);
+
 	if (BoundingBox::relativeBoxesAreDrawn() && relativeBox_ != nullptr)
 	{
-		relativeBox_->draw();
+		relativeBox_->draw(renderer, local);
 	}
 	else if (BoundingBox::absoluteBoxesAreDrawn() && absoluteBox_ != nullptr)
 	{
-		glPushMatrix();
-		glLoadIdentity();
-
-		absoluteBox_->draw();
-		glPopMatrix();
+		absoluteBox_->draw(renderer, world);
 	}
 	
 	if (BoundingBox::relativeBoxesAreDrawn() && !partRelativeBox_.empty()) {
 		for (const auto& box : partRelativeBox_) {
 			if (box) {
-				box->draw();
+				box->draw(renderer, local);
 			}
 		}
 	}
@@ -236,19 +256,13 @@ void GraphicObject2D::draw() const
 	{
 		for (const auto& box : partAbsoluteBox_) {
 			if (box) {
-				glPushMatrix();
-				glLoadIdentity();
-
-				box->draw();
-				glPopMatrix();
+				box->draw(renderer, world);
 			}
 		}
 	}
 
 	if (World2D::drawReferenceFrames)
-		drawReferenceFrame();
-
-	glPopMatrix();
+		drawReferenceFrame(renderer, local);
 }
 
 #if 0
@@ -320,11 +334,22 @@ void GraphicObject2D::setPosition(float x, float y)
 {
 	cx_ = x;
 	cy_ = y;
+	scheduleEdgeCheck();
 }
 void GraphicObject2D::setPosition(const WorldPoint& pt)
 {
 	cx_ = pt.x;
 	cy_ = pt.y;
+	scheduleEdgeCheck();
+}
+
+void GraphicObject2D::translate(float dx, float dy)
+{
+	cx_ += dx;
+	cy_ += dy;
+	scheduleEdgeCheck();
+	if (absoluteBox_ != nullptr)
+		updateAbsoluteBox_();
 }
 
 void GraphicObject2D::setAngle(float angle)
@@ -345,6 +370,41 @@ void GraphicObject2D::setDead(bool isDead)
 }
 
 
+void GraphicObject2D::setWorld(World2D* world)
+{
+	world_ = world;
+	scheduleEdgeCheck();
+}
+
+float GraphicObject2D::predictTimeToEdge_() const
+{
+	//	the same bounds as the tests of update
+	float xmin = world_->getXmin(), xmax = world_->getXmax();
+	float ymin = world_->getYmin(), ymax = world_->getYmax();
+	if (world_->getType() == WorldType::WINDOW_WORLD)
+	{
+		xmin -= 0.5f*world_->getWidth();
+		xmax += 0.5f*world_->getWidth();
+		ymin -= 0.5f*world_->getHeight();
+		ymax += 0.5f*world_->getHeight();
+	}
+
+	float t = INFINITY;
+	if (vx_ > 0.f)
+		t = (xmax - cx_) / vx_;
+	else if (vx_ < 0.f)
+		t = (xmin - cx_) / vx_;
+	if (vy_ > 0.f)
+		t = fminf(t, (ymax - cy_) / vy_);
+	else if (vy_ < 0.f)
+		t = fminf(t, (ymin - cy_) / vy_);
+
+	//	The positions are summed step by step, so the object may get there
+	//	a little ahead of the prediction.  Getting closer, the edges get
+	//	checked more and more often.
+	return EDGE_TIME_SAFETY * fmaxf(t, 0.f);
+}
+
 void GraphicObject2D::setDrawContour(bool drawContour)
 {
 	drawContour_ = drawContour;
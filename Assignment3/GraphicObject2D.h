@@ -8,10 +8,14 @@
 #ifndef GRAPHIC_OBJECT_2D_H
 #define GRAPHIC_OBJECT_2D_H
 
+#include <atomic>
+#include <list>
 #include <memory>
 #include <stdio.h>
 #include "World2D.h"
 #include "BoundingBox.h"
+#include "Renderer2D.h"
+#include "MemoryTracker.h"
 #include <vector>
 
 namespace earshooter
@@ -30,8 +34,10 @@ namespace earshooter
 		/*
 		Vectors to store all the differnt bounding box instances if needed for the object
 		*/
-		std::vector<std::unique_ptr<BoundingBox>> partRelativeBox_;
-		std::vector<std::unique_ptr<BoundingBox> > partAbsoluteBox_;
+		std::vector<std::unique_ptr<BoundingBox>,
+					ScopedTrackedAllocator<std::unique_ptr<BoundingBox>>> partRelativeBox_;
+		std::vector<std::unique_ptr<BoundingBox>,
+					ScopedTrackedAllocator<std::unique_ptr<BoundingBox>>> partAbsoluteBox_;
 	private:
 		float cx_, cy_, angle_;
 		float vx_, vy_, spin_;
@@ -44,19 +50,40 @@ namespace earshooter
 		 */
 		unsigned int index_;
 
+		/**	The world the object was added to (nullptr until then)
+		 */
+		World2D* world_;
+
+		/**	Time (in s) left before the object may reach an edge of its
+		 *	world, predicted from its motion the last time the edges were
+		 *	checked.  The edges are only checked again once it runs out.
+		 */
+		float timeToEdge_;
+
+		/**	Predicts, from the object's position and velocity, how long it
+		 *	will take to reach the nearest edge of its world (a little
+		 *	less, to be on the safe side)
+		 *	@RETURN	the predicted time (in s), infinite for an object at rest
+		 */
+		float predictTimeToEdge_() const;
+
 		/**	Counter of the number of GraphicObject2D objects created
+		 *	(objects get created by the threads of several worlds)
 		 */
-		static unsigned int count_;
+		static std::atomic<unsigned int> count_;
 
 		/**	Counter of the number of GraphicObject2D objects still "alive"
 		 */
-		static unsigned int liveCount_;
+		static std::atomic<unsigned int> liveCount_;
 
 		/**	Pure virtual (abstract) function.   Translation and rotation
-		 *	have already been applied by the root class, so the implementation of this
-		 *	function in the child class should only apply scaling prior to rendering.
+		 *	have already been applied by the root class to the transformation
+		 *	passed, so the implementation of this function in the child class
+		 *	should only apply scaling before adding its geometry to the renderer.
+		 *	@PARAM renderer		the renderer collecting the frame's geometry
+		 *	@PARAM transform	the object's local to world transformation
 		 */
-		virtual void draw_() const = 0;
+		virtual void draw_(Renderer2D& renderer, const Transform2D& transform) const = 0;
 
 		/** Update the object's absolute bounding box
 		 */
@@ -182,6 +209,13 @@ namespace earshooter
 		 */
 		void setPosition(const WorldPoint& pt);
 
+		/**
+		 * Moves the object, and its absolute bounding box, by a displacement.
+		 * @param dx X component of the displacement.
+		 * @param dy Y component of the displacement.
+		 */
+		void translate(float dx, float dy);
+
 		/**
 		 * Sets the angle of the object.
 		 * @param angle The new angle in degrees, where 0 represents the default orientation.
@@ -213,6 +247,27 @@ namespace earshooter
 		static unsigned int getBaseCount();
 		static unsigned int getBaseLiveCount();
 
+		/** Returns the world the object lives in
+		 *	@RETURN the object's world (nullptr if it wasn't added to one)
+		 */
+		inline World2D* getWorld() const
+		{
+			return world_;
+		}
+
+		/** Sets the world the object lives in.  Called by World2D::addObject.
+		 *	@PARAM world	the object's world
+		 */
+		void setWorld(World2D* world);
+
+		/**	Makes the object check the edges of its world at its next update
+		 *	(for when its position, or the world, changed by other means)
+		 */
+		inline void scheduleEdgeCheck()
+		{
+			timeToEdge_ = 0.f;
+		}
+
 		inline float getR() const
 		{
 			return r_;
@@ -227,8 +282,31 @@ namespace earshooter
 		}
 		void setColor(float r, float g, float b);
 
-		//	now a regular virtual function
-		virtual void draw() const;
+		/**	Adds the object's geometry to the renderer's batches
+		 *	@PARAM renderer	the renderer collecting the frame's geometry
+		 *	@PARAM world	offset of the copy of the world being drawn
+		 */
+		virtual void draw(Renderer2D& renderer, const Transform2D& world) const;
+
+		/**	Adds the object's geometry to the renderer's batches, with a
+		 *	model transformation already computed (e.g. for a batch of objects
+		 *	by computeModelTransforms)
+		 *	@PARAM renderer	the renderer collecting the frame's geometry
+		 *	@PARAM model	translation and rotation of the object, in the copy
+		 *					of the world being drawn
+		 */
+		inline void drawModel(Renderer2D& renderer, const Transform2D& model) const
+		{
+			draw_(renderer, model);
+		}
+
+		/**	Adds the bounding boxes and reference frame of the object, if
+		 *	they are enabled, to the debug batch of the renderer (which is
+		 *	drawn on top of all the others, as one set of lines)
+		 *	@PARAM renderer	the renderer collecting the frame's geometry
+		 *	@PARAM world	offset of the copy of the world being drawn
+		 */
+		void drawDebug(Renderer2D& renderer, const Transform2D& world) const;
 
 		/** Updates the position and orientation of the object.  If the subclass
 		 * has more stuff to update, it can override this function.
@@ -0,0 +1,194 @@
+//
+//  MemoryTracker.cpp
+//  Week 08 - Earshooter
+//
+
+#include <atomic>
+#include <cstdio>
+#include <iomanip>
+#include "MemoryTracker.h"
+
+using namespace std;
+using namespace earshooter;
+
+const int NB_CATEGORIES = static_cast<int>(MemoryCategory::NB_CATEGORIES);
+
+static const char* const CATEGORY_NAME[NB_CATEGORIES] = {
+										"triangle",		//	TRIANGLE
+										"rectangle",	//	RECTANGLE
+										"ellipse",		//	ELLIPSE
+										"face",			//	SMILING_FACE
+										"ship",			//	SPACE_SHIP
+										"projectile",	//	PROJECTILE
+										"list node",	//	LIST_NODE
+										"other"};		//	OTHER
+
+bool MemoryTracker::drawHudLine_ = false;
+
+namespace
+{
+	struct CategoryCounters
+	{
+		atomic<uint64_t> liveBytes;
+		atomic<uint64_t> liveAllocations;
+		atomic<uint64_t> liveInstances;
+		atomic<uint64_t> totalAllocations;
+	};
+
+	CategoryCounters counters[NB_CATEGORIES];
+
+	thread_local MemoryCategory currentCategory = MemoryCategory::OTHER;
+
+	/**	Prefix of the scoped allocations.  Its size keeps the user part of
+	 *	the block aligned like the one returned by operator new.
+	 */
+	struct alignas(alignof(max_align_t)) AllocationHeader
+	{
+		MemoryCategory category;
+		size_t bytes;
+	};
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Accounting
+//--------------------------------------
+#endif
+
+void MemoryTracker::recordAllocation(MemoryCategory category, size_t bytes, bool isInstance)
+{
+	CategoryCounters& c = counters[static_cast<int>(category)];
+	c.liveBytes.fetch_add(bytes, memory_order_relaxed);
+	c.liveAllocations.fetch_add(1, memory_order_relaxed);
+	c.totalAllocations.fetch_add(1, memory_order_relaxed);
+	if (isInstance)
+		c.liveInstances.fetch_add(1, memory_order_relaxed);
+}
+
+void MemoryTracker::recordDeallocation(MemoryCategory category, size_t bytes, bool isInstance)
+{
+	CategoryCounters& c = counters[static_cast<int>(category)];
+	c.liveBytes.fetch_sub(bytes, memory_order_relaxed);
+	c.liveAllocations.fetch_sub(1, memory_order_relaxed);
+	if (isInstance)
+		c.liveInstances.fetch_sub(1, memory_order_relaxed);
+}
+
+void* MemoryTracker::allocate(size_t bytes)
+{
+	AllocationHeader* header = static_cast<AllocationHeader*>(
+									::operator new(sizeof(AllocationHeader) + bytes));
+	header->category = currentCategory;
+	header->bytes = bytes;
+	recordAllocation(header->category, bytes, false);
+	return header + 1;
+}
+
+void MemoryTracker::deallocate(void* ptr)
+{
+	if (ptr == nullptr)
+		return;
+
+	AllocationHeader* header = static_cast<AllocationHeader*>(ptr) - 1;
+	recordDeallocation(header->category, header->bytes, false);
+	::operator delete(header);
+}
+
+MemoryCategory MemoryTracker::getCurrentCategory()
+{
+	return currentCategory;
+}
+
+MemoryStats MemoryTracker::getStats(MemoryCategory category)
+{
+	const CategoryCounters& c = counters[static_cast<int>(category)];
+	return MemoryStats{	c.liveBytes.load(memory_order_relaxed),
+						c.liveAllocations.load(memory_order_relaxed),
+						c.liveInstances.load(memory_order_relaxed),
+						c.totalAllocations.load(memory_order_relaxed)};
+}
+
+const char* MemoryTracker::getCategoryName(MemoryCategory category)
+{
+	return CATEGORY_NAME[static_cast<int>(category)];
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Reporting
+//--------------------------------------
+#endif
+
+void MemoryTracker::report(ostream& out)
+{
+	out << "-------------------------------------------------------------------" << endl;
+	out << left << setw(12) << "category" << right
+		<< setw(11) << "instances"
+		<< setw(13) << "live bytes"
+		<< setw(13) << "live allocs"
+		<< setw(14) << "bytes/inst."
+		<< setw(14) << "total allocs" << endl;
+	for (int k = 0; k < NB_CATEGORIES; k++)
+	{
+		MemoryStats stats = getStats(static_cast<MemoryCategory>(k));
+		out << left << setw(12) << CATEGORY_NAME[k] << right
+			<< setw(11) << stats.liveInstances
+			<< setw(13) << stats.liveBytes
+			<< setw(13) << stats.liveAllocations
+			<< setw(14) << (stats.liveInstances > 0 ? stats.liveBytes / stats.liveInstances : 0)
+			<< setw(14) << stats.totalAllocations << endl;
+	}
+	out << "-------------------------------------------------------------------" << endl;
+}
+
+string MemoryTracker::getSummaryLine()
+{
+	//	instances and bytes per instance of the object types, total for the list
+	string line = "Memory (count x bytes):";
+	char buffer[64];
+	for (int k = 0; k < static_cast<int>(MemoryCategory::LIST_NODE); k++)
+	{
+		MemoryStats stats = getStats(static_cast<MemoryCategory>(k));
+		snprintf(buffer, sizeof(buffer), "%s %s %llu x %llu", k == 0 ? "" : " |",
+				 CATEGORY_NAME[k],
+				 static_cast<unsigned long long>(stats.liveInstances),
+				 static_cast<unsigned long long>(stats.liveInstances > 0 ?
+												 stats.liveBytes / stats.liveInstances : 0));
+		line += buffer;
+	}
+	MemoryStats list = getStats(MemoryCategory::LIST_NODE);
+	snprintf(buffer, sizeof(buffer), " | list %.1f KB",
+			 static_cast<double>(list.liveBytes) / 1024.0);
+	line += buffer;
+	return line;
+}
+
+bool MemoryTracker::hudLineIsDrawn()
+{
+	return drawHudLine_;
+}
+
+void MemoryTracker::setDrawHudLine(bool draw)
+{
+	drawHudLine_ = draw;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark MemoryScope
+//--------------------------------------
+#endif
+
+MemoryScope::MemoryScope(MemoryCategory category)
+	:	previous_(currentCategory)
+{
+	currentCategory = category;
+}
+
+MemoryScope::~MemoryScope()
+{
+	currentCategory = previous_;
+}
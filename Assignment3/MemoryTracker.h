@@ -0,0 +1,234 @@
+//
+//  MemoryTracker.h
+//  Week 08 - Earshooter
+//
+//	Attribution of heap memory to the object types of the application.
+//	Two allocators feed the tracker:
+//		- TrackedAllocator, whose category is fixed at compile time, is used
+//		  for the objects themselves (through allocate_shared) and for the
+//		  nodes of the object list.  Each of its allocations counts as one
+//		  instance of its category.
+//		- ScopedTrackedAllocator (and BoundingBox's operator new) charge
+//		  their allocations to the category of the innermost MemoryScope of
+//		  the calling thread, and remember it in a small header so that the
+//		  memory is given back to the right category when freed.  This is
+//		  how the bounding boxes (and the vectors that hold the part boxes)
+//		  created in an object's constructor get charged to its type.
+
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+namespace earshooter
+{
+	enum class MemoryCategory
+	{
+		TRIANGLE = 0,
+		RECTANGLE,
+		ELLIPSE,
+		SMILING_FACE,
+		SPACE_SHIP,
+		PROJECTILE,
+		LIST_NODE,
+		OTHER,			//	heap memory allocated outside of any MemoryScope
+		//
+		NB_CATEGORIES
+	};
+
+	/**	Snapshot of the memory charged to one category
+	 */
+	struct MemoryStats
+	{
+		/**	bytes currently allocated
+		 */
+		uint64_t liveBytes;
+
+		/**	allocations currently alive
+		 */
+		uint64_t liveAllocations;
+
+		/**	instances currently alive (objects, or list nodes)
+		 */
+		uint64_t liveInstances;
+
+		/**	allocations made since the start of the application
+		 */
+		uint64_t totalAllocations;
+	};
+
+	struct MemoryTracker
+	{
+		/**	Charges an allocation to a category
+		 *	@PARAM category	the category charged
+		 *	@PARAM bytes	size of the allocation
+		 *	@PARAM isInstance	true if the allocation is a whole instance
+		 */
+		static void recordAllocation(MemoryCategory category, std::size_t bytes, bool isInstance);
+
+		/**	Gives back the memory of an allocation to a category
+		 */
+		static void recordDeallocation(MemoryCategory category, std::size_t bytes, bool isInstance);
+
+		/**	Allocates memory charged to the category of the current MemoryScope
+		 *	@PARAM bytes	size of the allocation
+		 */
+		static void* allocate(std::size_t bytes);
+
+		/**	Frees memory obtained from allocate, crediting the category it was
+		 *	charged to.
+		 */
+		static void deallocate(void* ptr);
+
+		/**	Returns the category charged by allocate on the calling thread
+		 */
+		static MemoryCategory getCurrentCategory();
+
+		/**	Returns the memory charged to a category
+		 */
+		static MemoryStats getStats(MemoryCategory category);
+
+		/**	Returns the display name of a category
+		 */
+		static const char* getCategoryName(MemoryCategory category);
+
+		/**	Prints the memory charged to each category, with the average
+		 *	cost of an instance.
+		 */
+		static void report(std::ostream& out);
+
+		/**	Builds the compact one-line summary displayed on the HUD
+		 */
+		static std::string getSummaryLine();
+
+		static bool hudLineIsDrawn();
+		static void setDrawHudLine(bool draw);
+
+		private:
+			friend class MemoryScope;
+			static bool drawHudLine_;
+
+			MemoryTracker() = delete;
+	};
+
+	/**	RAII object that makes a category the target of the scoped
+	 *	allocations of the calling thread, until it goes out of scope.
+	 */
+	class MemoryScope
+	{
+		private:
+			MemoryCategory previous_;
+
+		public:
+			explicit MemoryScope(MemoryCategory category);
+			~MemoryScope();
+
+			//	Disabled constructors & operators
+			MemoryScope() = delete;
+			MemoryScope(const MemoryScope&) = delete;
+			MemoryScope& operator = (const MemoryScope&) = delete;
+	};
+
+	/**	Standard allocator charging all its allocations to a fixed category
+	 */
+	template <typename T, MemoryCategory CATEGORY>
+	class TrackedAllocator
+	{
+		public:
+			using value_type = T;
+
+			template <typename U>
+			struct rebind
+			{
+				using other = TrackedAllocator<U, CATEGORY>;
+			};
+
+			TrackedAllocator() = default;
+
+			template <typename U>
+			TrackedAllocator(const TrackedAllocator<U, CATEGORY>&)
+			{
+			}
+
+			T* allocate(std::size_t n)
+			{
+				T* ptr = static_cast<T*>(::operator new(n * sizeof(T)));
+				MemoryTracker::recordAllocation(CATEGORY, n * sizeof(T), true);
+				return ptr;
+			}
+
+			void deallocate(T* ptr, std::size_t n)
+			{
+				MemoryTracker::recordDeallocation(CATEGORY, n * sizeof(T), true);
+				::operator delete(ptr);
+			}
+	};
+
+	template <typename T, typename U, MemoryCategory CATEGORY>
+	inline bool operator == (const TrackedAllocator<T, CATEGORY>&, const TrackedAllocator<U, CATEGORY>&)
+	{
+		return true;
+	}
+
+	template <typename T, typename U, MemoryCategory CATEGORY>
+	inline bool operator != (const TrackedAllocator<T, CATEGORY>&, const TrackedAllocator<U, CATEGORY>&)
+	{
+		return false;
+	}
+
+	/**	Standard allocator charging its allocations to the category of the
+	 *	current MemoryScope
+	 */
+	template <typename T>
+	class ScopedTrackedAllocator
+	{
+		public:
+			using value_type = T;
+
+			ScopedTrackedAllocator() = default;
+
+			template <typename U>
+			ScopedTrackedAllocator(const ScopedTrackedAllocator<U>&)
+			{
+			}
+
+			T* allocate(std::size_t n)
+			{
+				return static_cast<T*>(MemoryTracker::allocate(n * sizeof(T)));
+			}
+
+			void deallocate(T* ptr, std::size_t)
+			{
+				MemoryTracker::deallocate(ptr);
+			}
+	};
+
+	template <typename T, typename U>
+	inline bool operator == (const ScopedTrackedAllocator<T>&, const ScopedTrackedAllocator<U>&)
+	{
+		return true;
+	}
+
+	template <typename T, typename U>
+	inline bool operator != (const ScopedTrackedAllocator<T>&, const ScopedTrackedAllocator<U>&)
+	{
+		return false;
+	}
+
+	/**	Creates a shared object whose allocation (object and control block)
+	 *	is charged to the given category
+	 */
+	template <typename T, MemoryCategory CATEGORY, typename... Args>
+	inline std::shared_ptr<T> makeTracked(Args&&... args)
+	{
+		return std::allocate_shared<T>(TrackedAllocator<T, CATEGORY>(), std::forward<Args>(args)...);
+	}
+}
+
+#endif	//	MEMORY_TRACKER_H
@@ -0,0 +1,231 @@
+//
+//  PerfCounters.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cerrno>
+#include <cstring>
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+	#include <unistd.h>
+	#include <sys/ioctl.h>
+	#include <sys/syscall.h>
+	#include <linux/perf_event.h>
+#endif
+
+using namespace std;
+using namespace earshooter;
+
+bool PerfCounters::enabled_ = false;
+bool PerfCounters::available_[static_cast<int>(HardwareCounter::NB_COUNTERS)] = {false};
+string PerfCounters::status_ = "disabled";
+
+static const char* const COUNTER_NAME[static_cast<int>(HardwareCounter::NB_COUNTERS)] = {
+										"cycles",			//	CYCLES
+										"instructions",		//	INSTRUCTIONS
+										"L1D misses",		//	L1D_MISSES
+										"LLC misses",		//	LLC_MISSES
+										"branch misses"};	//	BRANCH_MISSES
+
+#if defined(__linux__)
+
+namespace
+{
+	const int NB_COUNTERS = static_cast<int>(HardwareCounter::NB_COUNTERS);
+
+	/**	The counters of one thread, opened as a single perf group so that
+	 *	they can all be read with one system call.  They are closed when the
+	 *	thread exits.
+	 */
+	struct CounterGroup
+	{
+		bool opened = false;
+		bool valid = false;
+		int leaderFd = -1;
+		/**	file descriptor of each counter (-1 if it could not be opened)
+		 */
+		int fd[NB_COUNTERS];
+		/**	position of each counter in the group's read buffer (-1 if the
+		 *	counter could not be opened)
+		 */
+		int slot[NB_COUNTERS];
+		int nbOpened = 0;
+		int firstErrno = 0;
+
+		CounterGroup()
+		{
+			for (int k = 0; k < NB_COUNTERS; k++)
+				fd[k] = slot[k] = -1;
+		}
+
+		//	the members of the group first, then its leader
+		~CounterGroup()
+		{
+			for (int k = NB_COUNTERS - 1; k >= 0; k--)
+				if (fd[k] != -1)
+					close(fd[k]);
+		}
+	};
+
+	thread_local CounterGroup threadGroup;
+
+	long perfEventOpen(perf_event_attr* attr, int groupFd)
+	{
+		//	this thread, any CPU
+		return syscall(__NR_perf_event_open, attr, 0, -1, groupFd, 0);
+	}
+
+	void setCounterConfig(HardwareCounter counter, perf_event_attr& attr)
+	{
+		switch (counter)
+		{
+			case HardwareCounter::CYCLES:
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_CPU_CYCLES;
+				break;
+
+			case HardwareCounter::INSTRUCTIONS:
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+				break;
+
+			case HardwareCounter::L1D_MISSES:
+				attr.type = PERF_TYPE_HW_CACHE;
+				attr.config = PERF_COUNT_HW_CACHE_L1D |
+							  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+							  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+				break;
+
+			case HardwareCounter::LLC_MISSES:
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_CACHE_MISSES;
+				break;
+
+			case HardwareCounter::BRANCH_MISSES:
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	void openGroup(CounterGroup& group)
+	{
+		group.opened = true;
+		for (int k = 0; k < NB_COUNTERS; k++)
+		{
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			setCounterConfig(static_cast<HardwareCounter>(k), attr);
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP |
+							   PERF_FORMAT_TOTAL_TIME_ENABLED |
+							   PERF_FORMAT_TOTAL_TIME_RUNNING;
+			attr.disabled = (group.leaderFd == -1) ? 1 : 0;
+
+			int fd = static_cast<int>(perfEventOpen(&attr, group.leaderFd));
+			group.fd[k] = fd;
+			if (fd == -1)
+			{
+				group.slot[k] = -1;
+				if (group.firstErrno == 0)
+					group.firstErrno = errno;
+				//	without a cycle counter (the leader), there is no group
+				if (k == 0)
+					return;
+			}
+			else
+			{
+				if (group.leaderFd == -1)
+					group.leaderFd = fd;
+				group.slot[k] = group.nbOpened++;
+			}
+		}
+		ioctl(group.leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(group.leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		group.valid = true;
+	}
+}
+
+bool PerfCounters::enable()
+{
+	if (!threadGroup.opened)
+		openGroup(threadGroup);
+	if (!threadGroup.valid)
+	{
+		status_ = string("unavailable: ") + strerror(threadGroup.firstErrno);
+		enabled_ = false;
+		return false;
+	}
+
+	status_ = "available";
+	for (int k = 0; k < NB_COUNTERS; k++)
+	{
+		available_[k] = threadGroup.slot[k] != -1;
+		if (!available_[k])
+			status_ += string(" (no ") + COUNTER_NAME[k] + ")";
+	}
+	enabled_ = true;
+	return true;
+}
+
+bool PerfCounters::sample(CounterSample& sample)
+{
+	if (!threadGroup.opened)
+		openGroup(threadGroup);
+	if (!threadGroup.valid)
+		return false;
+
+	//	nr, time enabled, time running, then one value per opened counter
+	uint64_t buffer[3 + NB_COUNTERS];
+	ssize_t expected = static_cast<ssize_t>((3 + threadGroup.nbOpened) * sizeof(uint64_t));
+	if (read(threadGroup.leaderFd, buffer, sizeof(buffer)) < expected)
+		return false;
+
+	//	the kernel may have multiplexed the counters: extrapolate
+	double scale = (buffer[2] > 0 && buffer[2] < buffer[1]) ?
+						static_cast<double>(buffer[1]) / buffer[2] : 1.0;
+	for (int k = 0; k < NB_COUNTERS; k++)
+	{
+		int slot = threadGroup.slot[k];
+		sample.value[k] = slot == -1 ? 0 : static_cast<uint64_t>(buffer[3 + slot] * scale);
+	}
+	return true;
+}
+
+#else	//	not Linux
+
+bool PerfCounters::enable()
+{
+	status_ = "unavailable: perf_event_open is Linux-only";
+	enabled_ = false;
+	return false;
+}
+
+bool PerfCounters::sample(CounterSample& sample)
+{
+	(void) sample;
+	return false;
+}
+
+#endif
+
+bool PerfCounters::isAvailable(HardwareCounter counter)
+{
+	return available_[static_cast<int>(counter)];
+}
+
+const char* PerfCounters::getCounterName(HardwareCounter counter)
+{
+	return COUNTER_NAME[static_cast<int>(counter)];
+}
+
+const string& PerfCounters::getStatus()
+{
+	return status_;
+}
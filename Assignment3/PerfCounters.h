@@ -0,0 +1,84 @@
+//
+//  PerfCounters.h
+//  Week 08 - Earshooter
+//
+//	Optional hardware performance counters (Linux perf_event_open).  Once
+//	enabled, every ProfileScope samples the counters of its thread when it
+//	starts and ends, and the Profiler accumulates the differences per zone.
+//	On other platforms, or when the kernel refuses access to the counters
+//	(containers, perf_event_paranoid, VMs), enable() simply reports that
+//	they are unavailable and profiling goes on with wall time only.
+
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstdint>
+#include <string>
+
+namespace earshooter
+{
+	enum class HardwareCounter
+	{
+		CYCLES = 0,
+		INSTRUCTIONS,
+		L1D_MISSES,		//	L1 data cache read misses
+		LLC_MISSES,		//	last-level cache misses
+		BRANCH_MISSES,
+		//
+		NB_COUNTERS
+	};
+
+	/**	Values of all the counters at one point in time (or a difference
+	 *	between two such points).  Unavailable counters read 0.
+	 */
+	struct CounterSample
+	{
+		uint64_t value[static_cast<int>(HardwareCounter::NB_COUNTERS)];
+	};
+
+	struct PerfCounters
+	{
+		/**	Tries to open the counters for the calling thread and, if at least
+		 *	the cycle counter could be opened, turns on sampling in the
+		 *	ProfileScope objects.  Other threads open their own counters the
+		 *	first time they sample.
+		 *	@RETURN true if counters are available
+		 */
+		static bool enable();
+
+		/**	Reports whether ProfileScope objects sample counters
+		 */
+		inline static bool isEnabled()
+		{
+			return enabled_;
+		}
+
+		/**	Reports whether a given counter could be opened
+		 */
+		static bool isAvailable(HardwareCounter counter);
+
+		/**	Reads the current values of the calling thread's counters,
+		 *	scaled if the kernel had to multiplex them.
+		 *	@PARAM sample	receives the counter values
+		 *	@RETURN	true if the values could be read
+		 */
+		static bool sample(CounterSample& sample);
+
+		/**	Returns the display name of a counter
+		 */
+		static const char* getCounterName(HardwareCounter counter);
+
+		/**	Returns a description of the counters' state ("unavailable: ...")
+		 */
+		static const std::string& getStatus();
+
+		private:
+			static bool enabled_;
+			static bool available_[static_cast<int>(HardwareCounter::NB_COUNTERS)];
+			static std::string status_;
+
+			PerfCounters() = delete;
+	};
+}
+
+#endif	//	PERF_COUNTERS_H
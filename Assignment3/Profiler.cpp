@@ -0,0 +1,307 @@
+//
+//  Profiler.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cstdio>
+#include <iomanip>
+#include "Profiler.h"
+
+using namespace std;
+using namespace earshooter;
+
+const int NB_ZONES = static_cast<int>(ProfileZone::NB_ZONES);
+const int NB_COUNTERS = static_cast<int>(HardwareCounter::NB_COUNTERS);
+
+LatencyHistogram Profiler::histogram_[NB_ZONES];
+atomic<uint64_t> Profiler::counterTotal_[NB_ZONES][NB_COUNTERS];
+atomic<uint64_t> Profiler::items_[NB_ZONES];
+bool Profiler::drawHudLine_ = false;
+
+static const char* const ZONE_NAME[NB_ZONES] = {
+									"update",		//	UPDATE
+									"collision",	//	COLLISION
+									"spawn",		//	SPAWN
+									"draw",			//	DRAW
+									"HUD",			//	HUD
+									"capture"};		//	CAPTURE
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark LatencyHistogram
+//--------------------------------------
+#endif
+
+LatencyHistogram::LatencyHistogram()
+{
+	reset();
+}
+
+int LatencyHistogram::bucketIndex_(uint64_t value)
+{
+	if (value < SUB_BUCKETS)
+		return static_cast<int>(value);
+
+	//	floor(log2(value)), by dichotomy so that it works with any compiler
+	int e = 0;
+	for (int shift = 32; shift > 0; shift >>= 1)
+	{
+		if (value >> (e + shift))
+			e += shift;
+	}
+	if (e > MAX_EXPONENT)
+		return NB_BUCKETS - 1;
+
+	int sub = static_cast<int>((value >> (e - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+	return (e - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketValue_(int index)
+{
+	if (index < SUB_BUCKETS)
+		return static_cast<uint64_t>(index);
+
+	int e = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+	uint64_t sub = static_cast<uint64_t>(index % SUB_BUCKETS);
+	uint64_t width = uint64_t(1) << (e - SUB_BUCKET_BITS);
+	//	middle of the bucket
+	return (SUB_BUCKETS + sub) * width + width / 2;
+}
+
+void LatencyHistogram::record(uint64_t ns)
+{
+	bucket_[bucketIndex_(ns)].fetch_add(1, memory_order_relaxed);
+	count_.fetch_add(1, memory_order_relaxed);
+	sum_.fetch_add(ns, memory_order_relaxed);
+
+	uint64_t currentMax = max_.load(memory_order_relaxed);
+	while (ns > currentMax &&
+		   !max_.compare_exchange_weak(currentMax, ns, memory_order_relaxed))
+	{
+	}
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+	uint64_t count = getCount();
+	if (count == 0)
+		return 0;
+
+	uint64_t target = static_cast<uint64_t>(fraction * count + 0.5);
+	if (target < 1)
+		target = 1;
+
+	uint64_t seen = 0;
+	for (int k = 0; k < NB_BUCKETS; k++)
+	{
+		seen += bucket_[k].load(memory_order_relaxed);
+		if (seen >= target)
+		{
+			//	a bucket's middle value may overshoot the true max
+			uint64_t value = bucketValue_(k);
+			return value < getMax() ? value : getMax();
+		}
+	}
+	return getMax();
+}
+
+double LatencyHistogram::getMean() const
+{
+	uint64_t count = getCount();
+	return count > 0 ? static_cast<double>(sum_.load(memory_order_relaxed)) / count : 0.0;
+}
+
+void LatencyHistogram::reset()
+{
+	for (int k = 0; k < NB_BUCKETS; k++)
+		bucket_[k].store(0, memory_order_relaxed);
+	count_.store(0, memory_order_relaxed);
+	sum_.store(0, memory_order_relaxed);
+	max_.store(0, memory_order_relaxed);
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Profiler
+//--------------------------------------
+#endif
+
+void Profiler::record(ProfileZone zone, uint64_t ns)
+{
+	histogram_[static_cast<int>(zone)].record(ns);
+}
+
+const LatencyHistogram& Profiler::getHistogram(ProfileZone zone)
+{
+	return histogram_[static_cast<int>(zone)];
+}
+
+void Profiler::recordCounters(ProfileZone zone, const CounterSample& start,
+							  const CounterSample& end)
+{
+	int z = static_cast<int>(zone);
+	for (int k = 0; k < NB_COUNTERS; k++)
+	{
+		if (end.value[k] > start.value[k])
+			counterTotal_[z][k].fetch_add(end.value[k] - start.value[k], memory_order_relaxed);
+	}
+}
+
+void Profiler::recordItems(ProfileZone zone, uint64_t items)
+{
+	items_[static_cast<int>(zone)].fetch_add(items, memory_order_relaxed);
+}
+
+const char* Profiler::getZoneName(ProfileZone zone)
+{
+	return ZONE_NAME[static_cast<int>(zone)];
+}
+
+void Profiler::report(ostream& out)
+{
+	out << "-------------------------------------------------------------------" << endl;
+	out << left << setw(12) << "zone" << right
+		<< setw(10) << "count"
+		<< setw(12) << "mean (us)"
+		<< setw(11) << "p50 (us)"
+		<< setw(11) << "p99 (us)"
+		<< setw(11) << "max (us)" << endl;
+	out << fixed << setprecision(1);
+	for (int k = 0; k < NB_ZONES; k++)
+	{
+		const LatencyHistogram& hist = histogram_[k];
+		out << left << setw(12) << ZONE_NAME[k] << right
+			<< setw(10) << hist.getCount()
+			<< setw(12) << hist.getMean() / 1000.0
+			<< setw(11) << hist.percentile(0.50) / 1000.0
+			<< setw(11) << hist.percentile(0.99) / 1000.0
+			<< setw(11) << hist.getMax() / 1000.0 << endl;
+	}
+
+	//	Hardware counters, if any
+	if (PerfCounters::isEnabled())
+	{
+		out << endl << left << setw(12) << "zone" << right
+			<< setw(10) << "objects"
+			<< setw(8) << "IPC"
+			<< setw(15) << "L1D miss/obj"
+			<< setw(15) << "LLC miss/obj"
+			<< setw(16) << "br. miss/obj" << endl;
+		out << setprecision(2);
+		for (int k = 0; k < NB_ZONES; k++)
+		{
+			uint64_t cycles = counterTotal_[k][static_cast<int>(HardwareCounter::CYCLES)].load(memory_order_relaxed);
+			uint64_t items = items_[k].load(memory_order_relaxed);
+			out << left << setw(12) << ZONE_NAME[k] << right
+				<< setw(10) << items
+				<< setw(8) << (cycles > 0 ? static_cast<double>(
+							counterTotal_[k][static_cast<int>(HardwareCounter::INSTRUCTIONS)].load(memory_order_relaxed)) / cycles : 0.0);
+			for (HardwareCounter counter : {HardwareCounter::L1D_MISSES,
+											HardwareCounter::LLC_MISSES,
+											HardwareCounter::BRANCH_MISSES})
+			{
+				int width = counter == HardwareCounter::BRANCH_MISSES ? 16 : 15;
+				if (PerfCounters::isAvailable(counter) && items > 0)
+					out << setw(width) << static_cast<double>(
+						counterTotal_[k][static_cast<int>(counter)].load(memory_order_relaxed)) / items;
+				else
+					out << setw(width) << "-";
+			}
+			out << endl;
+		}
+	}
+	out << "hardware counters: " << PerfCounters::getStatus() << endl;
+
+	out << defaultfloat;
+	out << "-------------------------------------------------------------------" << endl;
+}
+
+void Profiler::writeJSON(ostream& out)
+{
+	out << "{\n  \"hardwareCounters\": \"" << PerfCounters::getStatus() << "\",\n";
+	out << "  \"zones\": [";
+	for (int k = 0; k < NB_ZONES; k++)
+	{
+		const LatencyHistogram& hist = histogram_[k];
+		uint64_t items = items_[k].load(memory_order_relaxed);
+		out << (k == 0 ? "\n" : ",\n")
+			<< "    {\"name\": \"" << ZONE_NAME[k] << "\""
+			<< ", \"count\": " << hist.getCount()
+			<< ", \"meanNs\": " << static_cast<uint64_t>(hist.getMean())
+			<< ", \"p50Ns\": " << hist.percentile(0.50)
+			<< ", \"p99Ns\": " << hist.percentile(0.99)
+			<< ", \"maxNs\": " << hist.getMax()
+			<< ", \"objects\": " << items;
+
+		if (PerfCounters::isEnabled())
+		{
+			uint64_t cycles = counterTotal_[k][static_cast<int>(HardwareCounter::CYCLES)].load(memory_order_relaxed);
+			uint64_t instructions = counterTotal_[k][static_cast<int>(HardwareCounter::INSTRUCTIONS)].load(memory_order_relaxed);
+			out << ", \"counters\": {";
+			for (int c = 0; c < NB_COUNTERS; c++)
+			{
+				out << (c == 0 ? "" : ", ") << "\"" << PerfCounters::getCounterName(static_cast<HardwareCounter>(c)) << "\": ";
+				if (PerfCounters::isAvailable(static_cast<HardwareCounter>(c)))
+					out << counterTotal_[k][c].load(memory_order_relaxed);
+				else
+					out << "null";
+			}
+			out << "}, \"ipc\": " << (cycles > 0 ? static_cast<double>(instructions) / cycles : 0.0);
+			out << ", \"missesPerObject\": {";
+			bool first = true;
+			for (HardwareCounter counter : {HardwareCounter::L1D_MISSES,
+											HardwareCounter::LLC_MISSES,
+											HardwareCounter::BRANCH_MISSES})
+			{
+				out << (first ? "" : ", ") << "\"" << PerfCounters::getCounterName(counter) << "\": ";
+				if (PerfCounters::isAvailable(counter) && items > 0)
+					out << static_cast<double>(counterTotal_[k][static_cast<int>(counter)].load(memory_order_relaxed)) / items;
+				else
+					out << "null";
+				first = false;
+			}
+			out << "}";
+		}
+		out << "}";
+	}
+	out << "\n  ]\n}\n";
+}
+
+string Profiler::getSummaryLine()
+{
+	string line = "p50/p99 (us):";
+	char buffer[64];
+	for (int k = 0; k < NB_ZONES; k++)
+	{
+		const LatencyHistogram& hist = histogram_[k];
+		snprintf(buffer, sizeof(buffer), "%s %s %.0f/%.0f", k == 0 ? "" : " |",
+				 ZONE_NAME[k],
+				 hist.percentile(0.50) / 1000.0,
+				 hist.percentile(0.99) / 1000.0);
+		line += buffer;
+	}
+	return line;
+}
+
+void Profiler::reset()
+{
+	for (int k = 0; k < NB_ZONES; k++)
+	{
+		histogram_[k].reset();
+		items_[k].store(0, memory_order_relaxed);
+		for (int c = 0; c < NB_COUNTERS; c++)
+			counterTotal_[k][c].store(0, memory_order_relaxed);
+	}
+}
+
+bool Profiler::hudLineIsDrawn()
+{
+	return drawHudLine_;
+}
+
+void Profiler::setDrawHudLine(bool draw)
+{
+	drawHudLine_ = draw;
+}
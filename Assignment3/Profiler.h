@@ -0,0 +1,235 @@
+//
+//  Profiler.h
+//  Week 08 - Earshooter
+//
+//	Lightweight scoped instrumentation of the simulation and rendering hot
+//	paths.  A ProfileScope object placed at the top of a block measures the
+//	time spent in that block (steady_clock) and feeds it into the lock-free
+//	histogram of its zone.  Percentiles are computed only when a report is
+//	requested.  When hardware counters are enabled (see PerfCounters.h),
+//	the scope also accumulates the counter deltas of its zone.
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "PerfCounters.h"
+#include "TraceRecorder.h"
+
+namespace earshooter
+{
+	/**	The instrumented phases of a simulation step or rendered frame.
+	 *	Note that zones can be nested: COLLISION time is also counted as
+	 *	part of UPDATE.
+	 */
+	enum class ProfileZone
+	{
+		UPDATE = 0,		//	update loop of the simulation
+		COLLISION,		//	collision scans of SpaceShip and Projectile
+		SPAWN,			//	asteroid spawning
+		DRAW,			//	draw passes of myDisplayFunc
+		HUD,			//	displayTextualInfo
+		CAPTURE,		//	read back of a captured frame
+		//
+		NB_ZONES
+	};
+
+	/**	HDR-style histogram of durations (in ns).  Values are stored in
+	 *	log-linear buckets: each power of 2 is split in 2^SUB_BUCKET_BITS
+	 *	sub-buckets, which bounds the relative error of a reported value
+	 *	to about 6%.  Recording a value is a couple of relaxed atomic
+	 *	increments, so it can be called from any thread without locking.
+	 */
+	class LatencyHistogram
+	{
+		private:
+			static const int SUB_BUCKET_BITS = 4;
+			static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+			/**	Largest power of 2 tracked (2^40 ns is about 18 minutes)
+			 */
+			static const int MAX_EXPONENT = 40;
+			static const int NB_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+			std::atomic<uint64_t> bucket_[NB_BUCKETS];
+			std::atomic<uint64_t> count_;
+			std::atomic<uint64_t> sum_;
+			std::atomic<uint64_t> max_;
+
+			static int bucketIndex_(uint64_t value);
+			static uint64_t bucketValue_(int index);
+
+		public:
+
+			LatencyHistogram();
+
+			/**	Adds a value to the histogram
+			 *	@PARAM ns	the duration to record, in nanoseconds
+			 */
+			void record(uint64_t ns);
+
+			/**	Returns the value (in ns) below which the given fraction of the
+			 *	recorded values lie.
+			 *	@PARAM fraction	percentile, in range [0, 1]
+			 *	@RETURN	the value at the requested percentile (0 if empty)
+			 */
+			uint64_t percentile(double fraction) const;
+
+			/**	Returns the number of values recorded
+			 */
+			inline uint64_t getCount() const
+			{
+				return count_.load(std::memory_order_relaxed);
+			}
+
+			/**	Returns the largest value recorded, in ns
+			 */
+			inline uint64_t getMax() const
+			{
+				return max_.load(std::memory_order_relaxed);
+			}
+
+			/**	Returns the mean value recorded, in ns
+			 */
+			double getMean() const;
+
+			/**	Clears all the recorded values.  Not atomic with respect to
+			 *	concurrent calls to record.
+			 */
+			void reset();
+
+			//	Disabled constructors & operators
+			LatencyHistogram(const LatencyHistogram&) = delete;
+			LatencyHistogram& operator = (const LatencyHistogram&) = delete;
+	};
+
+	/**	Application-wide set of zone histograms, in the same "struct of
+	 *	statics" spirit as MemoryTracker (shared by all the worlds of a batch).
+	 */
+	struct Profiler
+	{
+		/**	Records a duration for a zone
+		 *	@PARAM zone	the zone measured
+		 *	@PARAM ns	the duration, in nanoseconds
+		 */
+		static void record(ProfileZone zone, uint64_t ns);
+
+		/**	Returns the histogram of a zone
+		 */
+		static const LatencyHistogram& getHistogram(ProfileZone zone);
+
+		/**	Returns the display name of a zone
+		 */
+		static const char* getZoneName(ProfileZone zone);
+
+		/**	Accumulates hardware counter deltas for a zone
+		 *	@PARAM zone		the zone measured
+		 *	@PARAM start	counter values at the start of the zone
+		 *	@PARAM end		counter values at the end of the zone
+		 */
+		static void recordCounters(ProfileZone zone, const CounterSample& start,
+								   const CounterSample& end);
+
+		/**	Adds to the number of objects processed in a zone (the denominator
+		 *	of the per-object counter figures)
+		 */
+		static void recordItems(ProfileZone zone, uint64_t items);
+
+		/**	Prints the count, mean, p50, p99, and max of all zones, followed by
+		 *	the IPC and misses per object of each zone if hardware counters
+		 *	are enabled.
+		 *	@PARAM out	the stream to print into
+		 */
+		static void report(std::ostream& out);
+
+		/**	Writes the same information as report, as a JSON object
+		 *	@PARAM out	the stream to write into
+		 */
+		static void writeJSON(std::ostream& out);
+
+		/**	Builds the compact one-line summary (p50/p99 per zone) displayed
+		 *	on the HUD.
+		 */
+		static std::string getSummaryLine();
+
+		/**	Clears all histograms
+		 */
+		static void reset();
+
+		static bool hudLineIsDrawn();
+		static void setDrawHudLine(bool draw);
+
+		private:
+			static LatencyHistogram histogram_[static_cast<int>(ProfileZone::NB_ZONES)];
+			static std::atomic<uint64_t> counterTotal_[static_cast<int>(ProfileZone::NB_ZONES)]
+													  [static_cast<int>(HardwareCounter::NB_COUNTERS)];
+			static std::atomic<uint64_t> items_[static_cast<int>(ProfileZone::NB_ZONES)];
+			static bool drawHudLine_;
+
+			Profiler() = delete;
+	};
+
+	/**	RAII timer: measures the lifetime of the object and records it in
+	 *	the histogram of its zone, and in the trace if a capture is running.
+	 */
+	class ProfileScope
+	{
+		private:
+			ProfileZone zone_;
+			uint64_t items_;
+			bool countersRead_;
+			CounterSample startCounters_;
+			std::chrono::steady_clock::time_point start_;
+
+		public:
+			/**	Starts timing a zone
+			 *	@PARAM zone		the zone measured
+			 *	@PARAM items	number of objects processed in this run of the zone
+			 *					(used to report counter values per object)
+			 */
+			explicit inline ProfileScope(ProfileZone zone, uint64_t items = 0)
+				:	zone_(zone),
+					items_(items),
+					countersRead_(PerfCounters::isEnabled() && PerfCounters::sample(startCounters_)),
+					start_(std::chrono::steady_clock::now())
+			{
+			}
+
+			/**	Adds to the number of objects processed, when it is only
+			 *	known as the zone runs
+			 */
+			inline void addItems(uint64_t items)
+			{
+				items_ += items;
+			}
+
+			inline ~ProfileScope()
+			{
+				auto elapsed = std::chrono::steady_clock::now() - start_;
+				uint64_t ns = static_cast<uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+				Profiler::record(zone_, ns);
+				if (items_ > 0)
+					Profiler::recordItems(zone_, items_);
+				if (countersRead_)
+				{
+					CounterSample endCounters;
+					if (PerfCounters::sample(endCounters))
+						Profiler::recordCounters(zone_, startCounters_, endCounters);
+				}
+				if (TraceRecorder::isRecording())
+					TraceRecorder::record(Profiler::getZoneName(zone_), "zone",
+										  TraceRecorder::toNs(start_), ns);
+			}
+
+			//	Disabled constructors & operators
+			ProfileScope() = delete;
+			ProfileScope(const ProfileScope&) = delete;
+			ProfileScope& operator = (const ProfileScope&) = delete;
+	};
+}
+
+#endif	//	PROFILER_H
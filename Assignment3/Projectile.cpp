@@ -2,22 +2,28 @@
 #include "Projectile.h"
 #include "BoundingBox.h"
 #include "glPlatform.h"
+#include "Profiler.h"
 #include <iostream> // For debugging output if needed
 #include <cmath>
 
 using namespace std;
 using namespace earshooter;
 
-// Initialize static counters and object list pointer
-unsigned int Projectile::count_ = 0;
-unsigned int Projectile::liveCount_ = 0;
-const std::list<std::shared_ptr<GraphicObject2D>>* Projectile::objList_ = nullptr;
+// Initialize static counters
+atomic<unsigned int> Projectile::count_(0);
+atomic<unsigned int> Projectile::liveCount_(0);
+
+// Corners of the square of side 1 centered at the origin, scaled at drawing time
+static const float UNIT_SQUARE[4][2] = {{-0.5f, -0.5f}, {+0.5f, -0.5f},
+                                        {+0.5f, +0.5f}, {-0.5f, +0.5f}};
 
 // Constructor for creating a projectile with specified parameters
 Projectile::Projectile(float centerX, float centerY, float angle, float width, float height,
     float r, float g, float b, bool drawContour, float vx, float vy, float spin, float lifetime)
     : GraphicObject2D(centerX, centerY, angle, r, g, b, drawContour, vx, vy, spin),
     width_(width), height_(height), lifetime_(lifetime), index_(count_++) {
+    MemoryScope memoryScope(MemoryCategory::PROJECTILE);
+
     updateRelativeBox_();
     updateAbsoluteBox_();
     liveCount_++;
@@ -29,17 +35,10 @@ Projectile::~Projectile() {
 }
 
 // Draw the projectile as a scaled square
-void Projectile::draw_() const {
-    glPushMatrix();
-    glScalef(width_, height_, 1.f); // Scale based on width and height
-    glColor3f(getR(), getG(), getB()); // Set color
-    glBegin(GL_POLYGON); // Draw square
-    glVertex2f(-0.5f, -0.5f);
-    glVertex2f(+0.5f, -0.5f);
-    glVertex2f(+0.5f, +0.5f);
-    glVertex2f(-0.5f, +0.5f);
-    glEnd();
-    glPopMatrix();
+void Projectile::draw_(Renderer2D& renderer, const Transform2D& transform) const {
+    // Scale based on width and height
+    renderer.addShape(RenderBatch::PROJECTILE, transform.scaled(width_, height_),
+                      UnitShape::SQUARE, UNIT_SQUARE, 4, false, getR(), getG(), getB());
 }
 
 // Check if a point (x, y) is inside the projectile's bounds
@@ -80,11 +79,20 @@ UpdateStatus Projectile::update(float dt) {
         return UpdateStatus::DEAD;
     }
 
-    // Check for collisions with generic objects in the object list
-    for (const auto& obj : *objList_) {
-        if (obj && obj.get() != this && obj->getObjectType() == ObjectType::Generic &&
-            this->getAbsoluteBoundingBox().intersects(obj->getAbsoluteBoundingBox())) {
-            obj->setDead(true); // Mark the object as dead on collision
+    // Check for collisions with generic objects of the projectile's world
+    // (only those of the sectors around it)
+    if (getWorld() != nullptr) {
+        bool hit = false;
+        ProfileScope collisionScope(ProfileZone::COLLISION);
+        collisionScope.addItems(getWorld()->forEachObjectNear(getX(), getY(), [this, &hit](GraphicObject2D& obj) {
+            if (&obj != this && obj.getObjectType() == ObjectType::Generic &&
+                this->getAbsoluteBoundingBox().intersects(obj.getAbsoluteBoundingBox())) {
+                obj.setDead(true); // Mark the object as dead on collision
+                hit = true;
+            }
+            return !hit;
+        }));
+        if (hit) {
             return UpdateStatus::DEAD;
         }
     }
@@ -94,16 +102,11 @@ UpdateStatus Projectile::update(float dt) {
     return GraphicObject2D::update(dt);
 }
 
-// Set the object list pointer for collision detection
-void Projectile::setObjectList(const std::list<std::shared_ptr<GraphicObject2D>>* objListPtr) {
-    objList_ = objListPtr;
-}
-
-// Static function to create and add a new projectile to the object list
-void Projectile::createProjectile(float x, float y, float angle, float vx, float vy, float lifetime) {
-    if (!objList_) return; // Ensure object list is set
-    auto projectile = std::make_shared<Projectile>(x, y, angle, 0.1f, 0.1f, 1.0f, 1.0f, 1.0f, false, vx, vy, 0.0f, lifetime);
-    const_cast<std::list<std::shared_ptr<GraphicObject2D>>*>(objList_)->push_back(projectile); // Add to list
+// Static function to create and add a new projectile to a world
+void Projectile::createProjectile(World2D& world, float x, float y, float angle, float vx, float vy,
+                                  float lifetime) {
+    auto projectile = makeTracked<Projectile, MemoryCategory::PROJECTILE>(x, y, angle, 0.1f, 0.1f, 1.0f, 1.0f, 1.0f, false, vx, vy, 0.0f, lifetime);
+    world.addObject(projectile); // Add to the world's list
 }
 
 // Get the unique index of the projectile
@@ -25,19 +25,16 @@ namespace earshooter {
         unsigned int index_;
 
         /** Counter for the total number of projectiles created */
-        static unsigned int count_;
+        static std::atomic<unsigned int> count_;
 
         /** Counter for the number of active projectiles */
-        static unsigned int liveCount_;
-
-        /** Pointer to the list of all objects, used for collision detection */
-        static const std::list<std::shared_ptr<GraphicObject2D>>* objList_;
+        static std::atomic<unsigned int> liveCount_;
 
         /** Private rendering function for the Projectile class.
          * Translation and rotation are applied by the root class,
          * so this function only applies scaling before rendering.
          */
-        void draw_() const override;
+        void draw_(Renderer2D& renderer, const Transform2D& transform) const override;
 
         /** Updates the relative bounding box of the projectile */
         void updateRelativeBox_();
@@ -127,13 +124,8 @@ namespace earshooter {
         UpdateStatus update(float dt) override;
 
         /**
-         * @brief Sets the global object list used for collision detection.
-         * @param objListPtr Pointer to the global object list
-         */
-        static void setObjectList(const std::list<std::shared_ptr<GraphicObject2D>>* objListPtr);
-
-        /**
-         * @brief Creates a new projectile with given properties and adds it to the object list.
+         * @brief Creates a new projectile with given properties and adds it to a world.
+         * @param world World the projectile is added to (and collides in)
          * @param x X-coordinate of the new projectile
          * @param y Y-coordinate of the new projectile
          * @param angle Orientation angle of the new projectile
@@ -141,7 +133,8 @@ namespace earshooter {
          * @param vy Y component of the initial velocity vector
          * @param lifetime Duration the projectile will remain active
          */
-        static void createProjectile(float x, float y, float angle, float vx, float vy, float lifetime);
+        static void createProjectile(World2D& world, float x, float y, float angle, float vx, float vy,
+                                     float lifetime);
     };
 }
 
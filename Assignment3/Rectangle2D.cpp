@@ -14,8 +14,12 @@
 using namespace std;
 using namespace earshooter;
 
-unsigned int Rectangle2D::count_ = 0;
-unsigned int Rectangle2D::liveCount_ = 0;
+atomic<unsigned int> Rectangle2D::count_(0);
+atomic<unsigned int> Rectangle2D::liveCount_(0);
+
+//	Corners of the square of side 1 centered at the origin, scaled at drawing time
+static const float UNIT_SQUARE[4][2] = {{-0.5f, -0.5f}, {+0.5f, -0.5f},
+										{+0.5f, +0.5f}, {-0.5f, +0.5f}};
 
 #if 0
 //--------------------------------------
@@ -32,6 +36,8 @@ Rectangle2D::Rectangle2D(float centerX, float centerY, float angle, float width,
 		height_(height),
 		index_(count_++)
 {
+	MemoryScope memoryScope(MemoryCategory::RECTANGLE);
+
 	updateRelativeBox_();
 	updateAbsoluteBox_();
 	liveCount_++;
@@ -78,36 +84,13 @@ Rectangle2D::~Rectangle2D()
 //-----------------------------------------
 #endif
 
-void Rectangle2D::draw_() const
+void Rectangle2D::draw_(Renderer2D& renderer, const Transform2D& transform) const
 {
 	float r = getR(), g = getG(), b = getB();
 	
-	//	save the current coordinate system (origin, axes)
-	glPushMatrix();
-	
-	glScalef(width_, height_, 1.f);
-	
-	glColor3f(r, g, b);
-	glBegin(GL_POLYGON);
-		glVertex2f(-0.5f, -0.5f);
-		glVertex2f(+0.5f, -0.5f);
-		glVertex2f(+0.5f, +0.5f);
-		glVertex2f(-0.5f, +0.5f);
-	glEnd();
-	
-	if (getDrawContour())
-	{
-		glColor3f(1.f - r, 1.f - g, 1.f - b);
-		glBegin(GL_LINE_LOOP);
-			glVertex2f(-0.5f, -0.5f);
-			glVertex2f(+0.5f, -0.5f);
-			glVertex2f(+0.5f, +0.5f);
-			glVertex2f(-0.5f, +0.5f);
-		glEnd();
-	}
-	
-	//	restore the original scale
-	glPopMatrix();
+	Transform2D scaled = transform.scaled(width_, height_);
+	renderer.addShape(RenderBatch::RECTANGLE, scaled, UnitShape::SQUARE,
+					  UNIT_SQUARE, 4, getDrawContour(), r, g, b);
 }
 
 bool Rectangle2D::isInside(float x, float y) const
@@ -132,16 +115,21 @@ void Rectangle2D::updateRelativeBox_() {
 
 void Rectangle2D::updateAbsoluteBox_()
 {
-	// Center position and angle in radians
-	float cx = getX();
-	float cy = getY();
-	float radAngle = M_PI * getAngle() / 180.f;
+	BoundingBox box = computeAbsoluteBox(getX(), getY(), getAngle(), width_, height_);
+	setAbsoluteBoundingBox(box.getXmin(), box.getXmax(), box.getYmin(), box.getYmax());
+}
+
+BoundingBox Rectangle2D::computeAbsoluteBox(float cx, float cy, float angle,
+											float width, float height)
+{
+	// Angle in radians
+	float radAngle = M_PI * angle / 180.f;
 	float cosA = cosf(radAngle);
 	float sinA = sinf(radAngle);
 
 	// Half-dimensions
-	float halfWidth = width_ / 2;
-	float halfHeight = height_ / 2;
+	float halfWidth = width / 2;
+	float halfHeight = height / 2;
 
 	// Calculate rotated corner positions
 	float x1 = cx + (-halfWidth * cosA - -halfHeight * sinA);
@@ -170,8 +158,7 @@ void Rectangle2D::updateAbsoluteBox_()
 	if (x4 < minX) minX = x4; if (x4 > maxX) maxX = x4;
 	if (y4 < minY) minY = y4; if (y4 > maxY) maxY = y4;
 
-	// Set the absolute bounding box with the calculated min and max
-	setAbsoluteBoundingBox(minX, maxX, minY, maxY);
+	return BoundingBox(minX, maxX, minY, maxY);
 }
 
 
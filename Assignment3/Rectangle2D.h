@@ -29,16 +29,16 @@ namespace earshooter
 		unsigned int index_;
 
 		/** Counter for the number of Rectangle2D objects created */
-		static unsigned int count_;
+		static std::atomic<unsigned int> count_;
 
 		/** Counter for the number of Rectangle2D objects still "alive" */
-		static unsigned int liveCount_;
+		static std::atomic<unsigned int> liveCount_;
 
 		/** Private rendering function for the Rectangle2D class.
 		 * Translation and rotation have already been applied by the root class,
 		 * so this function only applies scaling before rendering.
 		 */
-		void draw_() const override;
+		void draw_(Renderer2D& renderer, const Transform2D& transform) const override;
 
 		/** Updates the relative bounding box of the rectangle */
 		void updateRelativeBox_();
@@ -128,6 +128,18 @@ namespace earshooter
 		 */
 		bool isInside(float x, float y) const override;
 
+		/** Computes the absolute bounding box of a rectangle in a given pose
+		 * (the one updateAbsoluteBox_ sets, also used by WorldBatch).
+		 * @param cx X-coordinate of the rectangle's center
+		 * @param cy Y-coordinate of the rectangle's center
+		 * @param angle Orientation of the rectangle (in degrees)
+		 * @param width Width of the rectangle
+		 * @param height Height of the rectangle
+		 * @return The box of the rectangle's corners
+		 */
+		static BoundingBox computeAbsoluteBox(float cx, float cy, float angle,
+											  float width, float height);
+
 		/** Returns the total number of Rectangle2D objects created.
 		 * @return Total count of Rectangle2D objects created
 		 */
@@ -0,0 +1,261 @@
+//
+//  RenderCommandBuffer.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include "RenderCommandBuffer.h"
+
+using namespace std;
+using namespace earshooter;
+
+const int NB_BATCHES = static_cast<int>(RenderBatch::NB_BATCHES);
+
+//	Submission order of the commands: by batch, then in recording order
+bool isDrawnBefore(const RenderCommand& c1, const RenderCommand& c2);
+bool haveSameState(const RenderCommand& c1, const RenderCommand& c2);
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+RenderCommandBuffer::RenderCommandBuffer()
+	:	isSorted_(true),
+		stateChangeCount_(0)
+{
+	for (int k = 0; k < NB_BATCHES; k++)
+		lineWidth_[k] = -1.f;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Recording
+//--------------------------------------
+#endif
+
+RenderCommand& RenderCommandBuffer::record_(RenderBatch batch, RenderCommandKind kind,
+											const Transform2D& transform, const void* mesh,
+											const float (*xy)[2], int nbPts,
+											float r, float g, float b)
+{
+	RenderCommand command;
+	command.sequence = static_cast<uint32_t>(command_.size());
+	command.batch = batch;
+	command.kind = kind;
+	command.shape = UnitShape::NB_SHAPES;
+	command.contour = false;
+	packColor_(r, g, b, command.rgba);
+	command.transform = transform;
+	command.mesh = mesh;
+	command.firstVertex = static_cast<uint32_t>(vertices_.size() / 2);
+	command.nbPts = nbPts;
+	if (mesh == nullptr)
+		for (int k = 0; k < nbPts; k++)
+		{
+			vertices_.push_back(xy[k][0]);
+			vertices_.push_back(xy[k][1]);
+		}
+	command_.push_back(command);
+	isSorted_ = false;
+	return command_.back();
+}
+
+void RenderCommandBuffer::addPolygon(RenderBatch batch, const Transform2D& transform,
+									 const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	record_(batch, RenderCommandKind::POLYGON, transform, nullptr, xy, nbPts, r, g, b);
+}
+
+void RenderCommandBuffer::addTriangles(RenderBatch batch, const Transform2D& transform,
+									   const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	record_(batch, RenderCommandKind::TRIANGLES, transform, nullptr, xy, nbPts, r, g, b);
+}
+
+void RenderCommandBuffer::addLineLoop(RenderBatch batch, const Transform2D& transform,
+									  const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	record_(batch, RenderCommandKind::LINE_LOOP, transform, nullptr, xy, nbPts, r, g, b);
+}
+
+void RenderCommandBuffer::addLineStrip(RenderBatch batch, const Transform2D& transform,
+									   const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	record_(batch, RenderCommandKind::LINE_STRIP, transform, nullptr, xy, nbPts, r, g, b);
+}
+
+void RenderCommandBuffer::addMeshFill(RenderBatch batch, const Transform2D& transform,
+									  const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	record_(batch, RenderCommandKind::MESH_FILL, transform, xy, xy, nbPts, r, g, b);
+}
+
+void RenderCommandBuffer::addMeshOutline(RenderBatch batch, const Transform2D& transform,
+										 const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	record_(batch, RenderCommandKind::MESH_OUTLINE, transform, xy, xy, nbPts, r, g, b);
+}
+
+void RenderCommandBuffer::addMesh(RenderBatch batch, const Transform2D& transform,
+								  const BatchMesh& mesh, float r, float g, float b)
+{
+	record_(batch, RenderCommandKind::MESH, transform, &mesh, nullptr, 0, r, g, b);
+}
+
+void RenderCommandBuffer::addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+								   const float (*xy)[2], int nbPts, bool contour,
+								   float r, float g, float b)
+{
+	RenderCommand& command = record_(batch, RenderCommandKind::SHAPE, transform, xy, xy, nbPts,
+									 r, g, b);
+	command.shape = shape;
+	command.contour = contour;
+}
+
+void RenderCommandBuffer::addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+								   const BatchMesh& mesh, float r, float g, float b)
+{
+	RenderCommand& command = record_(batch, RenderCommandKind::SHAPE, transform, &mesh, nullptr, 0,
+									 r, g, b);
+	command.shape = shape;
+}
+
+void RenderCommandBuffer::setLineWidth(RenderBatch batch, float width)
+{
+	lineWidth_[static_cast<int>(batch)] = width;
+}
+
+void RenderCommandBuffer::append(const RenderCommandBuffer& other)
+{
+	uint32_t sequenceOffset = static_cast<uint32_t>(command_.size());
+	uint32_t vertexOffset = static_cast<uint32_t>(vertices_.size() / 2);
+	for (RenderCommand command : other.command_)
+	{
+		command.sequence += sequenceOffset;
+		command.firstVertex += vertexOffset;
+		command_.push_back(command);
+	}
+	vertices_.insert(vertices_.end(), other.vertices_.begin(), other.vertices_.end());
+	for (int k = 0; k < NB_BATCHES; k++)
+		if (other.lineWidth_[k] >= 0.f)
+			lineWidth_[k] = other.lineWidth_[k];
+	isSorted_ = isSorted_ && other.command_.empty();
+}
+
+void RenderCommandBuffer::clear()
+{
+	command_.clear();
+	vertices_.clear();
+	for (int k = 0; k < NB_BATCHES; k++)
+		lineWidth_[k] = -1.f;
+	isSorted_ = true;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Submission
+//--------------------------------------
+#endif
+
+void RenderCommandBuffer::flush()
+{
+	if (!isSorted_)
+		sort(command_.begin(), command_.end(), isDrawnBefore);
+	isSorted_ = true;
+
+	stateChangeCount_ = 0;
+	for (size_t k = 0; k < command_.size(); k++)
+		if (k == 0 || !haveSameState(command_[k-1], command_[k]))
+			stateChangeCount_++;
+}
+
+void RenderCommandBuffer::submit(Renderer2D& target)
+{
+	flush();
+
+	for (int k = 0; k < NB_BATCHES; k++)
+		if (lineWidth_[k] >= 0.f)
+			target.setLineWidth(static_cast<RenderBatch>(k), lineWidth_[k]);
+
+	const float (*vertices)[2] = reinterpret_cast<const float (*)[2]>(vertices_.data());
+	for (const RenderCommand& command : command_)
+	{
+		float r = command.rgba[0] / 255.f;
+		float g = command.rgba[1] / 255.f;
+		float b = command.rgba[2] / 255.f;
+		const float (*xy)[2] = (command.mesh != nullptr) ?
+								static_cast<const float (*)[2]>(command.mesh) :
+								vertices + command.firstVertex;
+		switch (command.kind)
+		{
+			case RenderCommandKind::POLYGON:
+				target.addPolygon(command.batch, command.transform, xy, command.nbPts, r, g, b);
+				break;
+
+			case RenderCommandKind::TRIANGLES:
+				target.addTriangles(command.batch, command.transform, xy, command.nbPts, r, g, b);
+				break;
+
+			case RenderCommandKind::MESH_FILL:
+				target.addMeshFill(command.batch, command.transform, xy, command.nbPts, r, g, b);
+				break;
+
+			case RenderCommandKind::MESH:
+				target.addMesh(command.batch, command.transform,
+							   *static_cast<const BatchMesh*>(command.mesh), r, g, b);
+				break;
+
+			case RenderCommandKind::SHAPE:
+				if (command.nbPts == 0)
+					target.addShape(command.batch, command.transform, command.shape,
+									*static_cast<const BatchMesh*>(command.mesh), r, g, b);
+				else
+					target.addShape(command.batch, command.transform, command.shape, xy,
+									command.nbPts, command.contour, r, g, b);
+				break;
+
+			case RenderCommandKind::MESH_OUTLINE:
+				target.addMeshOutline(command.batch, command.transform, xy, command.nbPts, r, g, b);
+				break;
+
+			case RenderCommandKind::LINE_LOOP:
+				target.addLineLoop(command.batch, command.transform, xy, command.nbPts, r, g, b);
+				break;
+
+			case RenderCommandKind::LINE_STRIP:
+				target.addLineStrip(command.batch, command.transform, xy, command.nbPts, r, g, b);
+				break;
+		}
+	}
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Free functions
+//--------------------------------------
+#endif
+
+//	Basic shapes are grouped by shape, whatever their tessellation
+bool haveSameState(const RenderCommand& c1, const RenderCommand& c2)
+{
+	if (c1.batch != c2.batch || c1.kind != c2.kind)
+		return false;
+	if (c1.kind == RenderCommandKind::SHAPE)
+		return c1.shape == c2.shape;
+	return c1.mesh == c2.mesh;
+}
+
+//	Ordering by kind or mesh too would put all the fills of a batch under
+//	all its lines, and disks by the address of their level of detail.
+bool isDrawnBefore(const RenderCommand& c1, const RenderCommand& c2)
+{
+	if (c1.batch != c2.batch)
+		return c1.batch < c2.batch;
+	return c1.sequence < c2.sequence;
+}
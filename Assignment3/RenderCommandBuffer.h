@@ -0,0 +1,149 @@
+//
+//  RenderCommandBuffer.h
+//  Week 08 - Earshooter
+//
+//	Implementation of Renderer2D that doesn't draw anything: it records what
+//	the objects draw as compact commands (kind of primitive, batch,
+//	transformation, color, and geometry), to be submitted later to the
+//	renderer that does the drawing.  Recording a frame is thus separate from
+//	submitting it:
+//		- the scene can be traversed in parallel, each thread recording into
+//		  its own buffer, and the buffers appended to one another afterwards;
+//		- before submission, the commands are sorted by batch, the order in
+//		  which the renderers draw the batches anyway.  Within a batch, the
+//		  commands keep the order in which they were recorded, so that
+//		  overlapping objects are still drawn in list order: grouping the
+//		  primitives of a batch by type is left to the renderer, which
+//		  keeps that order while doing it.
+//	Instances of unit and baked meshes, and basic shapes, only record a
+//	pointer to their geometry (which must outlive the frame anyway).  The
+//	vertices of the other primitives are copied, since they may come from a
+//	local array.
+
+#ifndef RENDER_COMMAND_BUFFER_H
+#define RENDER_COMMAND_BUFFER_H
+
+#include <cstdint>
+#include <vector>
+#include "Renderer2D.h"
+
+namespace earshooter
+{
+	/**	Kinds of recorded commands
+	 */
+	enum class RenderCommandKind : uint8_t
+	{
+		POLYGON = 0,
+		TRIANGLES,
+		MESH_FILL,
+		MESH,
+		SHAPE,
+		MESH_OUTLINE,
+		LINE_LOOP,
+		LINE_STRIP
+	};
+
+	/**	A recorded drawing command
+	 */
+	struct RenderCommand
+	{
+		uint32_t sequence;			//	recording order
+		RenderBatch batch;
+		RenderCommandKind kind;
+		UnitShape shape;			//	for SHAPE commands
+		bool contour;				//	for SHAPE commands
+		uint8_t rgba[4];
+		Transform2D transform;
+		const void* mesh;			//	unit mesh vertices or BatchMesh, if any
+		uint32_t firstVertex;		//	copied vertices, otherwise
+		int nbPts;					//	0 for a BatchMesh
+	};
+
+	class RenderCommandBuffer : public Renderer2D
+	{
+		private:
+
+			std::vector<RenderCommand> command_;
+
+			/**	Copied vertices of the commands, x and y interleaved
+			 */
+			std::vector<float> vertices_;
+
+			/**	Line width of each batch (negative if never set)
+			 */
+			float lineWidth_[static_cast<int>(RenderBatch::NB_BATCHES)];
+
+			bool isSorted_;
+			unsigned int stateChangeCount_;
+
+			RenderCommand& record_(RenderBatch batch, RenderCommandKind kind,
+								   const Transform2D& transform, const void* mesh,
+								   const float (*xy)[2], int nbPts, float r, float g, float b);
+
+		public:
+
+			RenderCommandBuffer();
+			~RenderCommandBuffer() = default;
+
+			void addPolygon(RenderBatch batch, const Transform2D& transform,
+							const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addTriangles(RenderBatch batch, const Transform2D& transform,
+							  const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addLineLoop(RenderBatch batch, const Transform2D& transform,
+							 const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addLineStrip(RenderBatch batch, const Transform2D& transform,
+							  const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addMeshFill(RenderBatch batch, const Transform2D& transform,
+							 const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addMeshOutline(RenderBatch batch, const Transform2D& transform,
+								const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addMesh(RenderBatch batch, const Transform2D& transform, const BatchMesh& mesh,
+						 float r, float g, float b) override;
+			void addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+						  const float (*xy)[2], int nbPts, bool contour,
+						  float r, float g, float b) override;
+			void addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+						  const BatchMesh& mesh, float r, float g, float b) override;
+			void setLineWidth(RenderBatch batch, float width) override;
+
+			/**	Ends the recording of a frame: sorts the commands by batch.
+			 *	Nothing gets drawn until submit is called.
+			 */
+			void flush() override;
+
+			/**	Appends the commands recorded by another buffer (e.g. by another
+			 *	thread, for a later part of the scene) after the ones of this
+			 *	buffer
+			 */
+			void append(const RenderCommandBuffer& other);
+
+			/**	Sends all the commands, sorted by batch, to a renderer.  The
+			 *	renderer is not flushed, and the buffer keeps its commands
+			 *	(e.g. to redraw the same frame) until it is cleared.
+			 */
+			void submit(Renderer2D& target);
+
+			/**	Discards all the commands recorded
+			 */
+			void clear();
+
+			inline unsigned int getCommandCount() const
+			{
+				return static_cast<unsigned int>(command_.size());
+			}
+
+			/**	Number of runs of commands with the same state (batch, kind
+			 *	of primitive, and mesh) in the last sorted frame
+			 */
+			inline unsigned int getStateChangeCount() const
+			{
+				return stateChangeCount_;
+			}
+
+			//	Disabled constructors & operators
+			RenderCommandBuffer(const RenderCommandBuffer&) = delete;
+			RenderCommandBuffer& operator = (const RenderCommandBuffer&) = delete;
+	};
+}
+
+#endif	//	RENDER_COMMAND_BUFFER_H
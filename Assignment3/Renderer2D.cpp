@@ -0,0 +1,167 @@
+//
+//  Renderer2D.cpp
+//  Week 08 - Earshooter
+//
+
+#include "Renderer2D.h"
+
+using namespace std;
+using namespace earshooter;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Default implementations
+//--------------------------------------
+#endif
+
+void Renderer2D::packColor_(float r, float g, float b, uint8_t rgba[4])
+{
+	float rgb[3] = {r, g, b};
+	for (int k = 0; k < 3; k++)
+	{
+		float c = rgb[k] < 0.f ? 0.f : (rgb[k] > 1.f ? 1.f : rgb[k]);
+		rgba[k] = static_cast<uint8_t>(c * 255.f + 0.5f);
+	}
+	rgba[3] = 255;
+}
+
+void Renderer2D::addMeshFill(RenderBatch batch, const Transform2D& transform,
+							 const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	addPolygon(batch, transform, xy, nbPts, r, g, b);
+}
+
+void Renderer2D::addMeshOutline(RenderBatch batch, const Transform2D& transform,
+								const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	addLineLoop(batch, transform, xy, nbPts, r, g, b);
+}
+
+void Renderer2D::addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+						  const float (*xy)[2], int nbPts, bool contour,
+						  float r, float g, float b)
+{
+	if (shape == UnitShape::DISK)
+	{
+		addMeshFill(batch, transform, xy, nbPts, r, g, b);
+		if (contour)
+			addMeshOutline(batch, transform, xy, nbPts, 1.f - r, 1.f - g, 1.f - b);
+	}
+	else
+	{
+		addPolygon(batch, transform, xy, nbPts, r, g, b);
+		if (contour)
+			addLineLoop(batch, transform, xy, nbPts, 1.f - r, 1.f - g, 1.f - b);
+	}
+}
+
+void Renderer2D::addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+						  const BatchMesh& mesh, float r, float g, float b)
+{
+	(void) shape;
+	addMesh(batch, transform, mesh, r, g, b);
+}
+
+void Renderer2D::addMesh(RenderBatch batch, const Transform2D& transform,
+						 const BatchMesh& mesh, float r, float g, float b)
+{
+	//	All the vertices of a triangle (or segment) share the same color, so
+	//	each one is added with the resolved color of its first vertex.
+	const int NB_SOURCES = 2;
+	const vector<MeshVertex>* source[NB_SOURCES] = {&mesh.getFill(), &mesh.getLines()};
+	const size_t stride[NB_SOURCES] = {3, 2};
+	float xy[3][2];
+	for (int s = 0; s < NB_SOURCES; s++)
+	{
+		const vector<MeshVertex>& vertices = *source[s];
+		for (size_t k = 0; k + stride[s] <= vertices.size(); k += stride[s])
+		{
+			const MeshVertex& first = vertices[k];
+			for (size_t i = 0; i < stride[s]; i++)
+			{
+				xy[i][0] = vertices[k+i].x;
+				xy[i][1] = vertices[k+i].y;
+			}
+			float vr = first.rgba[0] / 255.f + first.tint * r;
+			float vg = first.rgba[1] / 255.f + first.tint * g;
+			float vb = first.rgba[2] / 255.f + first.tint * b;
+			if (s == 0)
+				addTriangles(batch, transform, xy, 3, vr, vg, vb);
+			else
+				addLineStrip(batch, transform, xy, 2, vr, vg, vb);
+		}
+	}
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Baked meshes
+//--------------------------------------
+#endif
+
+inline void BatchMesh::pushVertex_(vector<MeshVertex>& vertices,
+								   const Transform2D& transform, float x, float y,
+								   const uint8_t rgba[4], float tint)
+{
+	MeshVertex v;
+	transform.apply(x, y, v.x, v.y);
+	for (int k = 0; k < 4; k++)
+		v.rgba[k] = rgba[k];
+	v.tint = tint;
+	vertices.push_back(v);
+}
+
+void BatchMesh::addPolygon(const Transform2D& transform, const float (*xy)[2], int nbPts,
+						   float r, float g, float b, float tint)
+{
+	uint8_t rgba[4];
+	Renderer2D::packColor_(r, g, b, rgba);
+	for (int k = 2; k < nbPts; k++)
+	{
+		pushVertex_(fill_, transform, xy[0][0], xy[0][1], rgba, tint);
+		pushVertex_(fill_, transform, xy[k-1][0], xy[k-1][1], rgba, tint);
+		pushVertex_(fill_, transform, xy[k][0], xy[k][1], rgba, tint);
+	}
+}
+
+void BatchMesh::addTriangles(const Transform2D& transform, const float (*xy)[2], int nbPts,
+							 float r, float g, float b, float tint)
+{
+	uint8_t rgba[4];
+	Renderer2D::packColor_(r, g, b, rgba);
+	for (int k = 0; k + 2 < nbPts; k += 3)
+	{
+		pushVertex_(fill_, transform, xy[k][0], xy[k][1], rgba, tint);
+		pushVertex_(fill_, transform, xy[k+1][0], xy[k+1][1], rgba, tint);
+		pushVertex_(fill_, transform, xy[k+2][0], xy[k+2][1], rgba, tint);
+	}
+}
+
+void BatchMesh::addLineLoop(const Transform2D& transform, const float (*xy)[2], int nbPts,
+							float r, float g, float b, float tint)
+{
+	if (nbPts < 2)
+		return;
+
+	addLineStrip(transform, xy, nbPts, r, g, b, tint);
+	//	close the loop
+	uint8_t rgba[4];
+	Renderer2D::packColor_(r, g, b, rgba);
+	pushVertex_(lines_, transform, xy[nbPts-1][0], xy[nbPts-1][1], rgba, tint);
+	pushVertex_(lines_, transform, xy[0][0], xy[0][1], rgba, tint);
+}
+
+void BatchMesh::addLineStrip(const Transform2D& transform, const float (*xy)[2], int nbPts,
+							 float r, float g, float b, float tint)
+{
+	uint8_t rgba[4];
+	Renderer2D::packColor_(r, g, b, rgba);
+	//	GL_LINES: one pair of vertices per segment
+	for (int k = 1; k < nbPts; k++)
+	{
+		pushVertex_(lines_, transform, xy[k-1][0], xy[k-1][1], rgba, tint);
+		pushVertex_(lines_, transform, xy[k][0], xy[k][1], rgba, tint);
+	}
+}
@@ -0,0 +1,243 @@
+//
+//  Renderer2D.h
+//  Week 08 - Earshooter
+//
+//	Interface through which the objects draw themselves (see
+//	GraphicObject2D::draw_).  The objects only describe their geometry, in
+//	local coordinates with a local to world transformation: filled polygons
+//	and triangles, closed and open polylines, instances of unit meshes (disks
+//	and ellipses are instances of the unit circle, and arcs are drawn as
+//	polylines), and baked composite meshes.  The basic shapes (disks,
+//	squares, triangles, faces) are also identified as such, so that a
+//	renderer can draw them from their signed distance function rather than
+//	from their tessellation.  The implementations decide how this geometry
+//	gets rasterized:
+//		- BatchRenderer draws it with OpenGL;
+//		- SoftwareRenderer rasterizes it on the CPU, into an in-memory
+//		  framebuffer, so that rendering can run (and be measured) on a
+//		  machine without a display.
+//	The text of the HUD is not part of the interface: no object draws text.
+
+#ifndef RENDERER_2D_H
+#define RENDERER_2D_H
+
+#include <cstdint>
+#include <vector>
+#include "Transform2D.h"
+
+namespace earshooter
+{
+	/**	The batches of a frame, drawn in this order
+	 */
+	enum class RenderBatch
+	{
+		TRIANGLE = 0,
+		RECTANGLE,
+		ELLIPSE,
+		SMILING_FACE,
+		SPACE_SHIP,
+		PROJECTILE,
+		DEBUG,				//	boxes, reference frames, grid cells: on top
+		//
+		NB_BATCHES
+	};
+
+	/**	Shapes that a renderer may draw from their signed distance function,
+	 *	in unit space
+	 */
+	enum class UnitShape : uint8_t
+	{
+		DISK = 0,			//	radius 1, centered at the origin
+		SQUARE,				//	side 1, centered at the origin
+		TRIANGLE,			//	the three vertices given with the shape
+		SMILING_FACE,		//	face of radius 1, with ears, eyes, and mouth
+		//
+		NB_SHAPES
+	};
+
+	/**	Vertex of a baked mesh.  Its final color is
+	 *		rgb + tint * (color of the instance)
+	 *	so that a part can have a fixed color (tint = 0), the color of the
+	 *	object (rgb = 0, tint = 1), a shade of it, or its inverse (rgb = 1,
+	 *	tint = -1).  All the vertices of a triangle or segment have the same
+	 *	color.
+	 */
+	struct MeshVertex
+	{
+		float x, y;
+		uint8_t rgba[4];
+		float tint;
+	};
+
+	/**	Geometry of a composite shape, in unit space, built once and then
+	 *	drawn as a whole by Renderer2D::addMesh
+	 */
+	class BatchMesh
+	{
+		private:
+
+			std::vector<MeshVertex> fill_;		//	triangles
+			std::vector<MeshVertex> lines_;		//	segments
+
+			static void pushVertex_(std::vector<MeshVertex>& vertices,
+									const Transform2D& transform, float x, float y,
+									const uint8_t rgba[4], float tint);
+
+		public:
+
+			BatchMesh() = default;
+
+			/**	Adds a filled polygon, triangulated as a fan
+			 *	@PARAM transform	part to unit space transformation
+			 *	@PARAM xy			vertices, in part coordinates
+			 *	@PARAM nbPts		number of vertices
+			 *	@PARAM r, g, b		fixed part of the color
+			 *	@PARAM tint			weight of the instance color
+			 */
+			void addPolygon(const Transform2D& transform, const float (*xy)[2], int nbPts,
+							float r, float g, float b, float tint);
+
+			/**	Adds filled triangles (three vertices per triangle)
+			 */
+			void addTriangles(const Transform2D& transform, const float (*xy)[2], int nbPts,
+							  float r, float g, float b, float tint);
+
+			/**	Adds a closed polyline
+			 */
+			void addLineLoop(const Transform2D& transform, const float (*xy)[2], int nbPts,
+							 float r, float g, float b, float tint);
+
+			/**	Adds an open polyline
+			 */
+			void addLineStrip(const Transform2D& transform, const float (*xy)[2], int nbPts,
+							  float r, float g, float b, float tint);
+
+			inline const std::vector<MeshVertex>& getFill() const
+			{
+				return fill_;
+			}
+
+			inline const std::vector<MeshVertex>& getLines() const
+			{
+				return lines_;
+			}
+
+			//	Disabled constructors & operators
+			BatchMesh(const BatchMesh&) = delete;
+			BatchMesh& operator = (const BatchMesh&) = delete;
+	};
+
+	class Renderer2D
+	{
+		friend class BatchMesh;
+
+		protected:
+
+			/**	Converts a color to bytes, clamping its components to [0, 1]
+			 */
+			static void packColor_(float r, float g, float b, uint8_t rgba[4]);
+
+		public:
+
+			Renderer2D() = default;
+			virtual ~Renderer2D() = default;
+
+			/**	Adds a filled convex (or star-shaped around its first vertex)
+			 *	polygon, triangulated as a fan.
+			 *	@PARAM batch		the batch the polygon belongs to
+			 *	@PARAM transform	local to world transformation
+			 *	@PARAM xy			vertices, in local coordinates
+			 *	@PARAM nbPts		number of vertices
+			 *	@PARAM r, g, b		fill color
+			 */
+			virtual void addPolygon(RenderBatch batch, const Transform2D& transform,
+									const float (*xy)[2], int nbPts, float r, float g, float b) = 0;
+
+			/**	Adds filled triangles
+			 *	@PARAM xy		vertices, three per triangle, in local coordinates
+			 *	@PARAM nbPts	number of vertices (a multiple of 3)
+			 */
+			virtual void addTriangles(RenderBatch batch, const Transform2D& transform,
+									  const float (*xy)[2], int nbPts, float r, float g, float b) = 0;
+
+			/**	Adds a closed polyline
+			 */
+			virtual void addLineLoop(RenderBatch batch, const Transform2D& transform,
+									 const float (*xy)[2], int nbPts, float r, float g, float b) = 0;
+
+			/**	Adds an open polyline
+			 */
+			virtual void addLineStrip(RenderBatch batch, const Transform2D& transform,
+									  const float (*xy)[2], int nbPts, float r, float g, float b) = 0;
+
+			/**	Adds a filled instance of a unit mesh (e.g. a disk or an ellipse
+			 *	as an instance of the unit circle).  The mesh must stay valid and
+			 *	unchanged for as long as the renderer is used.  By default, the
+			 *	instance is drawn as a polygon.
+			 *	@PARAM batch		the batch the shape belongs to
+			 *	@PARAM transform	unit mesh to world transformation
+			 *	@PARAM xy			vertices of the unit mesh, a polygon
+			 *						star-shaped around its first vertex
+			 *	@PARAM nbPts		number of vertices
+			 *	@PARAM r, g, b		fill color
+			 */
+			virtual void addMeshFill(RenderBatch batch, const Transform2D& transform,
+									 const float (*xy)[2], int nbPts, float r, float g, float b);
+
+			/**	Adds the contour of an instance of a unit mesh, as a closed
+			 *	polyline
+			 */
+			virtual void addMeshOutline(RenderBatch batch, const Transform2D& transform,
+										const float (*xy)[2], int nbPts, float r, float g, float b);
+
+			/**	Adds an instance of a baked mesh.  The mesh must stay valid and
+			 *	unchanged for as long as the renderer is used.  By default, its
+			 *	triangles and segments are added one by one.
+			 *	@PARAM batch		the batch the shape belongs to
+			 *	@PARAM transform	unit space to world transformation
+			 *	@PARAM mesh			the baked geometry of the shape
+			 *	@PARAM r, g, b		color of the instance, tinting the mesh
+			 */
+			virtual void addMesh(RenderBatch batch, const Transform2D& transform,
+								 const BatchMesh& mesh, float r, float g, float b);
+
+			/**	Adds a basic shape, filled, and outlined in the inverse color if
+			 *	requested.  The tessellation of the shape (which must stay valid
+			 *	for as long as the renderer is used) is what gets drawn, by
+			 *	default: disks as instances of a unit mesh, the other shapes as
+			 *	polygons.
+			 *	@PARAM batch		the batch the shape belongs to
+			 *	@PARAM transform	unit space to world transformation
+			 *	@PARAM shape		the shape (not SMILING_FACE)
+			 *	@PARAM xy			vertices of the tessellated shape
+			 *	@PARAM nbPts		number of vertices
+			 *	@PARAM contour		true if the contour is drawn
+			 *	@PARAM r, g, b		fill color
+			 */
+			virtual void addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+								  const float (*xy)[2], int nbPts, bool contour,
+								  float r, float g, float b);
+
+			/**	Adds a composite shape, whose baked mesh gets drawn by default
+			 *	@PARAM shape	the shape (SMILING_FACE)
+			 *	@PARAM mesh		the baked geometry of the shape
+			 *	@see addMesh
+			 */
+			virtual void addShape(RenderBatch batch, const Transform2D& transform, UnitShape shape,
+								  const BatchMesh& mesh, float r, float g, float b);
+
+			/**	Sets the width (in pixels) used to draw the lines of a batch
+			 */
+			virtual void setLineWidth(RenderBatch batch, float width) = 0;
+
+			/**	Draws all the batches and empties them
+			 */
+			virtual void flush() = 0;
+
+			//	Disabled constructors & operators
+			Renderer2D(const Renderer2D&) = delete;
+			Renderer2D& operator = (const Renderer2D&) = delete;
+	};
+}
+
+#endif	//	RENDERER_2D_H
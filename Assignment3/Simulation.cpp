@@ -0,0 +1,215 @@
+//
+//  Simulation.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include <cmath>
+#include "Simulation.h"
+#include "Triangle.h"
+#include "Rectangle2D.h"
+#include "Ellipse2D.h"
+#include "SmilingFace.h"
+#include "Profiler.h"
+
+using namespace std;
+using namespace earshooter;
+
+//	Workaround for that pesky M_PI lack on Windows
+#ifndef M_PI
+#define	M_PI 3.14159265f
+#endif
+
+const float MAX_SPIN = 100.f;	//	degree per second
+const float MIN_TIME_TO_CROSS = 5.f;	// shortest time for an object to cross the world
+
+//	Sectors within that distance of the ship's sector are updated at every
+//	step; a little farther, only every SLOW_SECTOR_PERIOD steps (with a step
+//	that much longer); beyond, they sleep.
+const int AWAKE_SECTOR_RADIUS = 1;
+const int SLOW_SECTOR_RADIUS = 3;
+const int SLOW_SECTOR_PERIOD = 10;
+
+//	Farther than that from the origin of the coordinates, the ship takes the
+//	origin with it (by whole multiples of that distance, so that the shifts
+//	are exact).  Within it, a float is precise to a few 1e-5 units, much less
+//	than what a step moves the objects.
+const float REBASE_DISTANCE = 256.f;
+
+const float Simulation::ASTEROID_SPAWN_INTERVAL = 1.f;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+Simulation::Simulation(float xmin, float xmax, float ymin, float ymax, WorldType type,
+					   unsigned int seed, int nbAsteroids, float sectorSize)
+	:	world_(xmin, xmax, ymin, ymax, type),
+		spaceship_(makeTracked<SpaceShip, MemoryCategory::SPACE_SHIP>(0.f, 0.f, 0.f, 0.5f, 1.0f, 0.f, 0.f, true,
+																	   0.f, 0.f, 0.f)),
+		engine_(seed),
+		scale_(sectorSize > 0.f ? min(sectorSize, xmax - xmin) : xmax - xmin),
+		nbAwakeSectors_(0),
+		nbSlowSectors_(0),
+		time_(0.f),
+		timeSinceLastAsteroid_(0.f),
+		stepCount_(0),
+		asteroidCount_(0)
+{
+	if (sectorSize > 0.f)
+		world_.setSectorSize(sectorSize);
+	world_.addObject(spaceship_);
+	for (int k = 0; k < nbAsteroids; k++)
+		generateRandomAsteroid();
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Simulation
+//--------------------------------------
+#endif
+
+void Simulation::step(float dt)
+{
+	//	Which sectors get updated, based on their distance to the ship's.
+	//	The slow ones don't all come due at the same step.
+	const int shipSector = world_.getSectorOf(spaceship_->getX(), spaceship_->getY());
+	updatedSectors_.clear();
+	nbAwakeSectors_ = nbSlowSectors_ = 0;
+	world_.forEachSectorAround(shipSector, AWAKE_SECTOR_RADIUS, [this](int sector)
+	{
+		updatedSectors_.push_back(sector);
+		nbAwakeSectors_++;
+	});
+	world_.forEachSectorAround(shipSector, SLOW_SECTOR_RADIUS, [this, shipSector](int sector)
+	{
+		if (world_.getSectorDistance(sector, shipSector) > AWAKE_SECTOR_RADIUS)
+		{
+			nbSlowSectors_++;
+			if ((stepCount_ + sector) % SLOW_SECTOR_PERIOD == 0)
+				updatedSectors_.push_back(sector);
+		}
+	});
+
+	// Update all the objects of these sectors
+	{
+		ProfileScope updateScope(ProfileZone::UPDATE);
+		for (size_t k = 0; k < updatedSectors_.size(); k++)
+		{
+			const float sectorDt = static_cast<int>(k) < nbAwakeSectors_ ? dt : SLOW_SECTOR_PERIOD * dt;
+			const vector<ObjectList::iterator>& sectorObjects = world_.getSectorObjects(updatedSectors_[k]);
+			updateScope.addItems(sectorObjects.size());
+			for (ObjectList::iterator iter : sectorObjects)
+			{
+				UpdateStatus status = (*iter)->update(sectorDt);
+				if (status == UpdateStatus::DEAD)
+				{
+					iter->reset();  // Remove dead objects (their node goes with the refresh)
+				}
+			}
+		}
+	}
+	world_.refreshSectors(updatedSectors_);
+
+	//	Keep the coordinates small (and precise) around the ship
+	if (spaceship_->isAlive() &&
+		(fabsf(spaceship_->getX()) > REBASE_DISTANCE || fabsf(spaceship_->getY()) > REBASE_DISTANCE))
+	{
+		world_.shiftOrigin(REBASE_DISTANCE * roundf(spaceship_->getX() / REBASE_DISTANCE),
+						   REBASE_DISTANCE * roundf(spaceship_->getY() / REBASE_DISTANCE));
+	}
+
+	// Periodically generate new asteroids
+	timeSinceLastAsteroid_ += dt;
+	if (timeSinceLastAsteroid_ >= ASTEROID_SPAWN_INTERVAL && spaceship_->isAlive()) {
+		ProfileScope spawnScope(ProfileZone::SPAWN, 1);
+		generateRandomAsteroid();
+		timeSinceLastAsteroid_ = 0.0f;  // Reset the spawn timer
+	}
+
+	time_ += dt;
+	stepCount_++;
+}
+
+void Simulation::generateRandomAsteroid()
+{
+	AsteroidDraw a = drawRandomAsteroid(world_, scale_, engine_);
+
+	switch (a.shape) {
+	case 0:
+		world_.addObject(makeTracked<Triangle, MemoryCategory::TRIANGLE>(a.x, a.y, a.angle, a.size, a.r, a.g, a.b, true,
+			a.vx, a.vy, a.spin));
+		break;
+
+	case 1:
+		world_.addObject(makeTracked<earshooter::Rectangle2D, MemoryCategory::RECTANGLE>(a.x, a.y, a.angle, a.size, a.size, a.r, a.g, a.b, true,
+			a.vx, a.vy, a.spin));
+		break;
+
+	case 2:
+		world_.addObject(makeTracked<earshooter::Ellipse2D, MemoryCategory::ELLIPSE>(a.x, a.y, a.angle, a.size, a.size, a.r, a.g, a.b, true,
+			a.vx, a.vy, a.spin));
+		break;
+
+	case 3:
+		world_.addObject(makeTracked<SmilingFace, MemoryCategory::SMILING_FACE>(a.x, a.y, a.angle, a.size, a.r, a.g, a.b,
+			a.vx, a.vy, a.spin));
+		break;
+
+	default:
+		break;
+	}
+	asteroidCount_++;
+}
+
+float Simulation::getMaxObjectSize() const
+{
+	return scale_ / 10;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Free functions
+//--------------------------------------
+#endif
+
+AsteroidDraw earshooter::drawRandomAsteroid(const World2D& world, float scale,
+											default_random_engine& engine)
+{
+	//	speed and size limits based on the scale of the world
+	const float maxSpeed = scale / MIN_TIME_TO_CROSS;
+	const float minSize = scale / 30;
+	const float maxSize = scale / 10;
+	uniform_int_distribution<int> shapeDist(0, 3);	//	triangle - rect - ellipse - face
+	uniform_real_distribution<float> angleDist(0, 2 * M_PI);
+	uniform_real_distribution<float> colorDist(0.f, 1.f);
+	uniform_real_distribution<float> spinDist(-MAX_SPIN, +MAX_SPIN);
+	uniform_real_distribution<float> speedDist(0.4f * maxSpeed, maxSpeed);
+	uniform_real_distribution<float> sizeDist(minSize, maxSize);
+	uniform_real_distribution<float> xDist(world.getXmin(), world.getXmax());
+	uniform_real_distribution<float> yDist(world.getYmin(), world.getYmax());
+
+	// Generate random properties for the asteroid
+	AsteroidDraw a;
+	a.x = xDist(engine);
+	a.y = yDist(engine);
+	a.angle = angleDist(engine);
+	float direction = angleDist(engine);
+	float speed = speedDist(engine);
+	a.spin = spinDist(engine);
+	a.r = colorDist(engine);
+	a.g = colorDist(engine);
+	a.b = colorDist(engine);
+	a.size = sizeDist(engine);
+	a.vx = speed * cosf(direction);
+	a.vy = speed * sinf(direction);
+
+	// Choose random shape for the asteroid
+	a.shape = shapeDist(engine);
+	return a;
+}
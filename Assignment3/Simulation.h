@@ -0,0 +1,177 @@
+//
+//  Simulation.h
+//  Week 08 - Earshooter
+//
+//	One run of the game: a world, the spaceship that lives in it, and the
+//	asteroids that keep getting thrown at it.  Everything a run depends on
+//	belongs to the Simulation, down to its random engine, so that a run can
+//	be reproduced from its seed, and so that many runs can be stepped at the
+//	same time, each one by its own thread (see BatchRunner).  The rendering
+//	code only reads a simulation, from the thread that steps it.
+//	A world much larger than the view is partitioned into sectors, and only
+//	the sectors near the ship are stepped at every step: those a little
+//	farther get a longer step once in a while, and the rest of the world
+//	sleeps (time stands still there) until the ship comes near.  The origin
+//	of the coordinates follows the ship, so that they stay precise around it.
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+#include "World2D.h"
+#include "SpaceShip.h"
+
+namespace earshooter
+{
+	/**	The properties of a new asteroid, drawn at random
+	 */
+	struct AsteroidDraw
+	{
+		int shape;				//	triangle - rect - ellipse - face
+		float x, y, angle;
+		float size;
+		float r, g, b;
+		float vx, vy, spin;
+	};
+
+	/**	Draws the properties of an asteroid somewhere in a world.  Shared by
+	 *	all the ways of running a world, so that the same seed gives the same
+	 *	asteroids.
+	 *	@PARAM world	the world the asteroid is for (only its dimensions matter)
+	 *	@PARAM scale	width that the speed and size are relative to (the
+	 *					asteroid takes at least 5 s to cross it)
+	 *	@PARAM engine	random engine of the run
+	 */
+	AsteroidDraw drawRandomAsteroid(const World2D& world, float scale,
+									std::default_random_engine& engine);
+
+	class Simulation
+	{
+		private:
+
+			World2D world_;
+			std::shared_ptr<SpaceShip> spaceship_;
+			std::default_random_engine engine_;
+
+			/**	Width that the speeds and sizes of the asteroids are
+			 *	relative to
+			 */
+			float scale_;
+
+			/**	Sectors updated during the current step, those at full rate
+			 *	first; number of sectors at full and reduced rate
+			 */
+			std::vector<int> updatedSectors_;
+			int nbAwakeSectors_, nbSlowSectors_;
+
+			/**	Time (in s) simulated since the start of the run, and since
+			 *	the last asteroid was spawned
+			 */
+			float time_;
+			float timeSinceLastAsteroid_;
+
+			/**	Number of steps run, and of asteroids created (initial ones included)
+			 */
+			uint64_t stepCount_;
+			unsigned int asteroidCount_;
+
+		public:
+
+			/**	Time (in s) between two asteroids spawned while the ship is alive
+			 */
+			static const float ASTEROID_SPAWN_INTERVAL;
+
+			/**	Creates a world with the spaceship at its center, and a few
+			 *	asteroids at random
+			 *	@PARAM xmin, xmax, ymin, ymax	dimensions of the world
+			 *	@PARAM type			behavior of the objects at the edges of the world
+			 *	@PARAM seed			seed of the random engine of the run
+			 *	@PARAM nbAsteroids	number of asteroids created with the world
+			 *	@PARAM sectorSize	smallest size of the sectors of the world,
+			 *						which is also the width the speeds and sizes
+			 *						of the asteroids are relative to (0: the
+			 *						world is one sector)
+			 */
+			Simulation(float xmin, float xmax, float ymin, float ymax, WorldType type,
+					   unsigned int seed, int nbAsteroids, float sectorSize = 0.f);
+
+			~Simulation() = default;
+
+			/**	One fixed step of the simulation: updates the objects of the
+			 *	sectors that are awake (or due), removes the dead ones, and
+			 *	spawns an asteroid every second while the ship is alive
+			 *	@PARAM dt	duration of the step (in s)
+			 */
+			void step(float dt);
+
+			/**	Creates an asteroid of random shape, size, color, and motion,
+			 *	somewhere in the world
+			 */
+			void generateRandomAsteroid();
+
+			inline World2D& getWorld()
+			{
+				return world_;
+			}
+			inline const World2D& getWorld() const
+			{
+				return world_;
+			}
+
+			/**	Returns the ship of the player
+			 */
+			inline const std::shared_ptr<SpaceShip>& getSpaceShip() const
+			{
+				return spaceship_;
+			}
+
+			/**	Returns the time simulated since the start of the run (in s)
+			 */
+			inline float getTime() const
+			{
+				return time_;
+			}
+
+			inline uint64_t getStepCount() const
+			{
+				return stepCount_;
+			}
+
+			inline unsigned int getAsteroidCount() const
+			{
+				return asteroidCount_;
+			}
+
+			/**	Returns the size of the largest asteroids of the world
+			 */
+			float getMaxObjectSize() const;
+
+			/**	Returns the number of sectors updated at every step during
+			 *	the last step (around the ship)
+			 */
+			inline int getAwakeSectorCount() const
+			{
+				return nbAwakeSectors_;
+			}
+
+			/**	Returns the number of sectors updated at a reduced rate during
+			 *	the last step (the others were asleep)
+			 */
+			inline int getSlowSectorCount() const
+			{
+				return nbSlowSectors_;
+			}
+
+			//	Disabled constructors & operators
+			Simulation() = delete;
+			Simulation(const Simulation&) = delete;
+			Simulation(Simulation&&) = delete;
+			Simulation& operator =(const Simulation&) = delete;
+			Simulation& operator =(Simulation&&) = delete;
+	};
+}
+
+#endif	//	SIMULATION_H
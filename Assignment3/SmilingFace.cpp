@@ -15,8 +15,8 @@ using namespace earshooter;
 using namespace std;
 
 
-unsigned int SmilingFace::count_ = 0;
-unsigned int SmilingFace::liveCount_ = 0;
+atomic<unsigned int> SmilingFace::count_(0);
+atomic<unsigned int> SmilingFace::liveCount_(0);
 
 const int SmilingFace::LEFT_EAR = 0;
 const int SmilingFace::RIGHT_EAR = 1;
@@ -69,6 +69,8 @@ SmilingFace::SmilingFace(float x, float y, float angle, float size,
 		size_(size),
 		index_(count_++)
 {
+	MemoryScope memoryScope(MemoryCategory::SMILING_FACE);
+
 	updateRelativeBox_();
 	updateAbsoluteBox_();
 	
@@ -115,76 +117,47 @@ SmilingFace::~SmilingFace(void)
 //-----------------------------------------
 #endif
 
-void SmilingFace::draw_(void) const
+void SmilingFace::draw_(Renderer2D& renderer, const Transform2D& transform) const
 {
-	float r = getR(), g = getG(), b = getB();
-	
-	glPushMatrix();
-
-	glScalef(size_, size_, 1.f);
-	
-	glColor4f(r, g, b, 1.f);
-	glPushMatrix();
-	glScalef(FACE_RADIUS, FACE_RADIUS, 1.f);
-	drawDisk();
-	glPopMatrix();
-
-	//	draw the left ear
-	glPushMatrix();
-	glTranslatef(LEFT_EAR_X, LEFT_EAR_Y, 0.f);
-	glScalef(EAR_RADIUS, EAR_RADIUS, 1.f);
-	drawDisk();
-	glPopMatrix();
-
-	//	draw the right ear
-	glPushMatrix();
-	glTranslatef(RIGHT_EAR_X, RIGHT_EAR_Y, 0.f);
-	glScalef(EAR_RADIUS, EAR_RADIUS, 1.f);
-	drawDisk();
-	glPopMatrix();
-
-	//	draw the left and right eyes (I could have gone the Push&pop way here as
-	//	well, and would if the eyes were more complex, but here they are simply
-	//	ellipses, so no need to make it over-complex.
-	//	White of eye
-	glColor4f(1.f, 1.f, 1.f, 1.f);
-	glPushMatrix();
-	glTranslatef(LEFT_EYE_X, LEFT_EYE_Y, 0.f);
-	glScalef(EYE_OUTER_RADIUS, EYE_OUTER_RADIUS, 1.f);
-	drawDisk();
-	glPopMatrix();
-	glPushMatrix();
-	glTranslatef(RIGHT_EYE_X, RIGHT_EYE_Y, 0.f);
-	glScalef(EYE_OUTER_RADIUS, EYE_OUTER_RADIUS, 1.f);
-	drawDisk();
-	glPopMatrix();
-	// pupils
-	glColor4f(0.f, 0.f, 0.f, 1.f);
-	glPushMatrix();
-	glTranslatef(LEFT_EYE_X, LEFT_EYE_Y, 0.f);
-	glScalef(EYE_INNER_RADIUS, EYE_INNER_RADIUS, 1.f);
-	drawDisk();
-	glPopMatrix();
-	glPushMatrix();
-	glTranslatef(RIGHT_EYE_X, RIGHT_EYE_Y, 0.f);
-	glScalef(EYE_INNER_RADIUS, EYE_INNER_RADIUS, 1.f);
-	drawDisk();
-	glPopMatrix();
-
-	glTranslatef(MOUTH_H_OFFSET, MOUTH_V_OFFSET, 0.f);
-	glScalef(MOUTH_H_DIAMETER, MOUTH_V_DIAMETER, 1.f);
-	glColor3f(0.f, 0.f, 0.f);
-	glLineWidth(3.f);
-	drawArc(0.7f, 0.85f);
-	glLineWidth(1.f);
-
-
-
-	
+	//	the mouth is the only line of the batch
+	renderer.setLineWidth(RenderBatch::SMILING_FACE, 3.f);
+	renderer.addShape(RenderBatch::SMILING_FACE, transform.scaled(size_, size_),
+					  UnitShape::SMILING_FACE, getMesh_(), getR(), getG(), getB());
+}
 
-	//	restore the original scale
-	glPopMatrix();
+const BatchMesh& SmilingFace::getMesh_()
+{
+	//	The objects are recorded by several threads at once: the
+	//	initialization of a local static is the one that is thread-safe
+	static const unique_ptr<BatchMesh> mesh = bakeMesh_();
+	return *mesh;
+}
 
+unique_ptr<BatchMesh> SmilingFace::bakeMesh_()
+{
+	unique_ptr<BatchMesh> mesh = make_unique<BatchMesh>();
+	const Transform2D face = Transform2D::identity();
+
+	//	face and ears take the color of the object
+	drawDisk(*mesh, face.scaled(FACE_RADIUS, FACE_RADIUS), 0.f, 0.f, 0.f, 1.f);
+	drawDisk(*mesh, face.translated(LEFT_EAR_X, LEFT_EAR_Y).scaled(EAR_RADIUS, EAR_RADIUS),
+			 0.f, 0.f, 0.f, 1.f);
+	drawDisk(*mesh, face.translated(RIGHT_EAR_X, RIGHT_EAR_Y).scaled(EAR_RADIUS, EAR_RADIUS),
+			 0.f, 0.f, 0.f, 1.f);
+
+	//	White of eyes, then pupils
+	drawDisk(*mesh, face.translated(LEFT_EYE_X, LEFT_EYE_Y).scaled(EYE_OUTER_RADIUS, EYE_OUTER_RADIUS),
+			 1.f, 1.f, 1.f, 0.f);
+	drawDisk(*mesh, face.translated(RIGHT_EYE_X, RIGHT_EYE_Y).scaled(EYE_OUTER_RADIUS, EYE_OUTER_RADIUS),
+			 1.f, 1.f, 1.f, 0.f);
+	drawDisk(*mesh, face.translated(LEFT_EYE_X, LEFT_EYE_Y).scaled(EYE_INNER_RADIUS, EYE_INNER_RADIUS),
+			 0.f, 0.f, 0.f, 0.f);
+	drawDisk(*mesh, face.translated(RIGHT_EYE_X, RIGHT_EYE_Y).scaled(EYE_INNER_RADIUS, EYE_INNER_RADIUS),
+			 0.f, 0.f, 0.f, 0.f);
+
+	drawArc(*mesh, face.translated(MOUTH_H_OFFSET, MOUTH_V_OFFSET).scaled(MOUTH_H_DIAMETER, MOUTH_V_DIAMETER),
+			0.f, 0.f, 0.f, 0.f, 0.7f, 0.85f);
+	return mesh;
 }
 
 bool SmilingFace::isInside(float x, float y) const
@@ -253,14 +226,6 @@ void SmilingFace::updateRelativeBox_() {
 
 
 void SmilingFace::updateAbsoluteBox_() {
-	// Get current position, scale, and rotation
-	float cx = getX();
-	float cy = getY();
-	float scale = size_;
-	float angleRad = M_PI * getAngle() / 180.f; // Convert angle to radians for rotation
-	float cosA = cosf(angleRad);
-	float sinA = sinf(angleRad);
-
 	if (partAbsoluteBox_.empty()) {
 		// Initialize bounding boxes if they haven't been created yet
 
@@ -270,12 +235,29 @@ void SmilingFace::updateAbsoluteBox_() {
 		partAbsoluteBox_.emplace_back(std::make_unique<BoundingBox>(0, 0, 0, 0, ColorIndex::ORANGE)); // Right Ear
 	}
 
+	BoundingBox part[HEAD_NUM_PARTS];
+	BoundingBox box = computeAbsoluteBox(getX(), getY(), getAngle(), size_, part);
+	for (int k = 0; k < HEAD_NUM_PARTS; k++)
+		partAbsoluteBox_[k]->setDimensions(part[k].getXmin(), part[k].getXmax(),
+										   part[k].getYmin(), part[k].getYmax());
+
+	// Set the global bounding box
+	setAbsoluteBoundingBox(box.getXmin(), box.getXmax(), box.getYmin(), box.getYmax());
+}
+
+BoundingBox SmilingFace::computeAbsoluteBox(float cx, float cy, float angle, float size,
+											BoundingBox* part) {
+	// Get current scale and rotation
+	float scale = size;
+	float angleRad = M_PI * angle / 180.f; // Convert angle to radians for rotation
+	float cosA = cosf(angleRad);
+	float sinA = sinf(angleRad);
+
 	// Face bounding box with transformation
 	float faceMinX = cx - FACE_RADIUS * scale;
 	float faceMaxX = cx + FACE_RADIUS * scale;
 	float faceMinY = cy - FACE_RADIUS * scale;
 	float faceMaxY = cy + FACE_RADIUS * scale;
-	partAbsoluteBox_[FACE]->setDimensions(faceMinX, faceMaxX, faceMinY, faceMaxY);
 
 	// Left ear bounding box with rotation and scale
 	float leftEarX = cx + (LEFT_EAR_X * cosA - LEFT_EAR_Y * sinA) * scale;
@@ -284,7 +266,6 @@ void SmilingFace::updateAbsoluteBox_() {
 	float leftEarMaxX = leftEarX + EAR_RADIUS * scale;
 	float leftEarMinY = leftEarY - EAR_RADIUS * scale;
 	float leftEarMaxY = leftEarY + EAR_RADIUS * scale;
-	partAbsoluteBox_[LEFT_EAR]->setDimensions(leftEarMinX, leftEarMaxX, leftEarMinY, leftEarMaxY);
 
 	// Right ear bounding box with rotation and scale
 	float rightEarX = cx + (RIGHT_EAR_X * cosA - RIGHT_EAR_Y * sinA) * scale;
@@ -293,8 +274,12 @@ void SmilingFace::updateAbsoluteBox_() {
 	float rightEarMaxX = rightEarX + EAR_RADIUS * scale;
 	float rightEarMinY = rightEarY - EAR_RADIUS * scale;
 	float rightEarMaxY = rightEarY + EAR_RADIUS * scale;
-	partAbsoluteBox_[RIGHT_EAR]->setDimensions(rightEarMinX, rightEarMaxX, rightEarMinY, rightEarMaxY);
 
+	if (part != nullptr) {
+		part[FACE].setDimensions(faceMinX, faceMaxX, faceMinY, faceMaxY);
+		part[LEFT_EAR].setDimensions(leftEarMinX, leftEarMaxX, leftEarMinY, leftEarMaxY);
+		part[RIGHT_EAR].setDimensions(rightEarMinX, rightEarMaxX, rightEarMinY, rightEarMaxY);
+	}
 
 	float globalMinX = faceMinX;
 	float globalMaxX = faceMaxX;
@@ -314,8 +299,7 @@ void SmilingFace::updateAbsoluteBox_() {
 	if (leftEarMaxY > globalMaxY) globalMaxY = leftEarMaxY;
 	if (rightEarMaxY > globalMaxY) globalMaxY = rightEarMaxY;
 
-	// Set the global bounding box
-	setAbsoluteBoundingBox(globalMinX, globalMaxX, globalMinY, globalMaxY);
+	return BoundingBox(globalMinX, globalMaxX, globalMinY, globalMaxY);
 }
 
 
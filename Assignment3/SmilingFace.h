@@ -27,10 +27,10 @@ namespace earshooter
 		unsigned int index_;
 
 		/** Counter for the number of SmilingFace objects created */
-		static unsigned int count_;
+		static std::atomic<unsigned int> count_;
 
 		/** Counter for the number of SmilingFace objects still "alive" */
-		static unsigned int liveCount_;
+		static std::atomic<unsigned int> liveCount_;
 
 		/** Indices for different parts of the face */
 		const static int LEFT_EAR;
@@ -77,10 +77,20 @@ namespace earshooter
 		/** Updates the absolute bounding box of the face */
 		void updateAbsoluteBox_() const;
 
+		/** Returns the geometry of a face of size 1, baked on first use
+		 *	(once the unit circle of Ellipse2D is sure to exist), by
+		 *	whichever recording thread gets there first
+		 */
+		static const BatchMesh& getMesh_();
+
+		/** Builds the geometry of a face of size 1
+		 */
+		static std::unique_ptr<BatchMesh> bakeMesh_();
+
 		/** Private rendering function for the SmilingFace class.
 		 *  Applies scaling before rendering.
 		 */
-		void draw_() const override;
+		void draw_(Renderer2D& renderer, const Transform2D& transform) const override;
 
 		/** Updates the object's absolute bounding box */
 		void updateAbsoluteBox_() override;
@@ -150,6 +160,19 @@ namespace earshooter
 		 */
 		bool isInside(float x, float y) const override;
 
+		/** Computes the absolute bounding box of a face in a given pose (the
+		 * one updateAbsoluteBox_ sets, also used by WorldBatch)
+		 * @param cx X-coordinate of the center of the face
+		 * @param cy Y-coordinate of the center of the face
+		 * @param angle Orientation of the face (in degrees)
+		 * @param size Scaling size of the face
+		 * @param part If not null, receives the boxes of the face and ears
+		 *	(HEAD_NUM_PARTS of them, indexed by FACE, LEFT_EAR, and RIGHT_EAR)
+		 * @return The box of the whole head
+		 */
+		static BoundingBox computeAbsoluteBox(float cx, float cy, float angle, float size,
+											  BoundingBox* part = nullptr);
+
 		/** Returns the scaling size of the face
 		 * @return The size of the face
 		 */
@@ -0,0 +1,360 @@
+//
+//  SoftwareRenderer.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include "SoftwareRenderer.h"
+
+using namespace std;
+using namespace earshooter;
+
+const int NB_BATCHES = static_cast<int>(RenderBatch::NB_BATCHES);
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, unsigned int nbThreads)
+	:	width_(width < 1 ? 1 : width),
+		height_(height < 1 ? 1 : height),
+		pool_(nbThreads),
+		xmin_(0.f),
+		ymax_(static_cast<float>(height_)),
+		scaleX_(1.f),
+		scaleY_(1.f),
+		triangleCount_(0)
+{
+	nbTilesX_ = (width_ + TILE_SIZE - 1) / TILE_SIZE;
+	nbTilesY_ = (height_ + TILE_SIZE - 1) / TILE_SIZE;
+	tileBin_.resize(nbTilesX_ * nbTilesY_);
+	pixels_.resize(4 * width_ * height_);
+	setClearColor(0.f, 0.f, 0.f);
+	clear();
+}
+
+void SoftwareRenderer::setView(float xmin, float xmax, float ymin, float ymax)
+{
+	xmin_ = xmin;
+	ymax_ = ymax;
+	scaleX_ = width_ / (xmax - xmin);
+	scaleY_ = height_ / (ymax - ymin);
+}
+
+void SoftwareRenderer::setClearColor(float r, float g, float b)
+{
+	packColor_(r, g, b, clearColor_);
+}
+
+void SoftwareRenderer::clear()
+{
+	for (size_t k = 0; k < pixels_.size(); k += 4)
+	{
+		pixels_[k] = clearColor_[0];
+		pixels_[k+1] = clearColor_[1];
+		pixels_[k+2] = clearColor_[2];
+		pixels_[k+3] = clearColor_[3];
+	}
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Geometry
+//--------------------------------------
+#endif
+
+inline void SoftwareRenderer::toPixel_(const Transform2D& transform, float x, float y,
+									   float& px, float& py) const
+{
+	float wx, wy;
+	transform.apply(x, y, wx, wy);
+	px = (wx - xmin_) * scaleX_;
+	py = (ymax_ - wy) * scaleY_;
+}
+
+inline void SoftwareRenderer::pushTriangle_(vector<PixelTriangle>& fill, const float px[3],
+											const float py[3], const uint8_t rgba[4])
+{
+	PixelTriangle tri;
+	for (int k = 0; k < 3; k++)
+	{
+		tri.x[k] = px[k];
+		tri.y[k] = py[k];
+	}
+	for (int k = 0; k < 4; k++)
+		tri.rgba[k] = rgba[k];
+	fill.push_back(tri);
+}
+
+void SoftwareRenderer::addPolygon(RenderBatch batch, const Transform2D& transform,
+								  const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	if (nbPts < 3)
+		return;
+
+	uint8_t rgba[4];
+	packColor_(r, g, b, rgba);
+	vector<PixelTriangle>& fill = batch_[static_cast<int>(batch)].fill;
+	float px[3], py[3];
+	toPixel_(transform, xy[0][0], xy[0][1], px[0], py[0]);
+	toPixel_(transform, xy[1][0], xy[1][1], px[2], py[2]);
+	for (int k = 2; k < nbPts; k++)
+	{
+		px[1] = px[2];
+		py[1] = py[2];
+		toPixel_(transform, xy[k][0], xy[k][1], px[2], py[2]);
+		pushTriangle_(fill, px, py, rgba);
+	}
+}
+
+void SoftwareRenderer::addTriangles(RenderBatch batch, const Transform2D& transform,
+									const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	uint8_t rgba[4];
+	packColor_(r, g, b, rgba);
+	vector<PixelTriangle>& fill = batch_[static_cast<int>(batch)].fill;
+	float px[3], py[3];
+	for (int k = 0; k + 2 < nbPts; k += 3)
+	{
+		for (int i = 0; i < 3; i++)
+			toPixel_(transform, xy[k+i][0], xy[k+i][1], px[i], py[i]);
+		pushTriangle_(fill, px, py, rgba);
+	}
+}
+
+void SoftwareRenderer::addLineLoop(RenderBatch batch, const Transform2D& transform,
+								   const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	if (nbPts < 2)
+		return;
+
+	addLineStrip(batch, transform, xy, nbPts, r, g, b);
+	//	close the loop
+	vector<PixelSegment>& lines = batch_[static_cast<int>(batch)].lines;
+	PixelSegment segment = lines.back();
+	segment.x0 = segment.x1;
+	segment.y0 = segment.y1;
+	toPixel_(transform, xy[0][0], xy[0][1], segment.x1, segment.y1);
+	lines.push_back(segment);
+}
+
+void SoftwareRenderer::addLineStrip(RenderBatch batch, const Transform2D& transform,
+									const float (*xy)[2], int nbPts, float r, float g, float b)
+{
+	if (nbPts < 2)
+		return;
+
+	PixelSegment segment;
+	packColor_(r, g, b, segment.rgba);
+	Batch& target = batch_[static_cast<int>(batch)];
+	segment.nbFillBefore = static_cast<uint32_t>(target.fill.size());
+	vector<PixelSegment>& lines = target.lines;
+	toPixel_(transform, xy[0][0], xy[0][1], segment.x1, segment.y1);
+	for (int k = 1; k < nbPts; k++)
+	{
+		segment.x0 = segment.x1;
+		segment.y0 = segment.y1;
+		toPixel_(transform, xy[k][0], xy[k][1], segment.x1, segment.y1);
+		lines.push_back(segment);
+	}
+}
+
+void SoftwareRenderer::setLineWidth(RenderBatch batch, float width)
+{
+	batch_[static_cast<int>(batch)].lineWidth = width;
+}
+
+void SoftwareRenderer::pushSegmentQuad_(const PixelSegment& segment, float lineWidth)
+{
+	float dx = segment.x1 - segment.x0, dy = segment.y1 - segment.y0;
+	float length = sqrtf(dx*dx + dy*dy);
+	if (length == 0.f)
+		return;
+
+	//	half the width on each side of the segment, never thinner than a pixel
+	float halfWidth = 0.5f * (lineWidth < 1.f ? 1.f : lineWidth);
+	float nx = -dy * halfWidth / length, ny = dx * halfWidth / length;
+	float px[3] = {segment.x0 + nx, segment.x0 - nx, segment.x1 - nx};
+	float py[3] = {segment.y0 + ny, segment.y0 - ny, segment.y1 - ny};
+	pushTriangle_(triangles_, px, py, segment.rgba);
+	px[1] = segment.x1 - nx;	py[1] = segment.y1 - ny;
+	px[2] = segment.x1 + nx;	py[2] = segment.y1 + ny;
+	pushTriangle_(triangles_, px, py, segment.rgba);
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Rasterization
+//--------------------------------------
+#endif
+
+void SoftwareRenderer::flush()
+{
+	//	Lay out all the batches in drawing order, each segment going back
+	//	between the triangles it was added after and before
+	triangles_.clear();
+	for (int k = 0; k < NB_BATCHES; k++)
+	{
+		Batch& batch = batch_[k];
+		auto nextFill = batch.fill.begin();
+		for (const PixelSegment& segment : batch.lines)
+		{
+			auto fillEnd = batch.fill.begin() + segment.nbFillBefore;
+			triangles_.insert(triangles_.end(), nextFill, fillEnd);
+			nextFill = fillEnd;
+			pushSegmentQuad_(segment, batch.lineWidth);
+		}
+		triangles_.insert(triangles_.end(), nextFill, batch.fill.end());
+		batch.fill.clear();
+		batch.lines.clear();
+	}
+	triangleCount_ = static_cast<unsigned int>(triangles_.size());
+	if (triangles_.empty())
+		return;
+
+	binTriangles_();
+
+	//	Each worker takes the next tile not rasterized yet, until none is left.
+	//	The calling thread is one of the workers.
+	const int nbTiles = nbTilesX_ * nbTilesY_;
+	atomic<int> nextTile(0);
+	pool_.run(static_cast<unsigned int>(nbTiles), [this, &nextTile, nbTiles](unsigned int)
+	{
+		for (int tile = nextTile++; tile < nbTiles; tile = nextTile++)
+			rasterizeTile_(tile);
+	});
+}
+
+void SoftwareRenderer::binTriangles_()
+{
+	for (vector<uint32_t>& bin : tileBin_)
+		bin.clear();
+
+	for (size_t k = 0; k < triangles_.size(); k++)
+	{
+		const PixelTriangle& tri = triangles_[k];
+		float xmin = min(tri.x[0], min(tri.x[1], tri.x[2]));
+		float xmax = max(tri.x[0], max(tri.x[1], tri.x[2]));
+		float ymin = min(tri.y[0], min(tri.y[1], tri.y[2]));
+		float ymax = max(tri.y[0], max(tri.y[1], tri.y[2]));
+		if (xmax < 0.f || ymax < 0.f || xmin >= width_ || ymin >= height_)
+			continue;
+
+		//	clamped in float: a vertex far off-screen doesn't fit in an int
+		xmin = max(xmin, 0.f);
+		xmax = min(xmax, width_ - 1.f);
+		ymin = max(ymin, 0.f);
+		ymax = min(ymax, height_ - 1.f);
+		int tx0 = static_cast<int>(xmin) / TILE_SIZE;
+		int tx1 = static_cast<int>(xmax) / TILE_SIZE;
+		int ty0 = static_cast<int>(ymin) / TILE_SIZE;
+		int ty1 = static_cast<int>(ymax) / TILE_SIZE;
+		for (int ty = ty0; ty <= ty1; ty++)
+			for (int tx = tx0; tx <= tx1; tx++)
+				tileBin_[ty * nbTilesX_ + tx].push_back(static_cast<uint32_t>(k));
+	}
+}
+
+void SoftwareRenderer::rasterizeTile_(int tile)
+{
+	int x0 = (tile % nbTilesX_) * TILE_SIZE;
+	int y0 = (tile / nbTilesX_) * TILE_SIZE;
+	int x1 = min(x0 + TILE_SIZE, width_);
+	int y1 = min(y0 + TILE_SIZE, height_);
+	for (uint32_t index : tileBin_[tile])
+		rasterizeTriangle_(triangles_[index], x0, y0, x1, y1);
+}
+
+void SoftwareRenderer::rasterizeTriangle_(const PixelTriangle& tri, int x0, int y0, int x1, int y1)
+{
+	//	Orient the triangle so that its edge functions are positive inside
+	float ax = tri.x[0], ay = tri.y[0];
+	float bx = tri.x[1], by = tri.y[1];
+	float cx = tri.x[2], cy = tri.y[2];
+	float area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+	if (area == 0.f)
+		return;
+	if (area < 0.f)
+	{
+		swap(bx, cx);
+		swap(by, cy);
+	}
+
+	//	Clip the triangle's box to the tile, in float (a vertex far off-screen
+	//	doesn't fit in an int)
+	int xmin = static_cast<int>(floorf(max(min(ax, min(bx, cx)), static_cast<float>(x0))));
+	int xmax = static_cast<int>(ceilf(min(max(ax, max(bx, cx)), static_cast<float>(x1 - 1))));
+	int ymin = static_cast<int>(floorf(max(min(ay, min(by, cy)), static_cast<float>(y0))));
+	int ymax = static_cast<int>(ceilf(min(max(ay, max(by, cy)), static_cast<float>(y1 - 1))));
+	if (xmin > xmax || ymin > ymax)
+		return;
+
+	//	Edge functions at the center of the first pixel, and their steps
+	//	along a row and down a column
+	float px = xmin + 0.5f, py = ymin + 0.5f;
+	float e0 = (cx - bx) * (py - by) - (cy - by) * (px - bx);
+	float e1 = (ax - cx) * (py - cy) - (ay - cy) * (px - cx);
+	float e2 = (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+	float e0dx = -(cy - by), e0dy = cx - bx;
+	float e1dx = -(ay - cy), e1dy = ax - cx;
+	float e2dx = -(by - ay), e2dy = bx - ax;
+
+	uint32_t color;
+	memcpy(&color, tri.rgba, sizeof(color));
+	uint32_t* pixels = reinterpret_cast<uint32_t*>(pixels_.data());
+	for (int y = ymin; y <= ymax; y++)
+	{
+		float w0 = e0, w1 = e1, w2 = e2;
+		uint32_t* row = pixels + y * width_;
+		for (int x = xmin; x <= xmax; x++)
+		{
+			if (w0 >= 0.f && w1 >= 0.f && w2 >= 0.f)
+				row[x] = color;
+			w0 += e0dx;
+			w1 += e1dx;
+			w2 += e2dx;
+		}
+		e0 += e0dy;
+		e1 += e1dy;
+		e2 += e2dy;
+	}
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Output
+//--------------------------------------
+#endif
+
+bool SoftwareRenderer::writePPM(const string& path) const
+{
+	FILE* out = fopen(path.c_str(), "wb");
+	if (out == nullptr)
+		return false;
+
+	fprintf(out, "P6\n%d %d\n255\n", width_, height_);
+	vector<uint8_t> rgb(3 * width_);
+	bool ok = true;
+	for (int y = 0; y < height_ && ok; y++)
+	{
+		const uint8_t* row = pixels_.data() + 4 * y * width_;
+		for (int x = 0; x < width_; x++)
+		{
+			rgb[3*x] = row[4*x];
+			rgb[3*x+1] = row[4*x+1];
+			rgb[3*x+2] = row[4*x+2];
+		}
+		ok = fwrite(rgb.data(), 1, rgb.size(), out) == rgb.size();
+	}
+	return (fclose(out) == 0) && ok;
+}
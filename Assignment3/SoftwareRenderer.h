@@ -0,0 +1,177 @@
+//
+//  SoftwareRenderer.h
+//  Week 08 - Earshooter
+//
+//	CPU implementation of Renderer2D: rasterizes the objects into an
+//	in-memory RGBA framebuffer, without any OpenGL context, so that a frame
+//	can be rendered (and timed) on a machine without a display and saved as
+//	a PPM image.
+//	The geometry is mapped to pixels and collected per batch as the objects
+//	add it; lines become quads as wide as their batch's line width.  At
+//	flush time, the triangles are binned into square tiles of the
+//	framebuffer, and a pool of worker threads rasterizes the tiles, each
+//	tile being owned by one thread.  Within a tile, the triangles are drawn
+//	in submission order (batches in order, and within a batch, fills and
+//	lines in the order they were added), as with BatchRenderer.  Triangles
+//	are flat-colored and opaque, sampled at the pixel centers, with no
+//	antialiasing.
+
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Renderer2D.h"
+#include "WorkerPool.h"
+
+namespace earshooter
+{
+	class SoftwareRenderer : public Renderer2D
+	{
+		private:
+
+			/**	side of a tile, in pixels
+			 */
+			static const int TILE_SIZE = 64;
+
+			/**	A triangle, in pixel coordinates (y pointing down)
+			 */
+			struct PixelTriangle
+			{
+				float x[3], y[3];
+				uint8_t rgba[4];
+			};
+
+			/**	A segment, in pixel coordinates, turned into a quad at flush
+			 *	time (when the line width of its batch is known)
+			 */
+			struct PixelSegment
+			{
+				float x0, y0, x1, y1;
+				uint8_t rgba[4];
+				uint32_t nbFillBefore;	//	triangles of the batch added before it
+			};
+
+			struct Batch
+			{
+				std::vector<PixelTriangle> fill;
+				std::vector<PixelSegment> lines;
+				float lineWidth = 1.f;
+			};
+
+			int width_, height_;
+			int nbTilesX_, nbTilesY_;
+
+			/**	Rasterizing threads, started with the renderer
+			 */
+			WorkerPool pool_;
+
+			//	world to pixel mapping
+			float xmin_, ymax_;
+			float scaleX_, scaleY_;
+
+			Batch batch_[static_cast<int>(RenderBatch::NB_BATCHES)];
+
+			/**	All the triangles of a frame, in drawing order
+			 */
+			std::vector<PixelTriangle> triangles_;
+
+			/**	Indices (in triangles_) of the triangles overlapping each tile,
+			 *	in drawing order
+			 */
+			std::vector<std::vector<uint32_t> > tileBin_;
+
+			/**	Framebuffer, RGBA, top row first
+			 */
+			std::vector<uint8_t> pixels_;
+			uint8_t clearColor_[4];
+
+			unsigned int triangleCount_;
+
+			void toPixel_(const Transform2D& transform, float x, float y,
+						  float& px, float& py) const;
+			void pushTriangle_(std::vector<PixelTriangle>& fill, const float px[3],
+							   const float py[3], const uint8_t rgba[4]);
+			void pushSegmentQuad_(const PixelSegment& segment, float lineWidth);
+			void binTriangles_();
+			void rasterizeTile_(int tile);
+			void rasterizeTriangle_(const PixelTriangle& tri, int x0, int y0, int x1, int y1);
+
+		public:
+
+			/**	Creates a renderer and its framebuffer
+			 *	@PARAM width, height	size of the framebuffer, in pixels
+			 *	@PARAM nbThreads		number of rasterizing threads, or 0 for
+			 *							one per hardware thread
+			 */
+			SoftwareRenderer(int width, int height, unsigned int nbThreads = 0);
+			~SoftwareRenderer() = default;
+
+			/**	Sets the part of the world that the framebuffer shows
+			 */
+			void setView(float xmin, float xmax, float ymin, float ymax);
+
+			/**	Sets the color the framebuffer is cleared to
+			 */
+			void setClearColor(float r, float g, float b);
+
+			/**	Clears the framebuffer
+			 */
+			void clear();
+
+			void addPolygon(RenderBatch batch, const Transform2D& transform,
+							const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addTriangles(RenderBatch batch, const Transform2D& transform,
+							  const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addLineLoop(RenderBatch batch, const Transform2D& transform,
+							 const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void addLineStrip(RenderBatch batch, const Transform2D& transform,
+							  const float (*xy)[2], int nbPts, float r, float g, float b) override;
+			void setLineWidth(RenderBatch batch, float width) override;
+
+			/**	Rasterizes all the batches into the framebuffer and empties them
+			 */
+			void flush() override;
+
+			/**	Writes the framebuffer as a binary PPM image
+			 *	@RETURN	true if the file could be written
+			 */
+			bool writePPM(const std::string& path) const;
+
+			inline int getWidth() const
+			{
+				return width_;
+			}
+
+			inline int getHeight() const
+			{
+				return height_;
+			}
+
+			inline unsigned int getThreadCount() const
+			{
+				return pool_.getThreadCount();
+			}
+
+			/**	Number of triangles (lines included) rasterized by the last flush
+			 */
+			inline unsigned int getTriangleCount() const
+			{
+				return triangleCount_;
+			}
+
+			/**	The framebuffer, RGBA, top row first
+			 */
+			inline const std::vector<uint8_t>& getPixels() const
+			{
+				return pixels_;
+			}
+
+			//	Disabled constructors & operators
+			SoftwareRenderer(const SoftwareRenderer&) = delete;
+			SoftwareRenderer& operator = (const SoftwareRenderer&) = delete;
+	};
+}
+
+#endif	//	SOFTWARE_RENDERER_H
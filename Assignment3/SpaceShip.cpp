@@ -12,6 +12,7 @@
 #include "World2D.h"
 #include "SpaceShip.h"
 #include "Projectile.h"
+#include "Profiler.h"
 #include <iostream>
 
 using namespace std;
@@ -22,13 +23,28 @@ using namespace earshooter;
 #define	M_PI 3.14159265f
 #endif
 
-unsigned int SpaceShip::count_ = 0;
-unsigned int SpaceShip::liveCount_ = 0;
+atomic<unsigned int> SpaceShip::count_(0);
+atomic<unsigned int> SpaceShip::liveCount_(0);
 
 float SpaceShip::xy_[3][2] = { {1.f, 0.f},
 							 {cosf(2 * M_PI / 3), sinf(2 * M_PI / 3)},
 							 {cosf(2 * M_PI / 3), -sinf(2 * M_PI / 3)} };
 
+//	Outlines of the parts of the ship, before scaling by the radius
+const float SpaceShip::BODY_PTS[4][2] = {	{1.0f, 0.0f},		// Nose (now pointing right)
+											{-0.8f, 0.6f},		// Top rear
+											{-0.5f, 0.0f},		// Center rear
+											{-0.8f, -0.6f} };	// Bottom rear
+const float SpaceShip::WING_PTS[6][2] = {	{-0.5f, 0.4f}, {-1.2f, 1.0f}, {-1.0f, 0.4f},		// Top wing
+											{-0.5f, -0.4f}, {-1.2f, -1.0f}, {-1.0f, -0.4f} };	// Bottom wing
+const float SpaceShip::ENGINE_PTS[4][2] = {	{-0.8f, -0.2f}, {-1.0f, -0.2f},
+											{-1.0f, 0.2f}, {-0.8f, 0.2f} };
+float SpaceShip::cockpitPts_[SpaceShip::NUM_COCKPIT_PTS][2];
+bool SpaceShip::cockpitInitialized_ = SpaceShip::initCockpit_();
+//	baked after the cockpit's contour was computed
+BatchMesh SpaceShip::mesh_[2][2];
+bool SpaceShip::meshesBaked_ = SpaceShip::bakeMeshes_();
+
 
 #if 0
 //--------------------------------------
@@ -47,6 +63,8 @@ SpaceShip::SpaceShip(float cx, float cy, float angle, float radius, float r,
 	lastFireTime_(std::chrono::high_resolution_clock::now()), // Initialize lastFireTime
 	health_(100)
 {
+	MemoryScope memoryScope(MemoryCategory::SPACE_SHIP);
+
 	liveCount_++;
 	updateRelativeBox_();
 	updateAbsoluteBox_();
@@ -105,78 +123,55 @@ SpaceShip::~SpaceShip()
 #endif
 
 
-void SpaceShip::draw_() const
+void SpaceShip::draw_(Renderer2D& renderer, const Transform2D& transform) const
 {
-	float r = getR(), g = getG(), b = getB();
-
-	// Save the initial reference frame
-	glPushMatrix();
-
-	// Scale based on radius
-	glScalef(radius_, radius_, 1.f);
-
-	// Set the spaceship color
-	glColor3f(r, g, b);
-
-	// Main body of the spaceship
-	glBegin(GL_POLYGON);
-	glVertex2f(1.0f, 0.0f);             // Nose (now pointing right)
-	glVertex2f(-0.8f, 0.6f);            // Top rear
-	glVertex2f(-0.5f, 0.0f);            // Center rear
-	glVertex2f(-0.8f, -0.6f);           // Bottom rear
-	glEnd();
-
-	if (health_ >= 25) {
-		// Draw wings
-		glColor3f(r * 0.7f, g * 0.7f, b * 0.7f); // Slightly darker color for contrast
-		glBegin(GL_TRIANGLES);
-		// Top wing
-		glVertex2f(-0.5f, 0.4f);
-		glVertex2f(-1.2f, 1.0f);
-		glVertex2f(-1.0f, 0.4f);
-
-		// Bottom wing
-		glVertex2f(-0.5f, -0.4f);
-		glVertex2f(-1.2f, -1.0f);
-		glVertex2f(-1.0f, -0.4f);
-		glEnd();
-	}
-	// Draw engine
-	glColor3f(0.2f, 0.2f, 0.2f); // Dark color for the engine
-	glBegin(GL_POLYGON);
-	glVertex2f(-0.8f, -0.2f);
-	glVertex2f(-1.0f, -0.2f);
-	glVertex2f(-1.0f, 0.2f);
-	glVertex2f(-0.8f, 0.2f);
-	glEnd();
-
-	// Draw cockpit window
-	glColor3f(1.0f, 1.0f, 1.0f); // White color for the cockpit window
-	glBegin(GL_TRIANGLE_FAN);
-	glVertex2f(0.6f, 0.0f); // Center of the cockpit (aligned near nose)
-	for (int i = 0; i <= 20; ++i) {
-		float angle = 2 * M_PI * i / 20;
-		glVertex2f(0.6f + 0.1f * cos(angle), 0.1f * sin(angle));
-	}
-	glEnd();
-
-	// If drawContour is enabled
-	if (getDrawContour()) {
-		glColor3f(1.f - r, 1.f - g, 1.f - b); // Invert color for the contour
-		glBegin(GL_LINE_LOOP);
-		glVertex2f(1.0f, 0.0f);             // Nose
-		glVertex2f(-0.8f, 0.6f);            // Top rear
-		glVertex2f(-0.5f, 0.0f);            // Center rear
-		glVertex2f(-0.8f, -0.6f);           // Bottom rear
-		glEnd();
-	}
-
-	// Restore the original scale
-	glPopMatrix();
+	// Scale based on radius; wings are lost below 25 health
+	const BatchMesh& mesh = mesh_[health_ >= 25 ? 1 : 0][getDrawContour() ? 1 : 0];
+	renderer.addMesh(RenderBatch::SPACE_SHIP, transform.scaled(radius_, radius_), mesh,
+					 getR(), getG(), getB());
 }
 
 
 
+bool SpaceShip::initCockpit_()
+{
+	// Small disk near the nose
+	for (int i = 0; i < NUM_COCKPIT_PTS; ++i) {
+		float angle = 2 * M_PI * i / NUM_COCKPIT_PTS;
+		cockpitPts_[i][0] = 0.6f + 0.1f * cosf(angle);
+		cockpitPts_[i][1] = 0.1f * sinf(angle);
+	}
+	return true;
+}
+
+bool SpaceShip::bakeMeshes_()
+{
+	const Transform2D unit = Transform2D::identity();
+	for (int wings = 0; wings < 2; wings++)
+		for (int contour = 0; contour < 2; contour++)
+		{
+			BatchMesh& mesh = mesh_[wings][contour];
+
+			// Main body of the spaceship, in the color of the ship
+			mesh.addPolygon(unit, BODY_PTS, 4, 0.f, 0.f, 0.f, 1.f);
+			if (wings)
+			{
+				// Wings, slightly darker color for contrast
+				mesh.addTriangles(unit, WING_PTS, 6, 0.f, 0.f, 0.f, 0.7f);
+			}
+			// Engine, dark color
+			mesh.addPolygon(unit, ENGINE_PTS, 4, 0.2f, 0.2f, 0.2f, 0.f);
+			// Cockpit window, white
+			mesh.addPolygon(unit, cockpitPts_, NUM_COCKPIT_PTS, 1.f, 1.f, 1.f, 0.f);
+			if (contour)
+			{
+				// Inverted color for the contour
+				mesh.addLineLoop(unit, BODY_PTS, 4, 1.f, 1.f, 1.f, -1.f);
+			}
+		}
+	return true;
+}
+
 UpdateStatus SpaceShip::update(float dt)
 {
 	// Update the spaceship's angle
@@ -184,16 +179,21 @@ UpdateStatus SpaceShip::update(float dt)
 	// Call the parent class update method
 	UpdateStatus status = GraphicObject2D::update(dt);
 
-	// Collision detection with generic objects
-	for (const auto& obj : *objList_) {
-		// Check for collisions with generic objects only
-		if (obj->getObjectType() == ObjectType::Generic &&
-			this->getAbsoluteBoundingBox().intersects(obj->getAbsoluteBoundingBox())) {
-
-			decreaseHealth(25);  // Decrease health by 10 upon collision
-			obj->setDead(true);  // Mark the generic object as dead
-			break;               // Stop after processing one collision per update
-		}
+	// Collision detection with generic objects of the ship's world
+	// (only those of the sectors around it)
+	if (getWorld() != nullptr) {
+		ProfileScope collisionScope(ProfileZone::COLLISION);
+		collisionScope.addItems(getWorld()->forEachObjectNear(getX(), getY(), [this](GraphicObject2D& obj) {
+			// Check for collisions with generic objects only
+			if (obj.getObjectType() == ObjectType::Generic &&
+				this->getAbsoluteBoundingBox().intersects(obj.getAbsoluteBoundingBox())) {
+
+				decreaseHealth(25);  // Decrease health by 10 upon collision
+				obj.setDead(true);   // Mark the generic object as dead
+				return false;        // Stop after processing one collision per update
+			}
+			return true;
+		}));
 	}
 
 	if (health_ <= 50) {
@@ -203,13 +203,6 @@ UpdateStatus SpaceShip::update(float dt)
 	return status;
 }
 
-
-const std::list<std::shared_ptr<GraphicObject2D>>* SpaceShip::objList_ = nullptr;
-
-void SpaceShip::setObjectList(const std::list<std::shared_ptr<GraphicObject2D>>* objListPtr) {
-    objList_ = objListPtr;
-}
-
 bool SpaceShip::isInside(float x, float y) const
 {
 	return false;
@@ -281,7 +274,7 @@ void SpaceShip::updateRelativeBox_() {
 }
 
 void SpaceShip::fireProjectile() {
-	if (isAlive()) {
+	if (isAlive() && getWorld() != nullptr) {
 		// Get the current time
 		auto currentTime = std::chrono::high_resolution_clock::now();
 
@@ -298,7 +291,7 @@ void SpaceShip::fireProjectile() {
 			float vy = projectileSpeed * sinf(radAngle) + getVY();
 
 			// Create a new projectile with a lifetime, initial position, and velocity
-			Projectile::createProjectile(getX(), getY(), getAngle(), vx, vy, 1.75f);
+			Projectile::createProjectile(*getWorld(), getX(), getY(), getAngle(), vx, vy, 1.75f);
 
 			// Update the lastFireTime to the current time
 			lastFireTime_ = currentTime;
@@ -22,9 +22,6 @@ namespace earshooter
 	class SpaceShip : public GraphicObject2D
 	{
 	private:
-		/** List of objects for collision detection */
-		static const std::list<std::shared_ptr<GraphicObject2D>>* objList_;
-
 		/** Radius of the isosceles spaceship */
 		float radius_;
 
@@ -37,17 +34,33 @@ namespace earshooter
 		/** Array of coordinates representing an isosceles SpaceShip */
 		static float xy_[3][2];
 
+		/** Outlines of the body, wings (two triangles), and engine */
+		static const float BODY_PTS[4][2];
+		static const float WING_PTS[6][2];
+		static const float ENGINE_PTS[4][2];
+
+		/** Contour of the cockpit window, computed once */
+		static const int NUM_COCKPIT_PTS = 20;
+		static float cockpitPts_[NUM_COCKPIT_PTS][2];
+		static bool cockpitInitialized_;
+		static bool initCockpit_();
+
+		/** Geometry of the ship, baked once, indexed by [has wings][has contour] */
+		static BatchMesh mesh_[2][2];
+		static bool meshesBaked_;
+		static bool bakeMeshes_();
+
 		/** Counter of the number of SpaceShip objects created */
-		static unsigned int count_;
+		static std::atomic<unsigned int> count_;
 
 		/** Counter of the number of SpaceShip objects still "alive" */
-		static unsigned int liveCount_;
+		static std::atomic<unsigned int> liveCount_;
 
 		/** Private rendering function for this class. Translation and rotation
 		 * have already been applied by the base class, so this function only applies
 		 * scaling prior to rendering.
 		 */
-		void draw_() const override;
+		void draw_(Renderer2D& renderer, const Transform2D& transform) const override;
 
 		/** Health value for the spaceship */
 		int health_;
@@ -80,9 +93,6 @@ namespace earshooter
 		/** @return The current angular velocity of the spaceship */
 		float getAngularVelocity() const { return angularVelocity_; }
 
-		/** Sets the object list for collision detection */
-		static void setObjectList(const std::list<std::shared_ptr<GraphicObject2D>>* objListPtr);
-
 		/** @return True if the spaceship is alive, based on health */
 		bool isAlive() const { return health_ > 0; }
 
@@ -0,0 +1,387 @@
+//
+//  TextRenderer.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include "glPlatform.h"
+#include "TextRenderer.h"
+#include "GLStateCache.h"
+
+using namespace std;
+using namespace earshooter;
+
+//	The legacy (OpenGL 2.1) context that GLUT creates on macOS only has the
+//	EXT flavor of framebuffer objects: text is drawn with GLUT there.
+#if !defined(__APPLE__)
+	#define GLYPH_ATLAS
+#endif
+
+//	Room left on each side of a glyph in its cell, for glyphs that start
+//	left of their pen position
+const int CELL_MARGIN = 2;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+TextRenderer::TextRenderer()
+	:	nbRows_(0),
+		cellWidth_(0),
+		cellHeight_(0),
+		baseline_(0),
+		atlasWidth_(0),
+		atlasHeight_(0),
+		fontHeight_(0),
+		viewWidth_(0),
+		viewHeight_(0),
+		onLeft_(false),
+		onTop_(true),
+		hPad_(0),
+		vPad_(0),
+		textColor_{255, 255, 255, 255},
+		bgndColor_{0, 0, 0, 255},
+		hasBackground_(false),
+		streamIsDirty_(true),
+		ready_(false),
+		textureID_(0),
+		bufferID_(0)
+{
+	for (int k = 0; k < NB_GLYPHS; k++)
+		advance_[k] = 0;
+}
+
+TextRenderer::~TextRenderer()
+{
+	//	The GL context may be gone by the time global objects are destroyed,
+	//	so the texture and buffer are left for the context to release.
+}
+
+bool TextRenderer::initialize(void* font, int fontHeight)
+{
+	fontHeight_ = fontHeight;
+
+#ifdef GLYPH_ATLAS
+#if defined(_MSC_VER)
+	//	GLEW was initialized by the BatchRenderer
+	bool hasFramebuffers = GLEW_VERSION_3_0;
+#else
+	int major = 0, minor = 0;
+	const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+	if (version != nullptr)
+		sscanf(version, "%d.%d", &major, &minor);
+	bool hasFramebuffers = (major >= 3);
+#endif
+	if (!hasFramebuffers)
+	{
+		cout << "Framebuffer objects not supported: drawing text with GLUT" << endl;
+		return false;
+	}
+
+	//	Lay out the atlas: one cell per glyph, large enough for the widest one
+	int maxAdvance = 0;
+	for (int k = 0; k < NB_GLYPHS - 1; k++)
+	{
+		advance_[k] = glutBitmapWidth(font, FIRST_GLYPH + k);
+		if (advance_[k] > maxAdvance)
+			maxAdvance = advance_[k];
+	}
+	cellWidth_ = maxAdvance + 2 * CELL_MARGIN;
+	cellHeight_ = fontHeight + fontHeight / 2 + 2;
+	baseline_ = fontHeight / 3 + 1;
+	atlasWidth_ = ATLAS_COLUMNS * cellWidth_;
+	atlasHeight_ = ((NB_GLYPHS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS) * cellHeight_;
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	textureID_ = textureID;
+	glBindTexture(GL_TEXTURE_2D, textureID_);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, atlasWidth_, atlasHeight_, 0,
+				 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLuint framebuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureID_, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		cout << "Could not render the glyph atlas: drawing text with GLUT" << endl;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteTextures(1, &textureID);
+		textureID_ = 0;
+		return false;
+	}
+
+	//	Let GLUT draw the glyphs, in white over a transparent background:
+	//	the alpha of the atlas is the coverage of the glyphs.
+	glPushAttrib(GL_VIEWPORT_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_ENABLE_BIT);
+	glViewport(0, 0, atlasWidth_, atlasHeight_);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, atlasWidth_, 0, atlasHeight_, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glDisable(GL_TEXTURE_2D);
+	glDisable(GL_BLEND);
+	glDisable(GL_LIGHTING);
+	glClearColor(0.f, 0.f, 0.f, 0.f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glColor4f(1.f, 1.f, 1.f, 1.f);
+	for (int k = 0; k < NB_GLYPHS - 1; k++)
+	{
+		int x = (k % ATLAS_COLUMNS) * cellWidth_, y = (k / ATLAS_COLUMNS) * cellHeight_;
+		glRasterPos2i(x + CELL_MARGIN, y + baseline_);
+		glutBitmapCharacter(font, FIRST_GLYPH + k);
+	}
+	int solidX = (SOLID_CELL % ATLAS_COLUMNS) * cellWidth_,
+		solidY = (SOLID_CELL / ATLAS_COLUMNS) * cellHeight_;
+	glRecti(solidX, solidY, solidX + cellWidth_, solidY + cellHeight_);
+	glPopMatrix();
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopAttrib();
+	GLStateCache::invalidate();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &framebuffer);
+
+	GLuint bufferID;
+	glGenBuffers(1, &bufferID);
+	bufferID_ = bufferID;
+
+	ready_ = true;
+	return true;
+#else
+	(void) font;
+	return false;
+#endif
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Setters
+//--------------------------------------
+#endif
+
+void TextRenderer::setLayout(int viewWidth, int viewHeight, bool onLeft, bool onTop,
+							 int hPad, int vPad)
+{
+	if (viewWidth == viewWidth_ && viewHeight == viewHeight_ && onLeft == onLeft_ &&
+		onTop == onTop_ && hPad == hPad_ && vPad == vPad_)
+		return;
+
+	viewWidth_ = viewWidth;
+	viewHeight_ = viewHeight;
+	onLeft_ = onLeft;
+	onTop_ = onTop;
+	hPad_ = hPad;
+	vPad_ = vPad;
+	markAllDirty_();
+}
+
+void TextRenderer::setColors(const float text[3], const float* background)
+{
+	uint8_t textColor[4], bgndColor[4] = {0, 0, 0, 255};
+	for (int k = 0; k < 3; k++)
+	{
+		textColor[k] = static_cast<uint8_t>(text[k] * 255.f + 0.5f);
+		if (background != nullptr)
+			bgndColor[k] = static_cast<uint8_t>(background[k] * 255.f + 0.5f);
+	}
+	textColor[3] = 255;
+	bool hasBackground = (background != nullptr);
+
+	bool changed = (hasBackground != hasBackground_);
+	for (int k = 0; k < 4; k++)
+		changed = changed || (textColor[k] != textColor_[k]) || (bgndColor[k] != bgndColor_[k]);
+	if (!changed)
+		return;
+
+	for (int k = 0; k < 4; k++)
+	{
+		textColor_[k] = textColor[k];
+		bgndColor_[k] = bgndColor[k];
+	}
+	hasBackground_ = hasBackground;
+	markAllDirty_();
+}
+
+void TextRenderer::setRow(int index, const char* text)
+{
+	if (index < 0)
+		return;
+	if (index >= static_cast<int>(row_.size()))
+		row_.resize(index + 1);
+
+	Row& row = row_[index];
+	if (row.text != text)
+	{
+		row.text = text;
+		row.isDirty = true;
+	}
+}
+
+void TextRenderer::setRow(int index, const string& text)
+{
+	setRow(index, text.c_str());
+}
+
+void TextRenderer::setRowCount(int nbRows)
+{
+	if (nbRows > static_cast<int>(row_.size()))
+		row_.resize(nbRows);
+	if (nbRows != nbRows_)
+	{
+		nbRows_ = nbRows;
+		streamIsDirty_ = true;
+	}
+}
+
+void TextRenderer::markAllDirty_()
+{
+	for (Row& row : row_)
+		row.isDirty = true;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Rendering
+//--------------------------------------
+#endif
+
+inline void TextRenderer::pushQuad_(vector<TextVertex>& quads, float x0, float y0, float x1, float y1,
+									float u0, float v0, float u1, float v1,
+									const uint8_t rgba[4]) const
+{
+	TextVertex corner[4] = {{x0, y0, u0, v0, {rgba[0], rgba[1], rgba[2], rgba[3]}},
+							{x1, y0, u1, v0, {rgba[0], rgba[1], rgba[2], rgba[3]}},
+							{x1, y1, u1, v1, {rgba[0], rgba[1], rgba[2], rgba[3]}},
+							{x0, y1, u0, v1, {rgba[0], rgba[1], rgba[2], rgba[3]}}};
+	const int TRIANGLES[6] = {0, 1, 2, 0, 2, 3};
+	for (int k = 0; k < 6; k++)
+		quads.push_back(corner[TRIANGLES[k]]);
+}
+
+void TextRenderer::buildRow_(int index)
+{
+	Row& row = row_[index];
+	row.quads.clear();
+	row.isDirty = false;
+	if (row.text.empty())
+		return;
+
+	float rowHeight = static_cast<float>(fontHeight_ + 2 * vPad_);
+	float top = onTop_ ? index * rowHeight : viewHeight_ - (index + 1) * rowHeight;
+
+	if (hasBackground_)
+	{
+		//	sample the middle of the solid cell
+		float u = ((SOLID_CELL % ATLAS_COLUMNS) + 0.5f) * cellWidth_ / atlasWidth_,
+			  v = ((SOLID_CELL / ATLAS_COLUMNS) + 0.5f) * cellHeight_ / atlasHeight_;
+		pushQuad_(row.quads, 0.f, top, static_cast<float>(viewWidth_), top + rowHeight,
+				  u, v, u, v, bgndColor_);
+	}
+
+	//	Only printable ASCII characters are in the atlas
+	int textWidth = 0;
+	for (unsigned char c : row.text)
+		if (c >= FIRST_GLYPH && c < FIRST_GLYPH + SOLID_CELL)
+			textWidth += advance_[c - FIRST_GLYPH];
+
+	float x = static_cast<float>(onLeft_ ? hPad_ : viewWidth_ - textWidth - hPad_);
+	float baseline = top + fontHeight_ + vPad_;
+	for (unsigned char c : row.text)
+	{
+		if (c < FIRST_GLYPH || c >= FIRST_GLYPH + SOLID_CELL)
+			continue;
+
+		int glyph = c - FIRST_GLYPH;
+		if (c != ' ')
+		{
+			//	y points down on screen, up in the atlas
+			int cellX = (glyph % ATLAS_COLUMNS) * cellWidth_,
+				cellY = (glyph / ATLAS_COLUMNS) * cellHeight_;
+			float x0 = x - CELL_MARGIN;
+			pushQuad_(row.quads, x0, baseline - (cellHeight_ - baseline_),
+					  x0 + cellWidth_, baseline + baseline_,
+					  static_cast<float>(cellX) / atlasWidth_,
+					  static_cast<float>(cellY + cellHeight_) / atlasHeight_,
+					  static_cast<float>(cellX + cellWidth_) / atlasWidth_,
+					  static_cast<float>(cellY) / atlasHeight_,
+					  textColor_);
+		}
+		x += advance_[glyph];
+	}
+}
+
+void TextRenderer::draw()
+{
+	if (!ready_ || nbRows_ == 0)
+		return;
+
+	for (int k = 0; k < nbRows_; k++)
+	{
+		if (row_[k].isDirty)
+		{
+			buildRow_(k);
+			streamIsDirty_ = true;
+		}
+	}
+
+	if (streamIsDirty_)
+	{
+		stream_.clear();
+		for (int k = 0; k < nbRows_; k++)
+			stream_.insert(stream_.end(), row_[k].quads.begin(), row_[k].quads.end());
+		GLStateCache::bindArrayBuffer(bufferID_);
+		glBufferData(GL_ARRAY_BUFFER, stream_.size() * sizeof(TextVertex),
+					 stream_.data(), GL_DYNAMIC_DRAW);
+		streamIsDirty_ = false;
+	}
+	else
+		GLStateCache::bindArrayBuffer(bufferID_);
+
+	if (!stream_.empty())
+	{
+		glBindTexture(GL_TEXTURE_2D, textureID_);
+		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+		glEnable(GL_TEXTURE_2D);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		GLStateCache::setClientState(GL_VERTEX_ARRAY, true);
+		GLStateCache::setClientState(GL_TEXTURE_COORD_ARRAY, true);
+		GLStateCache::setClientState(GL_COLOR_ARRAY, true);
+		glVertexPointer(2, GL_FLOAT, sizeof(TextVertex),
+						reinterpret_cast<const GLvoid*>(offsetof(TextVertex, x)));
+		glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex),
+						  reinterpret_cast<const GLvoid*>(offsetof(TextVertex, u)));
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex),
+					   reinterpret_cast<const GLvoid*>(offsetof(TextVertex, rgba)));
+		glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(stream_.size()));
+		GLStateCache::setClientState(GL_COLOR_ARRAY, false);
+		GLStateCache::setClientState(GL_TEXTURE_COORD_ARRAY, false);
+		GLStateCache::setClientState(GL_VERTEX_ARRAY, false);
+
+		glDisable(GL_BLEND);
+		glDisable(GL_TEXTURE_2D);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	GLStateCache::bindArrayBuffer(0);
+}
@@ -0,0 +1,141 @@
+//
+//  TextRenderer.h
+//  Week 08 - Earshooter
+//
+//	Draws the rows of text of the HUD from a texture atlas of the glyphs of
+//	a GLUT bitmap font.  The glyphs are rendered by GLUT once, into an
+//	offscreen framebuffer, and read back into the atlas.  Each row keeps the
+//	last string it was given, and the quads of a row are only rebuilt when
+//	that string (or the colors, or the size of the window) actually changes.
+//	All the rows, with their background, are then drawn with a single
+//	glDrawArrays call.  Building the atlas requires framebuffer objects
+//	(OpenGL 3.0); without them, isReady() reports false and the caller should
+//	keep drawing text with GLUT.
+
+#ifndef TEXT_RENDERER_H
+#define TEXT_RENDERER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace earshooter
+{
+	/**	Vertex of a glyph quad: pixel coordinates (y pointing down), atlas
+	 *	texture coordinates, and RGBA color
+	 */
+	struct TextVertex
+	{
+		float x, y;
+		float u, v;
+		uint8_t rgba[4];
+	};
+
+	class TextRenderer
+	{
+		private:
+
+			/**	Glyphs in the atlas: printable ASCII, plus one solid cell used
+			 *	for the background of the rows
+			 */
+			static const int FIRST_GLYPH = 32;
+			static const int NB_GLYPHS = 96;
+			static const int SOLID_CELL = NB_GLYPHS - 1;
+			static const int ATLAS_COLUMNS = 16;
+
+			struct Row
+			{
+				std::string text;
+				std::vector<TextVertex> quads;
+				bool isDirty = true;
+			};
+
+			std::vector<Row> row_;
+			int nbRows_;
+
+			//	atlas geometry, in pixels
+			int cellWidth_, cellHeight_;
+			int baseline_;				//	height of the baseline above the bottom of a cell
+			int atlasWidth_, atlasHeight_;
+			int advance_[NB_GLYPHS];
+
+			//	layout of the rows, in pixels
+			int fontHeight_;
+			int viewWidth_, viewHeight_;
+			bool onLeft_, onTop_;
+			int hPad_, vPad_;
+
+			uint8_t textColor_[4];
+			uint8_t bgndColor_[4];
+			bool hasBackground_;
+
+			/**	All the rows' quads, back to back, as uploaded
+			 */
+			std::vector<TextVertex> stream_;
+			bool streamIsDirty_;
+
+			bool ready_;
+			unsigned int textureID_;
+			unsigned int bufferID_;
+
+			void buildRow_(int index);
+			void pushQuad_(std::vector<TextVertex>& quads, float x0, float y0, float x1, float y1,
+						   float u0, float v0, float u1, float v1, const uint8_t rgba[4]) const;
+			void markAllDirty_();
+
+		public:
+
+			TextRenderer();
+			~TextRenderer();
+
+			/**	Builds the glyph atlas.  Must be called once the OpenGL context
+			 *	exists (after the window was created).
+			 *	@PARAM font			a GLUT bitmap font (e.g. GLUT_BITMAP_HELVETICA_18)
+			 *	@PARAM fontHeight	height of the text, used to lay out the rows
+			 *	@RETURN	true if the atlas could be built
+			 */
+			bool initialize(void* font, int fontHeight);
+
+			/**	Sets where the rows are drawn
+			 *	@PARAM viewWidth, viewHeight	size of the window, in pixels
+			 *	@PARAM onLeft	true to align the text on the left, false on the right
+			 *	@PARAM onTop	true to stack the rows from the top of the window
+			 *	@PARAM hPad, vPad	padding around the text, in pixels
+			 */
+			void setLayout(int viewWidth, int viewHeight, bool onLeft, bool onTop,
+						   int hPad, int vPad);
+
+			/**	Sets the colors of the text and of the background of the rows
+			 *	@PARAM background	color of the background, or nullptr for none
+			 */
+			void setColors(const float text[3], const float* background);
+
+			/**	Sets the text of a row.  The row is only rebuilt if the text
+			 *	differs from the last one.
+			 */
+			void setRow(int index, const char* text);
+			void setRow(int index, const std::string& text);
+
+			/**	Sets the number of rows drawn (the ones after are kept, but
+			 *	hidden)
+			 */
+			void setRowCount(int nbRows);
+
+			/**	Draws all the rows, in pixel coordinates with y pointing down
+			 */
+			void draw();
+
+			/**	Reports whether the atlas was built
+			 */
+			inline bool isReady() const
+			{
+				return ready_;
+			}
+
+			//	Disabled constructors & operators
+			TextRenderer(const TextRenderer&) = delete;
+			TextRenderer& operator = (const TextRenderer&) = delete;
+	};
+}
+
+#endif	//	TEXT_RENDERER_H
@@ -0,0 +1,235 @@
+//
+//  TraceRecorder.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "TraceRecorder.h"
+
+using namespace std;
+using namespace earshooter;
+
+const int TraceRecorder::RING_CAPACITY = 1 << 18;
+const char* TraceRecorder::DEFAULT_OUTPUT_PATH = "earshooter_trace.json";
+
+atomic<bool> TraceRecorder::recording_(false);
+atomic<uint64_t> TraceRecorder::captureCount_(0);
+uint64_t TraceRecorder::stopTimeNs_ = 0;
+string TraceRecorder::outputPath_ = TraceRecorder::DEFAULT_OUTPUT_PATH;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Per-thread ring buffers
+//--------------------------------------
+#endif
+
+namespace
+{
+	/**	Fixed-size event buffer written by a single thread.  The write index
+	 *	and the capture the events belong to are published with release
+	 *	semantics, so that the thread writing the trace file sees complete
+	 *	events, of the current capture.
+	 */
+	struct TraceRing
+	{
+		int threadIndex;
+		vector<TraceEvent> events;
+		atomic<uint64_t> head;
+		atomic<uint64_t> capture;
+
+		explicit TraceRing(int index)
+			:	threadIndex(index),
+				events(TraceRecorder::RING_CAPACITY),
+				head(0),
+				capture(0)
+		{
+		}
+	};
+
+	/**	The ring of a thread, given back when the thread exits
+	 */
+	struct LocalRing
+	{
+		TraceRing* ring = nullptr;
+
+		~LocalRing();
+	};
+
+	//	Held while a capture starts or stops (and its trace is written)
+	mutex captureLock;
+
+	mutex ringListLock;
+	vector<unique_ptr<TraceRing> > ringList;
+	//	rings of the threads that exited, for the next threads to use
+	vector<TraceRing*> freeRingList;
+	thread_local LocalRing localRing;
+
+	TraceRing* getLocalRing()
+	{
+		if (localRing.ring == nullptr)
+		{
+			lock_guard<mutex> lock(ringListLock);
+			if (freeRingList.empty())
+			{
+				ringList.push_back(make_unique<TraceRing>(static_cast<int>(ringList.size())));
+				localRing.ring = ringList.back().get();
+			}
+			else
+			{
+				localRing.ring = freeRingList.back();
+				freeRingList.pop_back();
+			}
+		}
+		return localRing.ring;
+	}
+
+	//	The events already recorded stay in the ring, to be written with the
+	//	trace if their capture is still the current one.
+	LocalRing::~LocalRing()
+	{
+		if (ring != nullptr)
+		{
+			lock_guard<mutex> lock(ringListLock);
+			freeRingList.push_back(ring);
+		}
+	}
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Capture control
+//--------------------------------------
+#endif
+
+void TraceRecorder::start(float seconds, const string& path)
+{
+	lock_guard<mutex> lock(captureLock);
+	if (isRecording())
+		return;
+
+	//	make sure the calling thread's ring is allocated before timing starts
+	getLocalRing();
+	captureCount_.fetch_add(1, memory_order_release);
+	outputPath_ = path;
+	stopTimeNs_ = now() + static_cast<uint64_t>(seconds * 1.0e9);
+	recording_.store(true, memory_order_release);
+
+	cout << "Trace capture started for " << seconds << " s" << endl;
+}
+
+void TraceRecorder::stop()
+{
+	lock_guard<mutex> lock(captureLock);
+	if (!isRecording())
+		return;
+
+	recording_.store(false, memory_order_release);
+	if (writeChromeTrace_(outputPath_))
+		cout << "Trace written to " << outputPath_ << endl;
+	else
+		cerr << "Could not write trace file " << outputPath_ << endl;
+}
+
+void TraceRecorder::poll()
+{
+	if (isRecording() && now() >= stopTimeNs_)
+		stop();
+}
+
+void TraceRecorder::record(const char* name, const char* category,
+						   uint64_t startNs, uint64_t durationNs)
+{
+	TraceRing* ring = getLocalRing();
+	uint64_t head = ring->head.load(memory_order_relaxed);
+	//	the first event of a new capture drops the ones of the previous one
+	uint64_t capture = captureCount_.load(memory_order_acquire);
+	if (ring->capture.load(memory_order_relaxed) != capture)
+	{
+		head = 0;
+		ring->head.store(0, memory_order_relaxed);
+		ring->capture.store(capture, memory_order_release);
+	}
+	ring->events[head % RING_CAPACITY] = TraceEvent{name, category, startNs, durationNs};
+	ring->head.store(head + 1, memory_order_release);
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Export
+//--------------------------------------
+#endif
+
+bool TraceRecorder::writeChromeTrace_(const string& path)
+{
+	ofstream out(path);
+	if (!out)
+		return false;
+
+	lock_guard<mutex> lock(ringListLock);
+
+	//	The events of each ring, if it has some of the current capture.  A
+	//	thread that tested isRecording() just before the capture stopped may
+	//	still be writing one event, over the oldest one of a full ring: that
+	//	slot is left out.
+	uint64_t capture = captureCount_.load(memory_order_relaxed);
+	vector<uint64_t> firstList(ringList.size()), headList(ringList.size());
+	for (size_t r = 0; r < ringList.size(); r++)
+	{
+		const TraceRing& ring = *ringList[r];
+		uint64_t head = 0;
+		if (ring.capture.load(memory_order_acquire) == capture)
+			head = ring.head.load(memory_order_acquire);
+		headList[r] = head;
+		firstList[r] = head >= static_cast<uint64_t>(RING_CAPACITY) ? head - RING_CAPACITY + 1 : 0;
+	}
+
+	//	Time stamps are made relative to the earliest event, in microseconds
+	uint64_t origin = UINT64_MAX;
+	for (size_t r = 0; r < ringList.size(); r++)
+		for (uint64_t k = firstList[r]; k < headList[r]; k++)
+			origin = min(origin, ringList[r]->events[k % RING_CAPACITY].startNs);
+
+	out << fixed << setprecision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool firstEvent = true;
+	uint64_t dropped = 0;
+	for (size_t r = 0; r < ringList.size(); r++)
+	{
+		const TraceRing* ring = ringList[r].get();
+		uint64_t head = headList[r];
+		if (head == 0)
+			continue;
+
+		out << (firstEvent ? "" : ",\n")
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadIndex
+			<< ",\"args\":{\"name\":\"thread " << ring->threadIndex << "\"}}";
+		firstEvent = false;
+
+		uint64_t first = firstList[r];
+		dropped += first;
+		for (uint64_t k = first; k < head; k++)
+		{
+			const TraceEvent& event = ring->events[k % RING_CAPACITY];
+			out << ",\n{\"name\":\"" << event.name
+				<< "\",\"cat\":\"" << event.category
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadIndex
+				<< ",\"ts\":" << (event.startNs - origin) / 1000.0
+				<< ",\"dur\":" << event.durationNs / 1000.0 << "}";
+		}
+	}
+	out << "\n]}\n";
+
+	if (dropped > 0)
+		cout << "Trace: " << dropped << " oldest events were overwritten" << endl;
+
+	return static_cast<bool>(out);
+}
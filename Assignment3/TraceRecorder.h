@@ -0,0 +1,141 @@
+//
+//  TraceRecorder.h
+//  Week 08 - Earshooter
+//
+//	Records per-phase begin/end timings into per-thread ring buffers and
+//	exports them as a Chrome Trace Event JSON file (load it in
+//	chrome://tracing or ui.perfetto.dev).  When no capture is running, the
+//	only cost left in the instrumented code is the test of an atomic flag.
+//	Each ring is written by its thread only: the first event a thread
+//	records in a new capture is what discards the events it recorded in
+//	the previous one.  The ring of a thread that exits goes to the next
+//	thread that records an event.
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace earshooter
+{
+	/**	A complete ("X" phase) trace event.  The name and category must be
+	 *	string literals (or otherwise outlive the capture).
+	 */
+	struct TraceEvent
+	{
+		const char* name;
+		const char* category;
+		uint64_t startNs;
+		uint64_t durationNs;
+	};
+
+	struct TraceRecorder
+	{
+		/**	Number of events kept per thread.  Older events get overwritten
+		 *	when a capture produces more than this.
+		 */
+		static const int RING_CAPACITY;
+
+		/**	Default name of the file written at the end of a capture
+		 */
+		static const char* DEFAULT_OUTPUT_PATH;
+
+		/**	Reports whether a capture is in progress.  This is the only thing
+		 *	evaluated by instrumented code when tracing is off.
+		 */
+		inline static bool isRecording()
+		{
+			return recording_.load(std::memory_order_relaxed);
+		}
+
+		/**	Starts a capture of the given duration.  Does nothing if a capture
+		 *	is already in progress.
+		 *	@PARAM seconds	duration of the capture
+		 *	@PARAM path		file the trace is written to when the capture ends
+		 */
+		static void start(float seconds, const std::string& path = DEFAULT_OUTPUT_PATH);
+
+		/**	Ends the current capture (if any) and writes the trace file
+		 */
+		static void stop();
+
+		/**	To be called periodically (e.g. once per simulation step): ends the
+		 *	capture once its duration has elapsed.
+		 */
+		static void poll();
+
+		/**	Records a complete event in the calling thread's ring buffer
+		 *	@PARAM name			name of the phase
+		 *	@PARAM category		category of the phase ("sim", "render", ...)
+		 *	@PARAM startNs		start time, as returned by now()
+		 *	@PARAM durationNs	duration, in nanoseconds
+		 */
+		static void record(const char* name, const char* category,
+						   uint64_t startNs, uint64_t durationNs);
+
+		/**	Returns the current time in ns, on the clock used for traces
+		 */
+		inline static uint64_t now()
+		{
+			return toNs(std::chrono::steady_clock::now());
+		}
+
+		/**	Converts a steady_clock time point to the ns used for traces
+		 */
+		inline static uint64_t toNs(std::chrono::steady_clock::time_point t)
+		{
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+											t.time_since_epoch()).count());
+		}
+
+		private:
+			static std::atomic<bool> recording_;
+			/**	number of captures started so far, which identifies the
+			 *	current one
+			 */
+			static std::atomic<uint64_t> captureCount_;
+			static uint64_t stopTimeNs_;
+			static std::string outputPath_;
+
+			static bool writeChromeTrace_(const std::string& path);
+
+			TraceRecorder() = delete;
+	};
+
+	/**	RAII marker of a traced phase that is not otherwise a profiler zone
+	 *	(e.g. a whole simulation step or rendered frame).  Does not even
+	 *	read the clock when no capture is in progress.
+	 */
+	class TraceScope
+	{
+		private:
+			const char* name_;
+			const char* category_;
+			uint64_t startNs_;
+
+		public:
+			inline TraceScope(const char* name, const char* category)
+				:	name_(name),
+					category_(category),
+					startNs_(TraceRecorder::isRecording() ? TraceRecorder::now() : 0)
+			{
+			}
+
+			inline ~TraceScope()
+			{
+				if (startNs_ != 0 && TraceRecorder::isRecording())
+					TraceRecorder::record(name_, category_, startNs_,
+										  TraceRecorder::now() - startNs_);
+			}
+
+			//	Disabled constructors & operators
+			TraceScope() = delete;
+			TraceScope(const TraceScope&) = delete;
+			TraceScope& operator = (const TraceScope&) = delete;
+	};
+}
+
+#endif	//	TRACE_RECORDER_H
@@ -0,0 +1,88 @@
+//
+//  Transform2D.h
+//  Week 08 - Earshooter
+//
+//	2D affine transformation, used to compute on the CPU what the
+//	glTranslatef/glRotatef/glScalef calls used to do on the matrix stack.
+//	As with OpenGL's matrix functions, translated, rotated, and scaled
+//	post-multiply the current transformation, so a sequence of calls reads
+//	in the same order as the matrix stack code it replaces.
+
+#ifndef TRANSFORM_2D_H
+#define TRANSFORM_2D_H
+
+#include <cmath>
+
+namespace earshooter
+{
+	struct Transform2D
+	{
+		//	x' = a*x + c*y + tx
+		//	y' = b*x + d*y + ty
+		float a, b, c, d, tx, ty;
+
+		/**	Returns the identity transformation
+		 */
+		inline static Transform2D identity()
+		{
+			return Transform2D{1.f, 0.f, 0.f, 1.f, 0.f, 0.f};
+		}
+
+		/**	Returns a pure translation
+		 */
+		inline static Transform2D translation(float dx, float dy)
+		{
+			return Transform2D{1.f, 0.f, 0.f, 1.f, dx, dy};
+		}
+
+		/**	Returns this transformation followed (in local coordinates) by a
+		 *	translation, like glTranslatef
+		 */
+		inline Transform2D translated(float dx, float dy) const
+		{
+			return Transform2D{a, b, c, d, tx + a*dx + c*dy, ty + b*dx + d*dy};
+		}
+
+		/**	Returns this transformation followed (in local coordinates) by a
+		 *	rotation, like glRotatef around the z axis
+		 *	@PARAM degrees	angle of the rotation, in degree
+		 */
+		inline Transform2D rotated(float degrees) const
+		{
+			float radians = degrees * 0.0174532925f;
+			float ct = cosf(radians), st = sinf(radians);
+			return Transform2D{	 a*ct + c*st,  b*ct + d*st,
+								-a*st + c*ct, -b*st + d*ct,
+								tx, ty};
+		}
+
+		/**	Returns this transformation followed (in local coordinates) by a
+		 *	scaling, like glScalef
+		 */
+		inline Transform2D scaled(float sx, float sy) const
+		{
+			return Transform2D{a*sx, b*sx, c*sy, d*sy, tx, ty};
+		}
+
+		/**	Applies the transformation to a point
+		 */
+		inline void apply(float x, float y, float& outX, float& outY) const
+		{
+			outX = a*x + c*y + tx;
+			outY = b*x + d*y + ty;
+		}
+
+		/**	Writes the transformation as a column-major 4x4 matrix, to be
+		 *	loaded with glMultMatrixf
+		 */
+		inline void toGLMatrix(float m[16]) const
+		{
+			m[0] = a;	m[4] = c;	m[8] = 0.f;		m[12] = tx;
+			m[1] = b;	m[5] = d;	m[9] = 0.f;		m[13] = ty;
+			m[2] = 0.f;	m[6] = 0.f;	m[10] = 1.f;	m[14] = 0.f;
+			m[3] = 0.f;	m[7] = 0.f;	m[11] = 0.f;	m[15] = 1.f;
+		}
+	};
+}
+
+#endif	//	TRANSFORM_2D_H
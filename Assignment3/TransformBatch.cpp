@@ -0,0 +1,106 @@
+//
+//  TransformBatch.cpp
+//  Week 08 - Earshooter
+//
+
+#include <cmath>
+#include "TransformBatch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_TRANSFORMS
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace earshooter;
+
+const float DEGREE_TO_RADIAN = 0.0174532925f;
+
+//	Minimax polynomials of sine and cosine over [-pi/4, pi/4] (from Cephes)
+const float SIN_C1 = -1.6666654611e-1f;
+const float SIN_C2 = 8.3321608736e-3f;
+const float SIN_C3 = -1.9515295891e-4f;
+const float COS_C1 = 4.166664568298827e-2f;
+const float COS_C2 = -1.388731625493765e-3f;
+const float COS_C3 = 2.443315711809948e-5f;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Free functions
+//--------------------------------------
+#endif
+
+void earshooter::cosSinDegrees(float degrees, float& cosine, float& sine)
+{
+	//	the nearest quarter turn, and what's left of the angle (within +/- 45 degrees)
+	float quarter = nearbyintf(degrees * (1.f / 90.f));
+	float r = (degrees - 90.f * quarter) * DEGREE_TO_RADIAN;
+	float r2 = r * r;
+	float s = r + r * r2 * (SIN_C1 + r2 * (SIN_C2 + r2 * SIN_C3));
+	float c = 1.f - 0.5f * r2 + r2 * r2 * (COS_C1 + r2 * (COS_C2 + r2 * COS_C3));
+
+	//	each quarter turn maps (cos, sin) to (-sin, cos)
+	int q = static_cast<int>(quarter) & 3;
+	float cq = (q & 1) ? s : c;
+	float sq = (q & 1) ? c : s;
+	cosine = ((q + 1) & 2) ? -cq : cq;
+	sine = (q & 2) ? -sq : sq;
+}
+
+void earshooter::computeModelTransforms(const float* x, const float* y, const float* degrees,
+										int n, Transform2D* model)
+{
+	int k = 0;
+#ifdef SIMD_TRANSFORMS
+	const __m128 toQuarter = _mm_set1_ps(1.f / 90.f);
+	const __m128 quarterDegrees = _mm_set1_ps(90.f);
+	const __m128 toRadian = _mm_set1_ps(DEGREE_TO_RADIAN);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 signBit = _mm_set1_ps(-0.f);
+	const __m128i one32 = _mm_set1_epi32(1);
+	const __m128i two32 = _mm_set1_epi32(2);
+	for (; k + 4 <= n; k += 4)
+	{
+		__m128 deg = _mm_loadu_ps(degrees + k);
+		//	rounds to nearest, like nearbyintf
+		__m128i quarter = _mm_cvtps_epi32(_mm_mul_ps(deg, toQuarter));
+		__m128 r = _mm_mul_ps(_mm_sub_ps(deg, _mm_mul_ps(quarterDegrees, _mm_cvtepi32_ps(quarter))),
+							  toRadian);
+		__m128 r2 = _mm_mul_ps(r, r);
+
+		__m128 s = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(SIN_C3)), _mm_set1_ps(SIN_C2));
+		s = _mm_add_ps(_mm_mul_ps(r2, s), _mm_set1_ps(SIN_C1));
+		s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+		__m128 c = _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(COS_C3)), _mm_set1_ps(COS_C2));
+		c = _mm_add_ps(_mm_mul_ps(r2, c), _mm_set1_ps(COS_C1));
+		c = _mm_add_ps(_mm_sub_ps(one, _mm_mul_ps(half, r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), c));
+
+		//	odd quarters swap cosine and sine, then the signs follow the quadrant
+		__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quarter, one32), one32));
+		__m128 cq = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+		__m128 sq = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+		__m128 cosSign = _mm_and_ps(signBit, _mm_castsi128_ps(_mm_cmpeq_epi32(
+							_mm_and_si128(_mm_add_epi32(quarter, one32), two32), two32)));
+		__m128 sinSign = _mm_and_ps(signBit, _mm_castsi128_ps(_mm_cmpeq_epi32(
+							_mm_and_si128(quarter, two32), two32)));
+		__m128 cosine = _mm_xor_ps(cq, cosSign);
+		__m128 sine = _mm_xor_ps(sq, sinSign);
+
+		alignas(16) float ct[4], st[4];
+		_mm_store_ps(ct, cosine);
+		_mm_store_ps(st, sine);
+		for (int j = 0; j < 4; j++)
+			model[k + j] = Transform2D{ct[j], st[j], -st[j], ct[j], x[k + j], y[k + j]};
+	}
+#endif
+
+	//	what's left (or all of it, without SIMD)
+	for (; k < n; k++)
+	{
+		float ct, st;
+		cosSinDegrees(degrees[k], ct, st);
+		model[k] = Transform2D{ct, st, -st, ct, x[k], y[k]};
+	}
+}
@@ -0,0 +1,36 @@
+//
+//  TransformBatch.h
+//  Week 08 - Earshooter
+//
+//	Computes the model transformations (translation, then rotation) of many
+//	objects at once, instead of one object at a time from its draw function.
+//	The poses come in as separate arrays of x, y, and angle, so that four
+//	of them can be processed at a time with SSE2.  The sine and cosine are
+//	evaluated with a polynomial after reducing the angle to the nearest
+//	quarter turn, which is exact in degrees.  Other architectures get the
+//	scalar version of the same code, which gives the same results.
+
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include "Transform2D.h"
+
+namespace earshooter
+{
+	/**	Computes the transformations that translate and then rotate, like
+	 *	Transform2D::translation(x, y).rotated(degrees), for a batch of poses
+	 *	@PARAM x, y		positions, in world units
+	 *	@PARAM degrees	orientations, in degree
+	 *	@PARAM n		number of poses
+	 *	@PARAM model	receives the n transformations
+	 */
+	void computeModelTransforms(const float* x, const float* y, const float* degrees, int n,
+								Transform2D* model);
+
+	/**	Cosine and sine of an angle, as computed by computeModelTransforms
+	 *	@PARAM degrees	angle, in degree
+	 */
+	void cosSinDegrees(float degrees, float& cosine, float& sine);
+}
+
+#endif	//	TRANSFORM_BATCH_H
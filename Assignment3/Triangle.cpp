@@ -20,8 +20,8 @@ using namespace earshooter;
 #define	M_PI 3.14159265f
 #endif
 
-unsigned int Triangle::count_ = 0;
-unsigned int Triangle::liveCount_ = 0;
+atomic<unsigned int> Triangle::count_(0);
+atomic<unsigned int> Triangle::liveCount_(0);
 
 float Triangle::xy_[3][2] = {{1.f, 0.f},
 							 {cosf(2*M_PI/3), sinf(2*M_PI/3)},
@@ -42,6 +42,8 @@ Triangle::Triangle(float cx, float cy, float angle, float radius, float r,
 		radius_(radius),
 		index_(count_++)
 {
+	MemoryScope memoryScope(MemoryCategory::TRIANGLE);
+
 	liveCount_++;
 	updateRelativeBox_();
 	updateAbsoluteBox_();
@@ -89,37 +91,15 @@ Triangle::~Triangle()
 #endif
 
 
-void Triangle::draw_() const
+void Triangle::draw_(Renderer2D& renderer, const Transform2D& transform) const
 {
 	float r = getR(), g = getG(), b = getB();
 	
-	//	save the initial reference frame
-	glPushMatrix();
-	
-	glScalef(radius_, radius_, 1.f);
-	
-	glColor3f(r, g, b);
-	glBegin(GL_POLYGON);
-		//	 vertex coordinates are relative to the center of the triangle
-		glVertex2fv(xy_[0]);
-		glVertex2fv(xy_[1]);
-		glVertex2fv(xy_[2]);
-	glEnd();
-
-	if (getDrawContour())
-	{
-		// simply invert the filling color
-		glColor3f(1.f-r, 1.f-g, 1.f-b);
-		glBegin(GL_LINE_LOOP);
-			//	 vertex coordinates are relative to the center of the triangle
-			glVertex2fv(xy_[0]);
-			glVertex2fv(xy_[1]);
-			glVertex2fv(xy_[2]);
-		glEnd();
-	}
-	
-	//	restore the original scale
-	glPopMatrix();
+	//	vertex coordinates are relative to the center of the triangle
+	Transform2D scaled = transform.scaled(radius_, radius_);
+	//	the contour simply inverts the filling color
+	renderer.addShape(RenderBatch::TRIANGLE, scaled, UnitShape::TRIANGLE,
+					  xy_, 3, getDrawContour(), r, g, b);
 }
 
 UpdateStatus Triangle::update(float dt)
@@ -162,25 +142,26 @@ void Triangle::updateRelativeBox_() {
 }
 
 void Triangle::updateAbsoluteBox_() {
-	// Retrieve the triangle's center position using the getX() and getY() methods
-	float cx = getX();
-	float cy = getY();
+	BoundingBox box = computeAbsoluteBox(getX(), getY(), getAngle(), radius_);
+	setAbsoluteBoundingBox(box.getXmin(), box.getXmax(), box.getYmin(), box.getYmax());
+}
 
+BoundingBox Triangle::computeAbsoluteBox(float cx, float cy, float angle, float radius) {
 	// Angle of the triangle in radians
-	float angle = M_PI * getAngle() / 180.f;
-	float cA = cosf(angle);
-	float sA = sinf(angle);
+	float radAngle = M_PI * angle / 180.f;
+	float cA = cosf(radAngle);
+	float sA = sinf(radAngle);
 
 	// Define the triangle vertices based on radius and angle
 	// Assuming radius defines the distance from the center to each vertex
-	float x1 = cx + (xy_[0][0] * cA - xy_[0][1] * sA) * radius_;
-	float y1 = cy + (xy_[0][0] * sA + xy_[0][1] * cA) * radius_;
+	float x1 = cx + (xy_[0][0] * cA - xy_[0][1] * sA) * radius;
+	float y1 = cy + (xy_[0][0] * sA + xy_[0][1] * cA) * radius;
 
-	float x2 = cx + (xy_[1][0] * cA - xy_[1][1] * sA) * radius_;
-	float y2 = cy + (xy_[1][0] * sA + xy_[1][1] * cA) * radius_;
+	float x2 = cx + (xy_[1][0] * cA - xy_[1][1] * sA) * radius;
+	float y2 = cy + (xy_[1][0] * sA + xy_[1][1] * cA) * radius;
 
-	float x3 = cx + (xy_[2][0] * cA - xy_[2][1] * sA) * radius_;
-	float y3 = cy + (xy_[2][0] * sA + xy_[2][1] * cA) * radius_;
+	float x3 = cx + (xy_[2][0] * cA - xy_[2][1] * sA) * radius;
+	float y3 = cy + (xy_[2][0] * sA + xy_[2][1] * cA) * radius;
 
 	// Calculate min and max for the bounding box
 	float minX = x1;
@@ -199,8 +180,7 @@ void Triangle::updateAbsoluteBox_() {
 	if (y2 > maxY) maxY = y2;
 	if (y3 > maxY) maxY = y3;
 
-	// Set the absolute bounding box using the calculated min and max values
-	setAbsoluteBoundingBox(minX, maxX, minY, maxY);
+	return BoundingBox(minX, maxX, minY, maxY);
 }
 #if 0
 //--------------------------------------
@@ -29,16 +29,16 @@ namespace earshooter
 		static float xy_[3][2];
 
 		/** Counter for the number of Triangle objects created */
-		static unsigned int count_;
+		static std::atomic<unsigned int> count_;
 
 		/** Counter for the number of Triangle objects still "alive" */
-		static unsigned int liveCount_;
+		static std::atomic<unsigned int> liveCount_;
 
 		/** Private rendering function for the Triangle class.
 		 * Translation and rotation have already been applied by the root class,
 		 * so this function only applies scaling before rendering.
 		 */
-		void draw_() const override;
+		void draw_(Renderer2D& renderer, const Transform2D& transform) const override;
 
 		/** Updates the relative bounding box of the triangle */
 		void updateRelativeBox_();
@@ -124,6 +124,16 @@ namespace earshooter
 		 */
 		inline float getRadius() const { return radius_; }
 
+		/** Computes the absolute bounding box of a triangle in a given pose
+		 * (the one updateAbsoluteBox_ sets, also used by WorldBatch).
+		 * @param cx X-coordinate of the triangle's origin
+		 * @param cy Y-coordinate of the triangle's origin
+		 * @param angle Orientation of the triangle (in degrees)
+		 * @param radius Radius of the triangle
+		 * @return The box of the triangle's vertices
+		 */
+		static BoundingBox computeAbsoluteBox(float cx, float cy, float angle, float radius);
+
 		/** Updates the state of the Triangle object.
 		 * This function shows that a subclass may have more to update than just the position and orientation.
 		 * @param dt Time (in seconds) elapsed since the last call of this function
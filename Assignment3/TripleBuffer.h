@@ -0,0 +1,102 @@
+//
+//  TripleBuffer.h
+//  Week 08 - Earshooter
+//
+//	Hands values over from one producer thread to one consumer thread
+//	without either of them ever waiting for the other.  Of the three slots,
+//	the producer owns one (the back slot, which it fills), the consumer owns
+//	another one (the front slot, which it reads), and the third one sits in
+//	between.  Publishing swaps the back slot with the one in between, and
+//	acquiring swaps the front slot with it, each with a single atomic
+//	exchange.  A flag stored with the index of the slot in between tells
+//	whether it holds a value not acquired yet.  If the producer publishes
+//	faster than the consumer acquires, the older values are simply
+//	overwritten: the consumer always gets the latest one.
+
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+namespace earshooter
+{
+	template <typename T>
+	class TripleBuffer
+	{
+		private:
+
+			static const unsigned int INDEX_MASK = 0x3;
+			static const unsigned int FRESH = 0x4;
+
+			T slot_[3];
+
+			/**	index of the slot in between, and FRESH if it was published
+			 *	but not acquired yet
+			 */
+			std::atomic<unsigned int> middle_;
+
+			unsigned int back_;		//	owned by the producer
+			unsigned int front_;	//	owned by the consumer
+
+		public:
+
+			TripleBuffer()
+				:	middle_(1),
+					back_(0),
+					front_(2)
+			{
+			}
+
+			/**	Returns the slot that the producer fills
+			 */
+			inline T& getBack()
+			{
+				return slot_[back_];
+			}
+
+			/**	Makes the back slot available to the consumer, and gives the
+			 *	producer a new back slot (which holds an older value)
+			 */
+			inline void publish()
+			{
+				back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+			}
+
+			/**	Reports whether a value was published since the last acquire
+			 */
+			inline bool hasFresh() const
+			{
+				return (middle_.load(std::memory_order_acquire) & FRESH) != 0;
+			}
+
+			/**	Makes the latest value published the front slot
+			 *	@RETURN	true if there was a value not acquired yet (otherwise,
+			 *			the front slot is left unchanged)
+			 */
+			inline bool acquire()
+			{
+				if (!hasFresh())
+					return false;
+				front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+				return true;
+			}
+
+			/**	Returns the slot that the consumer reads
+			 */
+			inline const T& getFront() const
+			{
+				return slot_[front_];
+			}
+
+			inline T& getFront()
+			{
+				return slot_[front_];
+			}
+
+			//	Disabled constructors & operators
+			TripleBuffer(const TripleBuffer&) = delete;
+			TripleBuffer& operator = (const TripleBuffer&) = delete;
+	};
+}
+
+#endif	//	TRIPLE_BUFFER_H
@@ -0,0 +1,99 @@
+//
+//  WorkerPool.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include "WorkerPool.h"
+
+using namespace std;
+using namespace earshooter;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+WorkerPool::WorkerPool(unsigned int nbThreads)
+	:	job_(nullptr),
+		nbJobWorkers_(0),
+		nbBusyHelpers_(0),
+		jobCount_(0),
+		isStopping_(false)
+{
+	if (nbThreads == 0)
+		nbThreads = max(1u, thread::hardware_concurrency());
+	helper_.reserve(nbThreads - 1);
+	for (unsigned int k = 1; k < nbThreads; k++)
+		helper_.emplace_back(&WorkerPool::helperLoop_, this, k);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		isStopping_ = true;
+	}
+	jobIsReady_.notify_all();
+	for (thread& t : helper_)
+		t.join();
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Running jobs
+//--------------------------------------
+#endif
+
+void WorkerPool::run(unsigned int nbWorkers, const function<void(unsigned int)>& job)
+{
+	nbWorkers = min(max(nbWorkers, 1u), getThreadCount());
+	if (nbWorkers == 1)
+	{
+		job(0);
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock(mutex_);
+		job_ = &job;
+		nbJobWorkers_ = nbWorkers;
+		nbBusyHelpers_ = nbWorkers - 1;
+		jobCount_++;
+	}
+	jobIsReady_.notify_all();
+
+	job(0);
+
+	unique_lock<mutex> lock(mutex_);
+	jobIsDone_.wait(lock, [this]() {return nbBusyHelpers_ == 0;});
+	job_ = nullptr;
+}
+
+//	A helper left out of a job (its index is too large) skips it.  The job
+//	can't change before the helpers taking part are done with it, so a
+//	helper that wakes up late still finds its job.
+void WorkerPool::helperLoop_(unsigned int index)
+{
+	uint64_t lastJob = 0;
+	unique_lock<mutex> lock(mutex_);
+	while (true)
+	{
+		jobIsReady_.wait(lock, [this, lastJob]() {return isStopping_ || jobCount_ != lastJob;});
+		if (isStopping_)
+			return;
+		lastJob = jobCount_;
+		if (index >= nbJobWorkers_)
+			continue;
+
+		const function<void(unsigned int)>& job = *job_;
+		lock.unlock();
+		job(index);
+		lock.lock();
+		if (--nbBusyHelpers_ == 0)
+			jobIsDone_.notify_one();
+	}
+}
@@ -0,0 +1,80 @@
+//
+//  WorkerPool.h
+//  Week 08 - Earshooter
+//
+//	A fixed set of worker threads, started once and kept waiting between
+//	jobs, for the work that is split across threads every frame (rasterizing
+//	the tiles, recording the objects): waking a thread that is already
+//	there costs far less than creating and joining one each time.
+//	A job is a function of the index of the worker running it.  The calling
+//	thread is worker 0, and run returns once all the workers taking part in
+//	the job are done with it.  Only one thread at a time may run jobs on a
+//	given pool.
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace earshooter
+{
+	class WorkerPool
+	{
+		private:
+
+			std::vector<std::thread> helper_;
+
+			std::mutex mutex_;
+			std::condition_variable jobIsReady_;
+			std::condition_variable jobIsDone_;
+
+			//	the current job (all guarded by mutex_)
+			const std::function<void(unsigned int)>* job_;
+			unsigned int nbJobWorkers_;
+			unsigned int nbBusyHelpers_;
+			uint64_t jobCount_;
+			bool isStopping_;
+
+			void helperLoop_(unsigned int index);
+
+		public:
+
+			/**	Creates a pool and starts its helper threads
+			 *	@PARAM nbThreads	number of workers, the calling thread
+			 *						included (0: one per hardware thread)
+			 */
+			explicit WorkerPool(unsigned int nbThreads = 0);
+
+			/**	Stops and joins the helper threads
+			 */
+			~WorkerPool();
+
+			/**	Runs a job on some of the workers, and returns when it is done
+			 *	@PARAM nbWorkers	number of workers wanted (at least 1, at
+			 *						most the size of the pool)
+			 *	@PARAM job			the job, called with the index of each
+			 *						worker, 0 being the calling thread
+			 */
+			void run(unsigned int nbWorkers, const std::function<void(unsigned int)>& job);
+
+			/**	Number of workers, the calling thread included
+			 */
+			inline unsigned int getThreadCount() const
+			{
+				return static_cast<unsigned int>(helper_.size()) + 1;
+			}
+
+			//	Disabled constructors & operators
+			WorkerPool(const WorkerPool&) = delete;
+			WorkerPool(WorkerPool&&) = delete;
+			WorkerPool& operator =(const WorkerPool&) = delete;
+			WorkerPool& operator =(WorkerPool&&) = delete;
+	};
+}
+
+#endif	//	WORKER_POOL_H
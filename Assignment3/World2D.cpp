@@ -1,34 +1,45 @@
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include "glPlatform.h"
 #include "World2D.h"
+#include "GraphicObject2D.h"
 
+using namespace std;
 using namespace earshooter;
 
-float World2D::X_MIN;
-float World2D::X_MAX;
-float World2D::Y_MIN;
-float World2D::Y_MAX;
-float World2D::WIDTH;
-float World2D::HEIGHT;
 float World2D::pixelToWorldRatio;
 float World2D::worldToPixelRatio;
 float World2D::drawInPixelScale;
+bool World2D::drawReferenceFrames = false;
 
-void World2D::setWorld2DBounds(float xmin, float xmax, float ymin, float ymax,
-						   int& paneWidth, int& paneHeight){
-	if ((xmax <= xmin) || (ymax <= xmin)){
+World2D::World2D(float xmin, float xmax, float ymin, float ymax, WorldType type)
+	:	xmin_(xmin),
+		xmax_(xmax),
+		ymin_(ymin),
+		ymax_(ymax),
+		width_(xmax - xmin),
+		height_(ymax - ymin),
+		originX_(0.0),
+		originY_(0.0),
+		absXmin_(xmin),
+		absYmin_(ymin),
+		type_(type),
+		sectorCols_(1),
+		sectorRows_(1),
+		sectorWidth_(xmax - xmin),
+		sectorHeight_(ymax - ymin),
+		sectors_(1)
+{
+	if ((xmax <= xmin) || (ymax <= ymin)){
 		exit(5);
 	}
-	X_MIN = xmin;
-	X_MAX = xmax;
-	Y_MIN = ymin;
-	Y_MAX = ymax;
-	WIDTH = xmax - xmin;
-	HEIGHT = ymax - ymin;
-	
-	float widthRatio = WIDTH / paneWidth;
-	float heightRatio = HEIGHT / paneHeight;
+}
+
+void World2D::setView(float viewWidth, float viewHeight, int& paneWidth, int& paneHeight){
+	float widthRatio = viewWidth / paneWidth;
+	float heightRatio = viewHeight / paneHeight;
 	float maxRatio = fmax(widthRatio,heightRatio);
 //	Removed because this doesn’t work happily with interactive window resizing,
 //	// If the two ratios differ by more than 5%,  then reject the dimensions
@@ -40,45 +51,126 @@ void World2D::setWorld2DBounds(float xmin, float xmax, float ymin, float ymax,
 	worldToPixelRatio = 1.f / pixelToWorldRatio;
 	drawInPixelScale = pixelToWorldRatio;
 	
-	paneWidth = static_cast<int>(round(WIDTH * worldToPixelRatio));
-	paneHeight = static_cast<int>(round(HEIGHT * worldToPixelRatio));
+	paneWidth = static_cast<int>(round(viewWidth * worldToPixelRatio));
+	paneHeight = static_cast<int>(round(viewHeight * worldToPixelRatio));
 }
 
-void earshooter::drawReferenceFrame(void)
+void World2D::addObject(shared_ptr<GraphicObject2D> obj)
 {
-	if (World2D::drawReferenceFrames)
-	{
-		glLineWidth(2.f);
-		glPushMatrix();
-		//	switch to pixels
-		glScalef(World2D::drawInPixelScale, World2D::drawInPixelScale, 1.f);
-		glBegin(GL_LINES);
-			//	X --> red.
-			glColor3f(1.0f, 0.f, 0.f);
-			glVertex2f(-10.f, 0.f);
-			glVertex2f(50.f, 0.f);
-			//	Y --> green
-			glColor3f(0.f, 1.0f, 0.f);
-			glVertex2f(0.f, -10.f);
-			glVertex2f(0.f, 50.f);
-		glEnd();
-		//	back to  World2D units
-		glPopMatrix();
-		glLineWidth(1.f);
-	}
+	obj->setWorld(this);
+	int sector = getSectorOf(obj->getX(), obj->getY());
+	objects_.push_back(move(obj));
+	sectors_[sector].push_back(prev(objects_.end()));
 }
-WorldPoint earshooter::pixelToWorld(float ix, float iy)
+
+void World2D::setType(WorldType type)
 {
-	return WorldPoint{	World2D::X_MIN + ix*World2D::pixelToWorldRatio,
-					World2D::Y_MAX - iy*World2D::pixelToWorldRatio
-				};
+	type_ = type;
+	for (auto& obj : objects_)
+		obj->scheduleEdgeCheck();
 }
 
-PixelPoint earshooter::worldToPixel(float wx, float wy)
+void World2D::shiftOrigin(float dx, float dy)
 {
-	return PixelPoint{(wx - World2D::X_MIN)*World2D::worldToPixelRatio,
-				 (World2D::Y_MAX - wy)*World2D::worldToPixelRatio};
+	originX_ += dx;
+	originY_ += dy;
+	xmin_ = static_cast<float>(absXmin_ - originX_);
+	xmax_ = static_cast<float>(absXmin_ + width_ - originX_);
+	ymin_ = static_cast<float>(absYmin_ - originY_);
+	ymax_ = static_cast<float>(absYmin_ + height_ - originY_);
 
+	for (auto& obj : objects_)
+		obj->translate(-dx, -dy);
 }
 
+void World2D::setSectorSize(float size)
+{
+	sectorCols_ = max(1, static_cast<int>(floorf(width_ / size)));
+	sectorRows_ = max(1, static_cast<int>(floorf(height_ / size)));
+	sectorWidth_ = width_ / sectorCols_;
+	sectorHeight_ = height_ / sectorRows_;
 
+	sectors_.assign(sectorCols_ * sectorRows_, vector<ObjectList::iterator>());
+	for (auto iter = objects_.begin(); iter != objects_.end(); ++iter)
+		sectors_[getSectorOf((*iter)->getX(), (*iter)->getY())].push_back(iter);
+}
+
+int World2D::getSectorOf(float x, float y) const
+{
+	int col = static_cast<int>(floorf((x - xmin_) / sectorWidth_));
+	int row = static_cast<int>(floorf((y - ymin_) / sectorHeight_));
+	col = min(max(col, 0), sectorCols_ - 1);
+	row = min(max(row, 0), sectorRows_ - 1);
+	return row * sectorCols_ + col;
+}
+
+int World2D::getSectorDistance(int sector1, int sector2) const
+{
+	int dCol = abs(sector1 % sectorCols_ - sector2 % sectorCols_);
+	int dRow = abs(sector1 / sectorCols_ - sector2 / sectorCols_);
+	if (type_ == WorldType::CYLINDER_WORLD || type_ == WorldType::SPHERE_WORLD)
+		dCol = min(dCol, sectorCols_ - dCol);
+	if (type_ == WorldType::SPHERE_WORLD)
+		dRow = min(dRow, sectorRows_ - dRow);
+	return max(dCol, dRow);
+}
+
+void World2D::refreshSectors(const vector<int>& sectors)
+{
+	for (int sector : sectors)
+	{
+		//	compacted in place, in the same order
+		vector<ObjectList::iterator>& sectorObjects = sectors_[sector];
+		size_t nbKept = 0;
+		for (ObjectList::iterator iter : sectorObjects)
+		{
+			if (*iter == nullptr)
+				objects_.erase(iter);
+			else if (sectorCols_ * sectorRows_ > 1 &&
+					 getSectorOf((*iter)->getX(), (*iter)->getY()) != sector)
+				moved_.push_back(iter);
+			else
+				sectorObjects[nbKept++] = iter;
+		}
+		sectorObjects.resize(nbKept);
+	}
+
+	//	only now, so that no object gets updated twice in a step
+	for (ObjectList::iterator iter : moved_)
+		sectors_[getSectorOf((*iter)->getX(), (*iter)->getY())].push_back(iter);
+	moved_.clear();
+}
+
+void World2D::sectorRange_(int center, int radius, int count, bool wraps, int& first, int& last)
+{
+	if (wraps && 2 * radius + 1 >= count)
+	{
+		first = 0;
+		last = count - 1;
+	}
+	else if (wraps)
+	{
+		first = center - radius;
+		last = center + radius;
+	}
+	else
+	{
+		first = max(0, center - radius);
+		last = min(count - 1, center + radius);
+	}
+}
+
+void earshooter::drawReferenceFrame(Renderer2D& renderer, const Transform2D& transform)
+{
+	if (World2D::drawReferenceFrames)
+	{
+		//	the axes are defined in pixels
+		static const float xAxis[2][2] = {{-10.f, 0.f}, {50.f, 0.f}};
+		static const float yAxis[2][2] = {{0.f, -10.f}, {0.f, 50.f}};
+		Transform2D inPixels = transform.scaled(World2D::drawInPixelScale, World2D::drawInPixelScale);
+		//	X --> red.
+		renderer.addLineStrip(RenderBatch::DEBUG, inPixels, xAxis, 2, 1.f, 0.f, 0.f);
+		//	Y --> green
+		renderer.addLineStrip(RenderBatch::DEBUG, inPixels, yAxis, 2, 0.f, 1.f, 0.f);
+	}
+}
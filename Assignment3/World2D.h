@@ -2,8 +2,11 @@
 #define WORLD_H
 
 #include <cmath>
-
-#define SINGLETON_VERSION	1
+#include <list>
+#include <memory>
+#include <vector>
+#include "Renderer2D.h"
+#include "MemoryTracker.h"
 
 namespace earshooter
 {
@@ -53,115 +56,306 @@ namespace earshooter
 	};
 
 
-	/** Essentially a set of application-wide global variables defining the
-	 * dimensions of the "World2D" and the conversion factors from pixel to World2D
-	 * units and back, as well as a few rendering constants.
-	 *	A cleaner version would replace all these public static variables by
-	 *	private instance variables accessed by setters & getters, so that
-	 *	we cann have multipe windows, each running a different World2D
+	class GraphicObject2D;
+
+	/**	The list of all the objects of a world.  Its nodes are charged to
+	 *	the LIST_NODE memory category.
 	 */
-	struct World2D
+	using ObjectList = std::list<std::shared_ptr<GraphicObject2D>,
+								 TrackedAllocator<std::shared_ptr<GraphicObject2D>,
+												  MemoryCategory::LIST_NODE>>;
+
+	/**	A world: its dimensions, its type (what happens to objects at its
+	 *	edges), and the list of the objects that live in it.  Each object
+	 *	refers to the world it was added to, for its bounds and its
+	 *	collisions, so that independent worlds can be simulated side by
+	 *	side (each one by a single thread at a time).
+	 *	A world can be partitioned into sectors, a grid of rectangles each of
+	 *	which lists the objects whose center lies in it, so that the objects
+	 *	near a point can be found without going through the whole list, and
+	 *	so that a large world can be stepped one sector at a time.
+	 *	The coordinates of the objects (and the bounds returned by getXmin,
+	 *	etc.) are floats relative to an origin that the simulation moves
+	 *	around (see shiftOrigin), so that they stay small, and precise, where
+	 *	the action is, however large the world.
+	 *	The conversion factors from pixel to world units and back, and a
+	 *	few rendering settings, belong to the display rather than to a world:
+	 *	they are still application-wide static variables, set from the size
+	 *	of the view by a call to setView.
+	 */
+	class World2D
 	{
-		friend bool createUniqueWorld();
+		private:
 		
+			float xmin_, xmax_, ymin_, ymax_;
+			float width_, height_;
+			//	where the origin of the coordinates is, and the lower-left
+			//	corner of the world, in absolute coordinates
+			double originX_, originY_;
+			double absXmin_, absYmin_;
+			WorldType type_;
+			ObjectList objects_;
+
+			//	Sectors, row by row, as positions in objects_.  Until
+			//	setSectorSize is called, one sector covers the whole world.
+			int sectorCols_, sectorRows_;
+			float sectorWidth_, sectorHeight_;
+			std::vector<std::vector<ObjectList::iterator>> sectors_;
+			//	objects that left a sector, while the sectors are refreshed
+			std::vector<ObjectList::iterator> moved_;
+
+			/**	Range of the columns (or rows) within some distance of a
+			 *	column, each one only once
+			 *	@PARAM center	index of the column
+			 *	@PARAM radius	distance, in columns
+			 *	@PARAM count	number of columns of the grid
+			 *	@PARAM wraps	true if the grid wraps around in that direction
+			 *	@PARAM first, last	receive the range (to be taken modulo count
+			 *						if the grid wraps around)
+			 */
+			static void sectorRange_(int center, int radius, int count, bool wraps,
+									 int& first, int& last);
+
+		public:
 		
-		/**	Minimum x value to get mapped to the display area.
-		 *	Set in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float X_MIN;
+			/**	Scaling factor converting pixel units to World2D units.
+			 *	Calculated in the main program by a call to setView.
+			 *	@see setView
+			 */
+			static float pixelToWorldRatio;
 
-		/**	Maximum x value to get mapped to the display area.
-		 *	Set in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float X_MAX;
+			/**	Scaling factor converting World2D units to pixel units.
+			 *	Calculated in the main program by a call to setView.
+			 *	@see setView
+			 */
+			static float worldToPixelRatio;
+			
+			/**	This one is really equal to pixelToWorldRatio, but it looks confusing
+			 *	to write glScalef(pixelToWorldRatio, pixelToWorldRatio, 1.f);
+			 *	right before trying to drawe in pixel units.
+			 *	@see setView
+			 */
+			static float drawInPixelScale;
+			
+			static bool drawReferenceFrames;
+			
+			/**	Creates an empty world
+			 * @param xmin	Minimum x value of the world
+			 * @param xmax	Maximum x value of the world
+			 * @param ymin	Minimum y value of the world
+			 * @param ymax	Maximum y value of the world
+			 * @param type	behavior of the objects at the edges of the world
+			 */
+			World2D(float xmin, float xmax, float ymin, float ymax, WorldType type);
+			
+			~World2D() = default;
 
-		/**	Minimum y value to get mapped to the display area.
-		 *	Set in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float Y_MIN;
+			/** Function called when the view is set up.  Although the user
+			 *	specifies dimensions for the rendering pane, the function
+			 *	may set different values that agree better with the aspect
+			 *	ratio of the view.
+			 * @param viewWidth		width of the part of the world in view
+			 * @param viewHeight	height of the part of the world in view
+			 * @param paneWidth		user-set width of the redering pane
+			 * @param paneHeight	user-set height of the redering pane
+			 * */
+			static void setView(float viewWidth, float viewHeight, int& paneWidth, int& paneHeight);
 
-		/**	Maximum x value to get mapped to the display area.
-		 *	Set in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float Y_MAX;
+			inline float getXmin() const
+			{
+				return xmin_;
+			}
+			inline float getXmax() const
+			{
+				return xmax_;
+			}
+			inline float getYmin() const
+			{
+				return ymin_;
+			}
+			inline float getYmax() const
+			{
+				return ymax_;
+			}
+			inline float getWidth() const
+			{
+				return width_;
+			}
+			inline float getHeight() const
+			{
+				return height_;
+			}
+			inline double getOriginX() const
+			{
+				return originX_;
+			}
+			inline double getOriginY() const
+			{
+				return originY_;
+			}
+			inline WorldType getType() const
+			{
+				return type_;
+			}
+			/**	Changes the behavior of the objects at the edges (they check
+			 *	the edges again at their next update)
+			 */
+			void setType(WorldType type);
 
-		/**	Calculated as X_MAX-X_MIN in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float WIDTH;
+			/**	Returns the list of the objects of the world (objects only
+			 *	get in and out of it through addObject and refreshSectors)
+			 */
+			inline const ObjectList& getObjects() const
+			{
+				return objects_;
+			}
 
-		/**	Calculated as Y_MAX-Y_MIN in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float HEIGHT;
+			/**	Adds an object at the end of the list of the world and to the
+			 *	sector of its center, and makes it refer to the world
+			 *	@PARAM obj	the object to add (must not be in another world)
+			 */
+			void addObject(std::shared_ptr<GraphicObject2D> obj);
 
-		/**	Scaling factor converting pixel units to World2D units.
-		 *	Calculated in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float pixelToWorldRatio;
+			/**	Moves the origin of the coordinates, and changes the coordinates
+			 *	of all the objects (and of the bounds of the world) to match.
+			 *	The objects don't move, only their coordinates change.
+			 *	@PARAM dx, dy	displacement of the origin (in the current coordinates)
+			 */
+			void shiftOrigin(float dx, float dy);
 
-		/**	Scaling factor converting World2D units to pixel units.
-		 *	Calculated in the main program by a call to setWorld2DBounds.
-		 *	@see setWorld2DBounds
-		 */
-		static float worldToPixelRatio;
-		
-		/**	This one is really equal to pixelToWorldRatio, but it looks confusing
-		 *	to write glScalef(pixelToWorldRatio, pixelToWorldRatio, 1.f);
-		 *	right before trying to drawe in pixel units.
-		 *	@see setWorld2DBounds
-		 */
-		static float drawInPixelScale;
-		
-		static WorldType worldType;
+			/**	Partitions the world into sectors, as many whole ones as fit
+			 *	along each dimension (at least one)
+			 *	@PARAM size	smallest width and height of a sector
+			 */
+			void setSectorSize(float size);
 
-		static bool drawReferenceFrames;
-		
-		/** Function called through the initialization of a global variable in the
-		 *	main program.  Although the user specifies dimensions for the rendering pane,
-		 *	the function may set different values that agree better with the World2D
-		 *	aspect ratio.
-		 * @param xmin	Minimum x value to get mapped to the display area.
-		 * @param xmax	Maximum x value to get mapped to the display area.
-		 * @param ymin	Minimum y value to get mapped to the display area.
-		 * @param ymax	Maximum y value to get mapped to the display area.
-		 * @param paneWidth		user-set width of the redering pane
-		 * @param paneHeight	user-set height of the redering pane
-		 * */
-		static void setWorld2DBounds(float xmin, float xmax, float ymin, float ymax,
-									int& paneWidth, int& paneHeight);
-
-
-		/**	Returns the conversion factor from pixel to world units
-		 */
-		inline static float getPixelToWorldScale()
-		{
-			return pixelToWorldRatio;
-		}
+			inline int getSectorCols() const
+			{
+				return sectorCols_;
+			}
+			inline int getSectorRows() const
+			{
+				return sectorRows_;
+			}
+			inline int getSectorCount() const
+			{
+				return sectorCols_ * sectorRows_;
+			}
+			inline float getSectorWidth() const
+			{
+				return sectorWidth_;
+			}
+			inline float getSectorHeight() const
+			{
+				return sectorHeight_;
+			}
 
-		/**	Returns the conversion factor from world to pixel units
-		 */
-		inline static float getWorldToPixelScale()
-		{
-			return worldToPixelRatio;
-		}
-		
-		private:
-			World2D() = delete;
-			~World2D() = default;
+			/**	Returns the index of the sector that contains a point (the
+			 *	nearest one for a point outside of the world)
+			 */
+			int getSectorOf(float x, float y) const;
 
-	};
+			/**	Returns the distance between two sectors, in sectors (the
+			 *	larger of the column and row distances, across the edges that
+			 *	the world type wraps around)
+			 */
+			int getSectorDistance(int sector1, int sector2) const;
+
+			/**	Returns the positions in the object list of the objects of a
+			 *	sector
+			 */
+			inline const std::vector<ObjectList::iterator>& getSectorObjects(int sector) const
+			{
+				return sectors_[sector];
+			}
+
+			/**	Brings sectors up to date after their objects were updated:
+			 *	removes from the world the objects that were let go of (their
+			 *	pointer in the list was reset when they died), and moves the
+			 *	objects whose center left their sector to their new one
+			 *	@PARAM sectors	indices of the sectors whose objects were updated
+			 */
+			void refreshSectors(const std::vector<int>& sectors);
+
+			/**	Calls a function on each sector within some distance of a
+			 *	sector (itself included), once each
+			 *	@PARAM sector	index of the sector
+			 *	@PARAM radius	distance, in sectors
+			 *	@PARAM visit	called with the index of each sector
+			 */
+			template <typename Visitor>
+			void forEachSectorAround(int sector, int radius, Visitor visit) const
+			{
+				bool wrapsX = type_ == WorldType::CYLINDER_WORLD || type_ == WorldType::SPHERE_WORLD;
+				bool wrapsY = type_ == WorldType::SPHERE_WORLD;
+				int colFirst, colLast, rowFirst, rowLast;
+				sectorRange_(sector % sectorCols_, radius, sectorCols_, wrapsX, colFirst, colLast);
+				sectorRange_(sector / sectorCols_, radius, sectorRows_, wrapsY, rowFirst, rowLast);
+				for (int row = rowFirst; row <= rowLast; row++)
+				{
+					int wrappedRow = (row + sectorRows_) % sectorRows_;
+					for (int col = colFirst; col <= colLast; col++)
+						visit(wrappedRow * sectorCols_ + (col + sectorCols_) % sectorCols_);
+				}
+			}
+
+			/**	Calls a function on each object of the sector that contains a
+			 *	point and of the sectors around it, until it returns false.
+			 *	A sector is at least as large as the objects, so these are all
+			 *	the objects that something at that point may touch.
+			 *	@PARAM x, y		the point
+			 *	@PARAM visit	called with each object, returns false to stop
+			 *	@RETURN	the number of objects visited
+			 */
+			template <typename Visitor>
+			unsigned int forEachObjectNear(float x, float y, Visitor visit) const
+			{
+				unsigned int nbVisited = 0;
+				bool searching = true;
+				forEachSectorAround(getSectorOf(x, y), 1, [this, &visit, &nbVisited, &searching](int sector)
+				{
+					for (auto iter = sectors_[sector].begin();
+						 searching && iter != sectors_[sector].end(); ++iter)
+					{
+						//	(an object that died during this step is already gone)
+						if (**iter != nullptr)
+						{
+							nbVisited++;
+							searching = visit(***iter);
+						}
+					}
+				});
+				return nbVisited;
+			}
 
-	void drawReferenceFrame(void);
+			/**	Returns the conversion factor from pixel to world units
+			 */
+			inline static float getPixelToWorldScale()
+			{
+				return pixelToWorldRatio;
+			}
 
-	WorldPoint pixelToWorld(float ix, float iy);
-	PixelPoint worldToPixel(float wx, float wy);
+			/**	Returns the conversion factor from world to pixel units
+			 */
+			inline static float getWorldToPixelScale()
+			{
+				return worldToPixelRatio;
+			}
 
+			//	Disabled constructors & operators
+			World2D() = delete;
+			World2D(const World2D&) = delete;
+			World2D(World2D&&) = delete;
+			World2D& operator =(const World2D&) = delete;
+			World2D& operator =(World2D&&) = delete;
+	};
+
+	/**	Adds the axes of a reference frame (x in red, y in green, a few
+	 *	dozen pixels long) to the debug batch of a renderer, if reference
+	 *	frames are enabled
+	 *	@PARAM transform	frame to world transformation
+	 */
+	void drawReferenceFrame(Renderer2D& renderer, const Transform2D& transform);
 }
 
 #endif  //  WORLD_H
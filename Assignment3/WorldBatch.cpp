@@ -0,0 +1,420 @@
+//
+//  WorldBatch.cpp
+//  Week 08 - Earshooter
+//
+
+#include <algorithm>
+#include <cmath>
+#include "WorldBatch.h"
+#include "Simulation.h"
+#include "Triangle.h"
+#include "Rectangle2D.h"
+#include "Ellipse2D.h"
+#include "SmilingFace.h"
+#include "Profiler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SIMD_WORLDS
+	#include <emmintrin.h>
+#endif
+
+using namespace std;
+using namespace earshooter;
+
+//	The ship, as created by Simulation: at the center, of radius 0.5, and
+//	with the box, health, and damage per collision of SpaceShip
+const float SHIP_X = 0.f, SHIP_Y = 0.f;
+const float SHIP_RADIUS = 0.5f;
+const float SHIP_HALF_WIDTH = SHIP_RADIUS * 1.2f;
+const float SHIP_HALF_HEIGHT = SHIP_RADIUS * 1.5f;
+const int32_t SHIP_HEALTH = 100;
+const int32_t SHIP_DAMAGE = 25;
+
+//	Radius of the bounding circle of each shape of asteroid, for a size of 1:
+//	triangle (vertices at the size), square (half diagonal), ellipse (circle
+//	of radius the size), face (the ears stick out)
+const float SHAPE_RADIUS[4] = {1.f, 0.7072f, 1.f, 1.59f};
+//	The circles are enlarged a little, so that the rounding of the boxes
+//	computed from the vertices can't get them out
+const float REACH_MARGIN = 1.01f;
+
+//	Same as in GraphicObject2D.cpp
+const float EDGE_TIME_SAFETY = 0.95f;
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Constructors
+//--------------------------------------
+#endif
+
+WorldBatch::WorldBatch(int nbWorlds, float xmin, float xmax, float ymin, float ymax,
+					   WorldType type, unsigned int seed, int nbAsteroids)
+	:	world_(xmin, xmax, ymin, ymax, type),
+		nbWorlds_(nbWorlds),
+		nbSlots_(0),
+		stride_((nbWorlds + LANE_WIDTH - 1) / LANE_WIDTH * LANE_WIDTH),
+		shipBox_(SHIP_X - SHIP_HALF_WIDTH, SHIP_X + SHIP_HALF_WIDTH,
+				 SHIP_Y - SHIP_HALF_HEIGHT, SHIP_Y + SHIP_HALF_HEIGHT),
+		timeSinceLastAsteroid_(0.f),
+		stepCount_(0)
+{
+	//	the padding lanes have no ship, so nothing ever happens in them
+	health_.assign(stride_, 0);
+	shipAlive_.assign(stride_, 0);
+	shipInWorld_.assign(stride_, 0);
+	shipHit_.assign(stride_, 0);
+	asteroidCount_.assign(nbWorlds_, 0);
+	engine_.reserve(nbWorlds_);
+	for (int w = 0; w < nbWorlds_; w++)
+	{
+		health_[w] = SHIP_HEALTH;
+		shipAlive_[w] = shipInWorld_[w] = -1;
+		engine_.emplace_back(seed + w);
+		for (int k = 0; k < nbAsteroids; k++)
+			spawnAsteroid_(w);
+	}
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Simulation
+//--------------------------------------
+#endif
+
+void WorldBatch::step(float dt)
+{
+	{
+		ProfileScope updateScope(ProfileZone::UPDATE, static_cast<uint64_t>(nbSlots_) * nbWorlds_);
+		fill(shipHit_.begin(), shipHit_.end(), 0);
+		for (int slot = 0; slot < nbSlots_; slot++)
+			for (int first = 0; first < stride_; first += LANE_WIDTH)
+				stepLanes_(slot, first, dt);
+
+		//	At most one collision per ship and per step, as in SpaceShip::update.
+		//	A ship that was already dead took part in this step, its last one.
+		for (int w = 0; w < nbWorlds_; w++)
+		{
+			if (shipInWorld_[w] == 0)
+				continue;
+			bool wasAlive = shipAlive_[w] != 0;
+			if (shipHit_[w] != 0)
+			{
+				health_[w] -= SHIP_DAMAGE;
+				if (health_[w] <= 0)
+					shipAlive_[w] = 0;
+			}
+			if (!wasAlive)
+				shipInWorld_[w] = 0;
+		}
+	}
+
+	// Periodically generate new asteroids
+	timeSinceLastAsteroid_ += dt;
+	if (timeSinceLastAsteroid_ >= Simulation::ASTEROID_SPAWN_INTERVAL)
+	{
+		ProfileScope spawnScope(ProfileZone::SPAWN, nbWorlds_);
+		for (int w = 0; w < nbWorlds_; w++)
+			if (shipAlive_[w] != 0)
+				spawnAsteroid_(w);
+		timeSinceLastAsteroid_ = 0.f;
+	}
+
+	stepCount_++;
+}
+
+void WorldBatch::stepLanes_(int slot, int first, float dt)
+{
+	const size_t i = static_cast<size_t>(slot) * stride_ + first;
+
+#ifdef SIMD_WORLDS
+	__m128i alive = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alive_.data() + i));
+	//	four free slots: nothing to do
+	if (_mm_movemask_epi8(alive) == 0)
+		return;
+
+	const __m128 signBit = _mm_set1_ps(-0.f);
+	__m128 x = _mm_loadu_ps(x_.data() + i);
+	__m128 y = _mm_loadu_ps(y_.data() + i);
+
+	//	Test against the ship of each world, before moving (the ship is
+	//	updated first in a Simulation), unless the ship was already hit.  The
+	//	boxes are computed only for the asteroids whose circle is near.
+	const __m128i hit = _mm_loadu_si128(reinterpret_cast<const __m128i*>(shipHit_.data() + first));
+	__m128i canHit = _mm_andnot_si128(hit, _mm_and_si128(alive, _mm_loadu_si128(
+						reinterpret_cast<const __m128i*>(shipInWorld_.data() + first))));
+	__m128 reach = _mm_loadu_ps(reach_.data() + i);
+	__m128 dx = _mm_andnot_ps(signBit, _mm_sub_ps(x, _mm_set1_ps(SHIP_X)));
+	__m128 dy = _mm_andnot_ps(signBit, _mm_sub_ps(y, _mm_set1_ps(SHIP_Y)));
+	__m128 near = _mm_and_ps(_mm_cmple_ps(dx, _mm_add_ps(reach, _mm_set1_ps(SHIP_HALF_WIDTH))),
+							 _mm_cmple_ps(dy, _mm_add_ps(reach, _mm_set1_ps(SHIP_HALF_HEIGHT))));
+	int candidates = _mm_movemask_ps(_mm_and_ps(_mm_castsi128_ps(canHit), near));
+	if (candidates != 0)
+	{
+		for (int lane = 0; lane < LANE_WIDTH; lane++)
+			if ((candidates & (1 << lane)) != 0 && hitsShip_(i + lane))
+			{
+				shipHit_[first + lane] = -1;
+				alive_[i + lane] = 0;
+			}
+		alive = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alive_.data() + i));
+	}
+
+	const __m128 step = _mm_set1_ps(dt);
+	__m128 vx = _mm_loadu_ps(vx_.data() + i);
+	__m128 vy = _mm_loadu_ps(vy_.data() + i);
+	x = _mm_add_ps(x, _mm_mul_ps(vx, step));
+	y = _mm_add_ps(y, _mm_mul_ps(vy, step));
+	_mm_storeu_ps(angle_.data() + i, _mm_add_ps(_mm_loadu_ps(angle_.data() + i),
+												_mm_mul_ps(_mm_loadu_ps(spin_.data() + i), step)));
+
+	//	No edge within reach of any of the lanes yet: no edges to deal with
+	const __m128 zero = _mm_setzero_ps();
+	__m128 timeToEdge = _mm_sub_ps(_mm_loadu_ps(timeToEdge_.data() + i), step);
+	const __m128 due = _mm_cmpngt_ps(timeToEdge, zero);
+	if (_mm_movemask_ps(due) != 0)
+	{
+		//	Same tests, in the same order, as GraphicObject2D::update: each one
+		//	applies to the lanes whose mask is set (and whose edges are due)
+		const float width = world_.getWidth(), height = world_.getHeight();
+		__m128 xMin = _mm_set1_ps(world_.getXmin()), xMax = _mm_set1_ps(world_.getXmax());
+		__m128 yMin = _mm_set1_ps(world_.getYmin()), yMax = _mm_set1_ps(world_.getYmax());
+		const __m128 w = _mm_set1_ps(width), h = _mm_set1_ps(height);
+		__m128 mask;
+		switch (world_.getType())
+		{
+			case WorldType::WINDOW_WORLD:
+			{
+				//	the padded bounds serve for the prediction as well
+				const __m128 halfW = _mm_set1_ps(0.5f * width), halfH = _mm_set1_ps(0.5f * height);
+				xMin = _mm_sub_ps(xMin, halfW);
+				xMax = _mm_add_ps(xMax, halfW);
+				yMin = _mm_sub_ps(yMin, halfH);
+				yMax = _mm_add_ps(yMax, halfH);
+				__m128 out = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(x, xMax), _mm_cmplt_ps(x, xMin)),
+									   _mm_or_ps(_mm_cmpgt_ps(y, yMax), _mm_cmplt_ps(y, yMin)));
+				alive = _mm_andnot_si128(_mm_castps_si128(_mm_and_ps(due, out)), alive);
+				break;
+			}
+
+			case WorldType::BOX_WORLD:
+			case WorldType::CYLINDER_WORLD:
+				if (world_.getType() == WorldType::BOX_WORLD)
+				{
+					mask = _mm_and_ps(due, _mm_cmpge_ps(x, xMax));
+					x = _mm_or_ps(_mm_and_ps(mask, xMax), _mm_andnot_ps(mask, x));
+					vx = _mm_xor_ps(vx, _mm_and_ps(mask, signBit));
+					mask = _mm_and_ps(due, _mm_cmple_ps(x, xMin));
+					x = _mm_or_ps(_mm_and_ps(mask, xMin), _mm_andnot_ps(mask, x));
+					vx = _mm_xor_ps(vx, _mm_and_ps(mask, signBit));
+				}
+				else
+				{
+					mask = _mm_and_ps(due, _mm_cmpge_ps(x, xMax));
+					x = _mm_sub_ps(x, _mm_and_ps(mask, w));
+					mask = _mm_and_ps(due, _mm_cmple_ps(x, xMin));
+					x = _mm_add_ps(x, _mm_and_ps(mask, w));
+				}
+				mask = _mm_and_ps(due, _mm_cmpge_ps(y, yMax));
+				y = _mm_or_ps(_mm_and_ps(mask, yMax), _mm_andnot_ps(mask, y));
+				vy = _mm_xor_ps(vy, _mm_and_ps(mask, signBit));
+				mask = _mm_and_ps(due, _mm_cmple_ps(y, yMin));
+				y = _mm_or_ps(_mm_and_ps(mask, yMin), _mm_andnot_ps(mask, y));
+				vy = _mm_xor_ps(vy, _mm_and_ps(mask, signBit));
+				break;
+
+			case WorldType::SPHERE_WORLD:
+			{
+				__m128 right = _mm_and_ps(due, _mm_cmpge_ps(x, xMax));
+				__m128 left = _mm_and_ps(due, _mm_andnot_ps(right, _mm_cmple_ps(x, xMin)));
+				x = _mm_add_ps(x, _mm_sub_ps(_mm_and_ps(left, w), _mm_and_ps(right, w)));
+				__m128 top = _mm_and_ps(due, _mm_cmpge_ps(y, yMax));
+				__m128 bottom = _mm_and_ps(due, _mm_andnot_ps(top, _mm_cmple_ps(y, yMin)));
+				y = _mm_add_ps(y, _mm_sub_ps(_mm_and_ps(bottom, h), _mm_and_ps(top, h)));
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		//	Time to the nearest edge, as GraphicObject2D::predictTimeToEdge_
+		//	(the lanes with no velocity along an axis never get there)
+		const __m128 never = _mm_set1_ps(INFINITY);
+		__m128 positive = _mm_cmpgt_ps(vx, zero), negative = _mm_cmplt_ps(vx, zero);
+		__m128 t = _mm_or_ps(_mm_or_ps(_mm_and_ps(positive, _mm_div_ps(_mm_sub_ps(xMax, x), vx)),
+									   _mm_and_ps(negative, _mm_div_ps(_mm_sub_ps(xMin, x), vx))),
+							 _mm_andnot_ps(_mm_or_ps(positive, negative), never));
+		positive = _mm_cmpgt_ps(vy, zero);
+		negative = _mm_cmplt_ps(vy, zero);
+		t = _mm_min_ps(t, _mm_or_ps(_mm_or_ps(_mm_and_ps(positive, _mm_div_ps(_mm_sub_ps(yMax, y), vy)),
+											  _mm_and_ps(negative, _mm_div_ps(_mm_sub_ps(yMin, y), vy))),
+									_mm_andnot_ps(_mm_or_ps(positive, negative), never)));
+		t = _mm_mul_ps(_mm_set1_ps(EDGE_TIME_SAFETY), _mm_max_ps(t, zero));
+		timeToEdge = _mm_or_ps(_mm_and_ps(due, t), _mm_andnot_ps(due, timeToEdge));
+	}
+
+	_mm_storeu_ps(x_.data() + i, x);
+	_mm_storeu_ps(y_.data() + i, y);
+	_mm_storeu_ps(vx_.data() + i, vx);
+	_mm_storeu_ps(vy_.data() + i, vy);
+	_mm_storeu_ps(timeToEdge_.data() + i, timeToEdge);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(alive_.data() + i), alive);
+#else
+	for (size_t k = i; k < i + LANE_WIDTH; k++)
+	{
+		if (alive_[k] == 0)
+			continue;
+
+		int w = first + static_cast<int>(k - i);
+		if (shipInWorld_[w] != 0 && shipHit_[w] == 0 &&
+			fabsf(x_[k] - SHIP_X) <= reach_[k] + SHIP_HALF_WIDTH &&
+			fabsf(y_[k] - SHIP_Y) <= reach_[k] + SHIP_HALF_HEIGHT && hitsShip_(k))
+		{
+			shipHit_[w] = -1;
+			alive_[k] = 0;
+			continue;
+		}
+		moveAsteroid_(k, dt);
+	}
+#endif
+}
+
+bool WorldBatch::hitsShip_(size_t k) const
+{
+	const float x = x_[k], y = y_[k], angle = angle_[k], size = size_[k];
+	switch (shape_[k])
+	{
+		case 0:
+			return shipBox_.intersects(Triangle::computeAbsoluteBox(x, y, angle, size));
+
+		case 1:
+			return shipBox_.intersects(Rectangle2D::computeAbsoluteBox(x, y, angle, size, size));
+
+		case 2:
+			return shipBox_.intersects(Ellipse2D::computeAbsoluteBox(x, y, angle, size, size));
+
+		case 3:
+			return shipBox_.intersects(SmilingFace::computeAbsoluteBox(x, y, angle, size));
+
+		default:
+			return false;
+	}
+}
+
+void WorldBatch::moveAsteroid_(size_t k, float dt)
+{
+	x_[k] += vx_[k] * dt;
+	y_[k] += vy_[k] * dt;
+	angle_[k] += spin_[k] * dt;
+
+	timeToEdge_[k] -= dt;
+	if (timeToEdge_[k] > 0.f)
+		return;
+
+	float xmin = world_.getXmin(), xmax = world_.getXmax();
+	float ymin = world_.getYmin(), ymax = world_.getYmax();
+	const float width = world_.getWidth(), height = world_.getHeight();
+	switch (world_.getType())
+	{
+		case WorldType::WINDOW_WORLD:
+			xmin -= 0.5f * width;
+			xmax += 0.5f * width;
+			ymin -= 0.5f * height;
+			ymax += 0.5f * height;
+			if (x_[k] > xmax || x_[k] < xmin || y_[k] > ymax || y_[k] < ymin)
+				alive_[k] = 0;
+			break;
+
+		case WorldType::BOX_WORLD:
+		case WorldType::CYLINDER_WORLD:
+			if (world_.getType() == WorldType::BOX_WORLD)
+			{
+				if (x_[k] >= xmax) { x_[k] = xmax; vx_[k] = -vx_[k]; }
+				if (x_[k] <= xmin) { x_[k] = xmin; vx_[k] = -vx_[k]; }
+			}
+			else
+			{
+				if (x_[k] >= xmax) x_[k] -= width;
+				if (x_[k] <= xmin) x_[k] += width;
+			}
+			if (y_[k] >= ymax) { y_[k] = ymax; vy_[k] = -vy_[k]; }
+			if (y_[k] <= ymin) { y_[k] = ymin; vy_[k] = -vy_[k]; }
+			break;
+
+		case WorldType::SPHERE_WORLD:
+			if (x_[k] >= xmax)
+				x_[k] -= width;
+			else if (x_[k] <= xmin)
+				x_[k] += width;
+			if (y_[k] >= ymax)
+				y_[k] -= height;
+			else if (y_[k] <= ymin)
+				y_[k] += height;
+			break;
+
+		default:
+			break;
+	}
+
+	float t = INFINITY;
+	if (vx_[k] > 0.f)
+		t = (xmax - x_[k]) / vx_[k];
+	else if (vx_[k] < 0.f)
+		t = (xmin - x_[k]) / vx_[k];
+	if (vy_[k] > 0.f)
+		t = fminf(t, (ymax - y_[k]) / vy_[k]);
+	else if (vy_[k] < 0.f)
+		t = fminf(t, (ymin - y_[k]) / vy_[k]);
+	timeToEdge_[k] = EDGE_TIME_SAFETY * fmaxf(t, 0.f);
+}
+
+void WorldBatch::spawnAsteroid_(int world)
+{
+	AsteroidDraw a = drawRandomAsteroid(world_, world_.getWidth(), engine_[world]);
+
+	//	A world's asteroids are never moved to another slot, and the worlds
+	//	spawn together, so a new slot is rarely needed
+	if (static_cast<int>(asteroidCount_[world]) == nbSlots_)
+	{
+		nbSlots_++;
+		size_t nbValues = static_cast<size_t>(nbSlots_) * stride_;
+		for (vector<float>* values : {&x_, &y_, &angle_, &vx_, &vy_, &spin_,
+									  &timeToEdge_, &size_, &reach_})
+			values->resize(nbValues, 0.f);
+		shape_.resize(nbValues, 0);
+		alive_.resize(nbValues, 0);
+	}
+
+	size_t k = static_cast<size_t>(asteroidCount_[world]) * stride_ + world;
+	x_[k] = a.x;
+	y_[k] = a.y;
+	angle_[k] = a.angle;
+	vx_[k] = a.vx;
+	vy_[k] = a.vy;
+	spin_[k] = a.spin;
+	//	its edges are checked at its first step, as for an object added to a world
+	timeToEdge_[k] = 0.f;
+	size_[k] = a.size;
+	reach_[k] = REACH_MARGIN * a.size * SHAPE_RADIUS[a.shape];
+	shape_[k] = a.shape;
+	alive_[k] = -1;
+	asteroidCount_[world]++;
+}
+
+#if 0
+//--------------------------------------
+#pragma mark -
+#pragma mark Setters and getters
+//--------------------------------------
+#endif
+
+unsigned int WorldBatch::getLiveCount(int world) const
+{
+	unsigned int count = (shipInWorld_[world] != 0) ? 1 : 0;
+	for (int slot = 0; slot < nbSlots_; slot++)
+		if (alive_[static_cast<size_t>(slot) * stride_ + world] != 0)
+			count++;
+	return count;
+}
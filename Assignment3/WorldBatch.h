@@ -0,0 +1,162 @@
+//
+//  WorldBatch.h
+//  Week 08 - Earshooter
+//
+//	A batch of small worlds of the same dimensions and type, stored "slot
+//	by slot": the state of asteroid slot s of all the worlds of the batch
+//	is kept side by side in arrays, so that the motion and the edge behavior
+//	run over four worlds at a time in SSE2 lanes.  Each world evolves
+//	exactly like a Simulation (of one sector) with no input: the ship stays
+//	at the center and never fires, so there are no projectiles.  The same
+//	seed gives the same draws, and the same rules give the same results:
+//		- slot s of a world holds its s-th asteroid, so that the slots are
+//		  in the order of the world's list of objects (the ship takes the
+//		  first asteroid of that order that it hits),
+//		- the box of an asteroid is computed by its shape's own function,
+//		  only when its bounding circle comes near the ship,
+//		- the edges are checked when the predicted time to reach them runs
+//		  out, as in GraphicObject2D::update,
+//		- a ship that died still takes part in the next step, then leaves.
+//	The lanes do the same float operations as the scalar code, so they
+//	match it bit for bit as long as the compiler doesn't fuse multiplies
+//	and adds (--batch-check compares the two on a batch of seeds).  Other
+//	architectures get the scalar version of the same code.
+
+#ifndef WORLD_BATCH_H
+#define WORLD_BATCH_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "World2D.h"
+#include "BoundingBox.h"
+
+namespace earshooter
+{
+	class WorldBatch
+	{
+		private:
+
+			/**	Dimensions and type shared by all the worlds (its object list
+			 *	stays empty)
+			 */
+			World2D world_;
+			int nbWorlds_, nbSlots_;
+			//	number of worlds rounded up to a whole number of lanes
+			int stride_;
+
+			//	Asteroid slots, at [slot * stride_ + world].  A slot that is
+			//	not (or no longer) used is not alive: its mask is 0 instead of
+			//	all ones.  The reach is the radius of the asteroid's bounding
+			//	circle, a little enlarged.
+			std::vector<float> x_, y_, angle_;
+			std::vector<float> vx_, vy_, spin_;
+			std::vector<float> timeToEdge_;
+			std::vector<float> size_, reach_;
+			std::vector<int32_t> shape_;
+			std::vector<int32_t> alive_;
+
+			//	Per world: ship health, ship alive mask, ship still in the
+			//	world (alive, or dead since the last step) mask, ship hit during
+			//	the current step, random engine, and number of asteroids created
+			std::vector<int32_t> health_, shipAlive_, shipInWorld_, shipHit_;
+			std::vector<std::default_random_engine> engine_;
+			std::vector<unsigned int> asteroidCount_;
+
+			BoundingBox shipBox_;
+			float timeSinceLastAsteroid_;
+			uint64_t stepCount_;
+
+			/**	Puts a new asteroid in the next slot of a world, adding a slot
+			 *	to all the worlds if it has none left
+			 */
+			void spawnAsteroid_(int world);
+
+			/**	Moves the asteroids of a slot, for lanes [first, first+4[, after
+			 *	testing them against the ships
+			 */
+			void stepLanes_(int slot, int first, float dt);
+
+			/**	Tests the box of the asteroid of a slot against the ship, as
+			 *	SpaceShip::update does
+			 *	@PARAM k	index of the asteroid's slot in the arrays
+			 */
+			bool hitsShip_(size_t k) const;
+
+			/**	Moves an asteroid, and applies the edge behavior of the world
+			 *	when it is due, exactly as GraphicObject2D::update does
+			 *	@PARAM k	index of the asteroid's slot in the arrays
+			 */
+			void moveAsteroid_(size_t k, float dt);
+
+		public:
+
+			/**	Number of worlds processed together by the SIMD code
+			 */
+			static const int LANE_WIDTH = 4;
+
+			/**	Creates a batch of worlds, each one with its ship at the center
+			 *	and a few asteroids at random
+			 *	@PARAM nbWorlds		number of worlds of the batch
+			 *	@PARAM xmin, xmax, ymin, ymax	dimensions of the worlds
+			 *	@PARAM type			behavior of the objects at the edges of the worlds
+			 *	@PARAM seed			seed of the first world (then seed+1, seed+2, ...)
+			 *	@PARAM nbAsteroids	number of asteroids created with each world
+			 */
+			WorldBatch(int nbWorlds, float xmin, float xmax, float ymin, float ymax,
+					   WorldType type, unsigned int seed, int nbAsteroids);
+
+			~WorldBatch() = default;
+
+			/**	One fixed step of all the worlds: ship collisions, motion and
+			 *	edges of the asteroids, then an asteroid every second in each
+			 *	world whose ship is alive
+			 *	@PARAM dt	duration of the step (in s)
+			 */
+			void step(float dt);
+
+			inline int getWorldCount() const
+			{
+				return nbWorlds_;
+			}
+
+			inline int getSlotCount() const
+			{
+				return nbSlots_;
+			}
+
+			inline uint64_t getStepCount() const
+			{
+				return stepCount_;
+			}
+
+			inline bool isShipAlive(int world) const
+			{
+				return shipAlive_[world] != 0;
+			}
+
+			inline int getHealth(int world) const
+			{
+				return health_[world];
+			}
+
+			inline unsigned int getAsteroidCount(int world) const
+			{
+				return asteroidCount_[world];
+			}
+
+			/**	Returns the number of objects left in a world, ship included
+			 *	(as the size of the list of objects of a Simulation)
+			 */
+			unsigned int getLiveCount(int world) const;
+
+			//	Disabled constructors & operators
+			WorldBatch() = delete;
+			WorldBatch(const WorldBatch&) = delete;
+			WorldBatch(WorldBatch&&) = delete;
+			WorldBatch& operator =(const WorldBatch&) = delete;
+			WorldBatch& operator =(WorldBatch&&) = delete;
+	};
+}
+
+#endif	//	WORLD_BATCH_H
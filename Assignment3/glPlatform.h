@@ -22,6 +22,10 @@
     //  Visual
     #if defined(_MSC_VER)
 		#include <Windows.h>
+		//	opengl32 stops at OpenGL 1.1: GLEW (static library) loads the
+		//	buffer object functions.  glew.h must come before gl.h
+		#define GLEW_STATIC
+		#include <GL\glew.h>
         #include <GL\gl.h>
 		#include <GL\glut.h>
     //  gcc-based compiler
@@ -33,6 +37,8 @@
 
 //  Linux and Unix
 #elif  (defined(__FreeBSD__) || defined(linux) || defined(sgi) || defined(__NetBSD__) || defined(__OpenBSD) || defined(__QNX__))
+	//	libGL exports the functions beyond OpenGL 1.1 (buffer objects, etc.)
+	#define GL_GLEXT_PROTOTYPES
     #include <GL/gl.h>
     #include <GL/glut.h>
 
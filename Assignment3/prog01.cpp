@@ -24,8 +24,60 @@
 //			* 'r' toggles on/off relative box drawing.  If absolute box was on,
 //				then it's turned off when relative box drawing is activated
 //		- 'f' toggles on/off the drawing of reference frames.
+//		- 'g' toggles on/off the drawing of the cells of a broad-phase grid
+//			(cells holding parts of several objects are highlighted)
+//			All the boxes, frames, and cells are drawn as one batch of lines.
+//		- Profiling
+//			* 'h' toggles on/off the HUD lines of per-zone p50/p99 timings,
+//				of the frame scheduler (always shown when the simulation can't
+//				keep real time), of the objects drawn and culled, and of the
+//				GL state calls issued and elided
+//			* 'P' prints the p50/p99/max report of all zones, the memory
+//				used by each object type, and the GL state calls, to the terminal
+//			* 'M' toggles on/off the HUD line of memory used per object type
+//			* 'T' captures a Chrome trace of the frame phases for a few seconds
+//		- 'C' starts/stops the capture of the frames to disk
+//		- 'S' switches basic shapes between their signed distance function
+//			  (one quad each, the default when supported) and their tessellation
+//	Command line options (after the glut ones):
+//		--trace <seconds>		start a trace capture of that duration at launch
+//		--trace-file <path>		file the trace captures are written to
+//		--capture <path>		capture the frames from launch, to a .y4m file
+//								or (path ending in .ppm) a sequence of images;
+//								also the file used by 'C'
+//		--perf-counters			sample hardware counters (Linux) in profiled zones
+//		--profile-json <path>	write the profiling report as JSON on exit
+//		--frame-budget <ms>		preferred time between two rendered frames
+//		--asteroids <count>		number of asteroids created at launch
+//		--world-scale <k>		make the world k times as wide and high as the
+//								view, which follows the ship (default: 1, the
+//								view shows the whole world)
+//		--headless <frames>		run that many frames without a window, drawing
+//								them with the CPU rasterizer, then report the
+//								rendering times and exit
+//		--render-out <path>		PPM image the last headless frame is written to
+//		--render-threads <n>	rasterizing threads of the headless mode
+//								(default: one per hardware thread)
+//		--seed <n>				seed of the random engine of the world
+//		--batch <worlds>		step that many independent worlds (seeds n,
+//								n+1, ...) without a window, in parallel, then
+//								report the throughput and how the ships fared
+//		--batch-steps <n>		steps run on each world of the batch
+//		--batch-threads <n>		worker threads of the batch
+//								(default: one per hardware thread)
+//		--batch-vectorized		run the batch as blocks of worlds stored
+//								slot by slot, stepped four worlds at a time
+//								(SIMD), and report the env steps per second
+//		--batch-check			run the batch both ways, and check that each
+//								world ends the same (exit status 1 if not)
 //	Initial aspect ratio of the window is preserved when the window
 //	is resized.
+//	The world, its objects, and the rules of the game are owned by a
+//	Simulation object, so that a batch of them can run in one process.
+//	The simulation runs on its own thread.  Whenever a frame is due, it
+//	records the objects into a snapshot that it publishes to the GLUT
+//	thread, which draws it: a slow frame doesn't delay the simulation, and
+//	the simulation doesn't hold up the frames.
 //
 //  Created by Jean-Yves Hervé on 2024-10-16.
 //
@@ -34,10 +86,17 @@
 #include <string>
 #include <vector>
 #include <list>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
 #include <memory>
 #include <random>
 #include <chrono>
 #include <ctime>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
 //
 #include "glPlatform.h"
 #include "World2D.h"
@@ -47,6 +106,22 @@
 #include "SmilingFace.h"
 #include "SpaceShip.h"
 #include "Projectile.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
+#include "FrameScheduler.h"
+#include "TextRenderer.h"
+#include "BatchRenderer.h"
+#include "SoftwareRenderer.h"
+#include "RenderCommandBuffer.h"
+#include "TripleBuffer.h"
+#include "FrameCapture.h"
+#include "TransformBatch.h"
+#include "GLStateCache.h"
+#include "Simulation.h"
+#include "BatchRunner.h"
+#include "WorldBatch.h"
+#include "Camera2D.h"
+#include "WorkerPool.h"
 
 using namespace std;
 using namespace earshooter;
@@ -106,8 +181,8 @@ enum FontSize {
 	NUM_FONT_SIZES
 };
 
-using objIter = list<shared_ptr<GraphicObject2D> >::iterator;
-using constObjIter = list<shared_ptr<GraphicObject2D> >::const_iterator;
+using objIter = ObjectList::iterator;
+using constObjIter = ObjectList::const_iterator;
 
 
 #if 0
@@ -133,6 +208,14 @@ void myMenuHandler(int value);
 void mySubmenuHandler(int colorIndex);
 void myTimerFunc(int val);
 void applicationInit();
+void createWorld();
+void parseCommandLine(int argc, char* argv[]);
+int runHeadless();
+int runBatch();
+void simulationLoop();
+void stopSimulation();
+void writeProfileJSON();
+bool isInView(const BoundingBox& box, float dx, float dy);
 //
 void drawSquare(float cx, float cy, float size, float r,
 	float g, float b, bool contour);
@@ -153,17 +236,11 @@ void drawSquare(float cx, float cy, float size, float r,
 const int 	INIT_WIN_X = 10,
 INIT_WIN_Y = 32;
 
-//	Define world dimensions (cascaded down to the World2D class)
-//	Also, some speed limits based on world dimensions.
+//	Dimensions of the view, and of the worlds of a batch.  The world on
+//	display is worldScale times as wide and high, centered on the origin.
 const float X_MIN = -10.f, X_MAX = +10.f;
 const float Y_MIN = -10.f, Y_MAX = +10.f;
-//
-const float MAX_SPIN = 100.f;	//	degree per second
-const float MIN_TIME_TO_CROSS = 5.f;	// shortest time for an object to cross the screen
-const float MAX_SPEED = (X_MAX - X_MIN) / MIN_TIME_TO_CROSS;
-//	min and max sizes of an object
-const float MIN_SIZE = (X_MAX - X_MIN) / 30;
-const float MAX_SIZE = (X_MAX - X_MIN) / 10;
+const WorldType WORLD_TYPE = WorldType::SPHERE_WORLD;
 
 //	A bunch of constants for the display of text
 const int TEXT_H_PAD = 10;
@@ -207,9 +284,51 @@ const string WORLD_TYPE_STR[] = {
 const bool displayTextOnLeft = false;
 const bool displayTextOnTop = true;
 const FontSize fontSize = LARGE_FONT_SIZE;
+//	status line, string line, and the optional lines of stats
+const int MAX_HUD_ROWS = 7;
+
+//	The objects are recorded into command buffers by up to that many threads,
+//	each one taking at least that many of the copies to draw
+const unsigned int MAX_RECORD_THREADS = 8;
+const unsigned int MIN_COPIES_PER_RECORD_THREAD = 256;
 
 const int NUM_OBJECTS = 15;
 
+//	Worlds of a block of a vectorized batch (each block is one task of the
+//	batch runner, so there must be enough of them to keep all the cores busy)
+const int WORLDS_PER_BLOCK = 256;
+
+//	An object, or one of its wraparound ghosts, that passed the cull test
+struct VisibleCopy
+{
+	GraphicObject2D* obj;
+	float dx, dy;
+};
+
+//	What the GLUT thread needs to draw a frame, published by the simulation
+//	thread.  It holds no reference to the objects, which keep changing.
+struct WorldSnapshot
+{
+	RenderCommandBuffer commands;
+	unsigned int nbCopiesDrawn = 0, nbCopiesCulled = 0;
+	unsigned int liveCount = 0, createdCount = 0;
+};
+
+//	How a world of a batch ended
+struct WorldOutcome
+{
+	bool shipAlive;
+	int health;
+	unsigned int nbObjects, nbAsteroids;
+};
+
+unsigned int collectVisibleCopies(vector<VisibleCopy>& copies);
+void recordGridCells(Renderer2D& renderer);
+void recordSnapshot(WorldSnapshot& snapshot);
+string getRenderSummaryLine(const WorldSnapshot& snapshot);
+double runScalarBatch(const BatchRunner& runner, float dt, vector<WorldOutcome>& outcome);
+double runVectorizedBatch(const BatchRunner& runner, float dt, vector<WorldOutcome>& outcome);
+
 #if 0
 //--------------------------------------
 #pragma mark -
@@ -232,28 +351,59 @@ string stringLine = "";
 int textColorIndex = 0;
 int bgndColorIndex = 0;//BGND_COLOR[0];
 
-WorldType World2D::worldType = WorldType::SPHERE_WORLD;
-bool World2D::drawReferenceFrames = false;
+bool drawGridCells = false;
 
-list<shared_ptr<GraphicObject2D> > objList;
+//	The world being displayed, the ship of the player in it, and the camera
+//	that follows the ship
+unique_ptr<Simulation> simulation;
+std::shared_ptr<SpaceShip> spaceship;
+Camera2D camera(X_MAX - X_MIN, Y_MAX - Y_MIN);
 
 int physicsHeartBeat = 1;	// milliseconds
-int renderRate = 10;		//	1 rendering frame for 10 simulation heartbeats
+//	One simulation step per heartbeat, at most 100 in a heartbeat to catch up.
+//	60 frames per second when the CPU allows it, no fewer than 10.
+FrameScheduler frameScheduler(physicsHeartBeat / 1000.f, 1.f / 60.f, 0.1f, 100);
+BatchRenderer renderer;
+TextRenderer hudText;
+vector<VisibleCopy> visibleList;		//	recorded by the simulation thread
+//	poses and model transformations of the copies in visibleList
+vector<float> poseX, poseY, poseAngle;
+vector<Transform2D> modelList;
+RenderCommandBuffer sliceBuffer[MAX_RECORD_THREADS - 1];
+//	the threads recording the slices, started with the first snapshot (a
+//	batch run records none) and kept for all the others
+unique_ptr<WorkerPool> recorderPool;
+TripleBuffer<WorldSnapshot> snapshots;
+//	Held by the simulation thread while it runs, and by the other threads
+//	for the little they do with the objects (input)
+mutex worldLock;
+thread simulationThread;
+atomic<bool> simulationRunning(false);
 bool isAnimated = true;
 bool animationJustStarted = false;
 
-random_device myRandDev;
-default_random_engine myEngine(myRandDev());
-uniform_int_distribution<int> shapeDist(0, 3);	//	triangle - rect - ellipse - face
-uniform_real_distribution<float> angleDist(0, 2 * M_PI);
-uniform_real_distribution<float> colorDist(0.f, 1.f);
-uniform_real_distribution<float> spinDist(-MAX_SPIN, +MAX_SPIN);
-uniform_real_distribution<float> speedDist(0.4f * MAX_SPEED, MAX_SPEED);
-uniform_real_distribution<float> sizeDist(MIN_SIZE, MAX_SIZE);
-uniform_real_distribution<float> xDist(X_MIN, X_MAX);
-uniform_real_distribution<float> yDist(Y_MIN, Y_MAX);
+float traceSeconds = 5.f;		//	duration of a trace capture
+bool traceAtLaunch = false;
+FrameCapture frameCapture;
+string captureFilePath = "capture.y4m";
+bool captureAtLaunch = false;
+string traceFilePath = TraceRecorder::DEFAULT_OUTPUT_PATH;
+bool usePerfCounters = false;
+string profileJSONPath = "";
+
+int nbInitialAsteroids = 0;
+float worldScale = 1.f;
+int headlessFrames = 0;			//	0: run in a window
+string renderOutPath = "";
+unsigned int renderThreads = 0;
 
-std::shared_ptr<SpaceShip> spaceship;
+random_device myRandDev;
+unsigned int randomSeed = myRandDev();
+int batchWorlds = 0;			//	0: run a single world
+int batchSteps = 10000;
+unsigned int batchThreads = 0;
+bool batchVectorized = false;
+bool batchCheck = false;
 
 #if 0
 //--------------------------------------
@@ -273,8 +423,16 @@ std::shared_ptr<SpaceShip> spaceship;
 //
 void myDisplayFunc(void)
 {
+	chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+	TraceScope frameScope("frame", "render");
+	GLStateCache::beginFrame();
+
+	//	The latest snapshot published (or the last one drawn, if none since)
+	snapshots.acquire();
+	WorldSnapshot& snapshot = snapshots.getFront();
+
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	glMatrixMode(GL_MODELVIEW);
+	GLStateCache::setMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
 
 	glPushMatrix();
@@ -282,76 +440,12 @@ void myDisplayFunc(void)
 	//--------------------------
 	//	basic drawing code
 	//--------------------------
-
-	for (auto obj : objList)
-		obj->draw();
-
-	switch (World2D::worldType)
 	{
-	case WorldType::WINDOW_WORLD:
-	case WorldType::BOX_WORLD:
-		break;
+		ProfileScope drawScope(ProfileZone::DRAW, snapshot.nbCopiesDrawn);
 
-	case WorldType::CYLINDER_WORLD:
-		glPushMatrix();
-		//	draw the  left quadrant
-		glTranslatef(-World2D::WIDTH, 0.f, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-
-		//	draw right quadrant
-		glTranslatef(2.f * World2D::WIDTH, 0.f, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glPopMatrix();
-		break;
-
-
-	case WorldType::SPHERE_WORLD:
-		glPushMatrix();
-		// Draw central (original) position
-		for (auto obj : objList)
-			obj->draw();
-
-		// Draw all eight surrounding copies
-
-		// Left and Right translations
-		glTranslatef(-World2D::WIDTH, 0.f, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glTranslatef(2.f * World2D::WIDTH, 0.f, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glTranslatef(-World2D::WIDTH, 0.f, 0.f); // reset to center
-
-		// Top and Bottom translations
-		glTranslatef(0.f, World2D::HEIGHT, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glTranslatef(0.f, -2.f * World2D::HEIGHT, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glTranslatef(0.f, World2D::HEIGHT, 0.f); // reset to center
-
-		// Top-Left, Top-Right, Bottom-Left, Bottom-Right translations
-		glTranslatef(-World2D::WIDTH, World2D::HEIGHT, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glTranslatef(2.f * World2D::WIDTH, 0.f, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glTranslatef(0.f, -2.f * World2D::HEIGHT, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-		glTranslatef(-2.f * World2D::WIDTH, 0.f, 0.f);
-		for (auto obj : objList)
-			obj->draw();
-
-		glPopMatrix();
-		break;
-
-	default:
-		break;
+		//	(boxes, reference frames, and grid cells are part of the snapshot)
+		snapshot.commands.submit(renderer);
+		renderer.flush();
 	}
 
 	//	Display textual info
@@ -360,32 +454,74 @@ void myDisplayFunc(void)
 	//	So we must undo the scaling to be back in pixels, which how text is drawn for now.
 	if (displayText)
 	{
+		ProfileScope hudScope(ProfileZone::HUD);
+
 		//	First, translate to the upper-left corner
-		glTranslatef(World2D::X_MIN, World2D::Y_MAX, 0.f);
+		glTranslatef(-0.5f * camera.getWidth(), 0.5f * camera.getHeight(), 0.f);
 
 		//	Then reverse the scaling: back in pixels, making sure that y now points down
 		glScalef(World2D::drawInPixelScale, -World2D::drawInPixelScale, 1.f);
 
 		char statusLine[256];
 		sprintf(statusLine, "%s | Run time: %d s | %d live ˚objects (%d created) | Mouse last at (%d, %d)",
-			WORLD_TYPE_STR[static_cast<int>(World2D::worldType)].c_str(),
+			WORLD_TYPE_STR[static_cast<int>(simulation->getWorld().getType())].c_str(),
 			static_cast<int>(time(nullptr) - startTime),
-			static_cast<int>(GraphicObject2D::getBaseLiveCount()),
-			static_cast<int>(GraphicObject2D::getBaseCount()),
+			static_cast<int>(snapshot.liveCount),
+			static_cast<int>(snapshot.createdCount),
 			lastX, lastY);
-		displayTextualInfo(statusLine, 0);		//	first row
 
+		string hudRow[MAX_HUD_ROWS];
+		int nbHudRows = 0;
+		hudRow[nbHudRows++] = statusLine;		//	first row
 		if (stringLine != "")
-			displayTextualInfo(stringLine, 1);		//	second row
+			hudRow[nbHudRows++] = stringLine;	//	second row
+
+		//	optional lines of profiling and memory info, below the other ones
+		if (Profiler::hudLineIsDrawn())
+			hudRow[nbHudRows++] = Profiler::getSummaryLine();
+		if (Profiler::hudLineIsDrawn() || frameScheduler.isBehind())
+			hudRow[nbHudRows++] = frameScheduler.getSummaryLine();
+		if (Profiler::hudLineIsDrawn())
+		{
+			hudRow[nbHudRows++] = getRenderSummaryLine(snapshot);
+			hudRow[nbHudRows++] = GLStateCache::getSummaryLine();
+		}
+		if (MemoryTracker::hudLineIsDrawn())
+			hudRow[nbHudRows++] = MemoryTracker::getSummaryLine();
+
+		//	The atlas renderer only rebuilds the rows whose text changed
+		if (hudText.isReady())
+		{
+			hudText.setLayout(winWidth, winHeight, displayTextOnLeft, displayTextOnTop,
+							  TEXT_H_PAD, TEXT_V_PAD);
+			hudText.setColors(TEXT_COLOR[textColorIndex],
+							  bgndColorIndex != 0 ? BGND_COLOR[bgndColorIndex] : nullptr);
+			for (int k = 0; k < nbHudRows; k++)
+				hudText.setRow(k, hudRow[k]);
+			hudText.setRowCount(nbHudRows);
+			hudText.draw();
+		}
+		else
+		{
+			for (int k = 0; k < nbHudRows; k++)
+				displayTextualInfo(hudRow[k], k);
+		}
 	}
 
 	glPopMatrix();
 
-	drawReferenceFrame();
+	if (frameCapture.isRunning())
+	{
+		ProfileScope captureScope(ProfileZone::CAPTURE);
+		frameCapture.captureFrame(winWidth, winHeight);
+	}
 
 	//	We were drawing into the back buffer(s), now they should be brought
 	//	to the forefront.  This will be explained in a few weeks.
 	glutSwapBuffers();
+
+	frameScheduler.recordRenderCost(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+										chrono::steady_clock::now() - frameStart).count()));
 }
 
 
@@ -410,12 +546,14 @@ void myResizeFunc(int w, int h)
 	//	Here I create my virtual camera.  We are going to do 2D drawing for a while, so what this
 	//	does is define the dimensions (origin and units) of the "virtual World2D that my viewport
 	//	maps to.
-	glMatrixMode(GL_PROJECTION);
+	GLStateCache::setMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
 
 	//	Here I define the dimensions of the "virtual World2D" that my
 	//	window maps to
-	gluOrtho2D(X_MIN, X_MAX, Y_MIN, Y_MAX);
+	//	(the frames are drawn relative to the center of the view)
+	gluOrtho2D(-0.5f * camera.getWidth(), 0.5f * camera.getWidth(),
+			   -0.5f * camera.getHeight(), 0.5f * camera.getHeight());
 
 	//	When it's done, request a refresh of the display
 	glutPostRedisplay();
@@ -427,6 +565,7 @@ void myResizeFunc(int w, int h)
 //
 void myMouseHandler(int button, int state, int x, int y) {
 	if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN) {
+		lock_guard<mutex> lock(worldLock);
 		if (spaceship && spaceship->isAlive()) {
 			spaceship->fireProjectile();
 		}
@@ -483,14 +622,19 @@ void myKeyHandler(unsigned char c, int x, int y)
 	{
 	case 'q':
 	case 27:
+		//	the frames still being read back need the GL context
+		frameCapture.stop();
 		exit(0);
 		break;
 
 	case ' ':
+	{
+		lock_guard<mutex> lock(worldLock);
 		if (spaceship && spaceship->isAlive()) {
 			spaceship->fireProjectile();
 		}
 		break;
+	}
 
 		//-------------------------
 		//	mouse tracking cases
@@ -524,46 +668,99 @@ void myKeyHandler(unsigned char c, int x, int y)
 		////-------------------------
 		////	activates "window" mode (objects disappear at the edge)
 		//case 'w':
-		//	World2D::worldType = WorldType::WINDOW_WORLD;
+		//	simulation->getWorld().setType(WorldType::WINDOW_WORLD);
 		//	break;
 
 		////	activates "box" mode (objects bounce off all edges)
 		//case 'b':
-		//	World2D::worldType = WorldType::BOX_WORLD;
+		//	simulation->getWorld().setType(WorldType::BOX_WORLD);
 		//	break;
 
 		////	activates "cylindrical" mode (objects wrap around vertical
 		////			edges, bounce off the horizontal edges)
 		//case 'c':
-		//	World2D::worldType = WorldType::CYLINDER_WORLD;
+		//	simulation->getWorld().setType(WorldType::CYLINDER_WORLD);
 		//	break;
 
 		////	activates "spherical" mode (objects wrap around all edges)
 		//case 's':
-		//	World2D::worldType = WorldType::SPHERE_WORLD;
+		//	simulation->getWorld().setType(WorldType::SPHERE_WORLD);
 		//	break;
 
 		//-----------------------------
 		//	Reference frames
 		//-----------------------------
 	case 'f':
+	{
+		lock_guard<mutex> lock(worldLock);
 		World2D::drawReferenceFrames = !World2D::drawReferenceFrames;
 		break;
+	}
+
+	case 'g':
+	{
+		lock_guard<mutex> lock(worldLock);
+		drawGridCells = !drawGridCells;
+		break;
+	}
+
+		//-----------------------------
+		//	Profiling
+		//-----------------------------
+	case 'h':
+		Profiler::setDrawHudLine(!Profiler::hudLineIsDrawn());
+		break;
+
+	case 'P':
+		Profiler::report(cout);
+		MemoryTracker::report(cout);
+		GLStateCache::report(cout);
+		break;
+
+	case 'M':
+		MemoryTracker::setDrawHudLine(!MemoryTracker::hudLineIsDrawn());
+		break;
+
+	case 'T':
+		TraceRecorder::start(traceSeconds, traceFilePath);
+		break;
+
+	case 'C':
+		if (frameCapture.isRunning())
+			frameCapture.stop();
+		else
+			frameCapture.start(captureFilePath, winWidth, winHeight);
+		break;
+
+	case 'S':
+		renderer.setShapesEnabled(!renderer.usesShapes());
+		cout << "Basic shapes drawn from " << (renderer.usesShapes() ? "distance functions"
+																	  : "tessellations") << endl;
+		break;
 
 		//-----------------------------
 		//	Bounding boxes
 		//-----------------------------
+	//	(the simulation thread reads these when it records a snapshot)
 	case 'A':
+	{
+		lock_guard<mutex> lock(worldLock);
 		BoundingBox::setDrawAbsoluteBoxes(!BoundingBox::absoluteBoxesAreDrawn());
 		break;
+	}
 
 	case 'r':
+	{
+		lock_guard<mutex> lock(worldLock);
 		BoundingBox::setDrawRelativeBoxes(!BoundingBox::relativeBoxesAreDrawn());
 		break;
+	}
 		//-------------------------
 		// Spaceship movement
 		//-------------------------
 	case 'a': // 'A' key pressed for left rotation
+	{
+		lock_guard<mutex> lock(worldLock);
 		if (spaceship && spaceship->cantmove()) {
 			spaceship->setAngularVelocity(200.0f); // Start counterclockwise rotation
 		}
@@ -572,6 +769,7 @@ void myKeyHandler(unsigned char c, int x, int y)
 			spaceship->setAngularVelocity(0.0f);
 		}
 		break;
+	}
 
 	default:
 		break;
@@ -585,6 +783,7 @@ void myKeyUpHandler(unsigned char c, int x, int y)
 	(void)y;
 
 	if (spaceship) {
+		lock_guard<mutex> lock(worldLock);
 		switch (c) {
 		case 'a': // 'A' key released, stop rotation
 			spaceship->setAngularVelocity(0.0f); // Stop rotation
@@ -603,6 +802,7 @@ void mySpecialKeyHandler(int key, int x, int y)
 	(void)y;  // Suppress unused parameter warning
 
 	if (spaceship) {
+		lock_guard<mutex> lock(worldLock);
 		switch (key) {
 		case GLUT_KEY_LEFT:  // Left arrow key
 			if (spaceship && spaceship->cantmove()) {
@@ -625,6 +825,7 @@ void mySpecialKeyUpHandler(int key, int x, int y)
 	(void)y;  // Suppress unused parameter warning
 
 	if (spaceship) {
+		lock_guard<mutex> lock(worldLock);
 		switch (key) {
 		case GLUT_KEY_LEFT:  // Left arrow key released
 			spaceship->setAngularVelocity(0.0f); // Stop rotation
@@ -636,97 +837,238 @@ void mySpecialKeyUpHandler(int key, int x, int y)
 	}
 }
 
-void generateRandomAsteroid() {
-	// Generate random properties for the asteroid
-	float x = xDist(myEngine);
-	float y = yDist(myEngine);
-	float angle = angleDist(myEngine);
-	float direction = angleDist(myEngine);
-	float speed = speedDist(myEngine);
-	float spin = spinDist(myEngine);
-	float r = colorDist(myEngine);
-	float g = colorDist(myEngine);
-	float b = colorDist(myEngine);
-	float size = sizeDist(myEngine);
-
-	// Choose random shape for the asteroid
-	switch (shapeDist(myEngine)) {
-	case 0:
-		objList.push_back(make_shared<Triangle>(x, y, angle, size, r, g, b, true,
-			speed * cosf(direction), speed * sinf(direction), spin));
-		break;
-
-	case 1:
-		objList.push_back(make_shared<earshooter::Rectangle2D>(x, y, angle, size, size, r, g, b, true,
-			speed * cosf(direction), speed * sinf(direction), spin));
-		break;
-
-	case 2:
-		objList.push_back(make_shared<earshooter::Ellipse2D>(x, y, angle, size, size, r, g, b, true,
-			speed * cosf(direction), speed * sinf(direction), spin));
-		break;
-
-	case 3:
-		objList.push_back(make_shared<SmilingFace>(x, y, angle, size, r, g, b,
-			speed * cosf(direction), speed * sinf(direction), spin));
-		break;
+//	Cull pass: only the sectors that the view may overlap are searched.
+//	Where the world wraps around, an object also shows on the other side of
+//	the edge (as a ghost copy) when its box or the view crosses it.  The
+//	copies are kept relative to the center of the view.
+//	@RETURN	the number of objects searched that have no copy in view
+unsigned int collectVisibleCopies(vector<VisibleCopy>& copies)
+{
+	copies.clear();
+	unsigned int nbCulled = 0;
+	const World2D& world = simulation->getWorld();
+	const int ghostsX = (world.getType() == WorldType::CYLINDER_WORLD ||
+						 world.getType() == WorldType::SPHERE_WORLD) ? 1 : 0;
+	const int ghostsY = (world.getType() == WorldType::SPHERE_WORLD) ? 1 : 0;
+	//	an object is no larger than a sector, so one more sector all around
+	int radius = 1 + static_cast<int>(ceilf(max(0.5f * camera.getWidth() / world.getSectorWidth(),
+												0.5f * camera.getHeight() / world.getSectorHeight())));
+	world.forEachSectorAround(world.getSectorOf(camera.getCenterX(), camera.getCenterY()), radius,
+							  [&](int sector)
+	{
+		for (ObjectList::iterator iter : world.getSectorObjects(sector))
+		{
+			const BoundingBox& box = (*iter)->getAbsoluteBoundingBox();
+			bool shown = false;
+			for (int i = -ghostsY; i <= ghostsY; i++)
+				for (int j = -ghostsX; j <= ghostsX; j++)
+				{
+					float dx = j * world.getWidth(), dy = i * world.getHeight();
+					if (isInView(box, dx, dy))
+					{
+						copies.push_back(VisibleCopy{iter->get(), dx - camera.getCenterX(),
+													 dy - camera.getCenterY()});
+						shown = true;
+					}
+				}
+			if (!shown)
+				nbCulled++;
+		}
+	});
+	return nbCulled;
+}
 
-	default:
-		break;
+//	Debug layer: the cells of a uniform grid over the world, in which a
+//	broad phase would only test pairs of objects whose boxes share a cell.
+//	Only the part of the grid in view is drawn, and the cells that hold
+//	parts of several of the copies in view are highlighted.
+void recordGridCells(Renderer2D& renderer)
+{
+	const World2D& world = simulation->getWorld();
+	//	a cell of the broad-phase grid can hold the largest object
+	static const float GRID_CELL_SIZE = 2.f * simulation->getMaxObjectSize();
+	static vector<unsigned int> cellCount;
+	const float* grey = COLOR[static_cast<int>(ColorIndex::GREY)];
+	const float* yellow = COLOR[static_cast<int>(ColorIndex::YELLOW)];
+
+	//	the grid starts at the lower-left corner of the world; all is relative
+	//	to the center of the view
+	const float x0 = world.getXmin() - camera.getCenterX(), y0 = world.getYmin() - camera.getCenterY();
+	const float halfWidth = 0.5f * camera.getWidth(), halfHeight = 0.5f * camera.getHeight();
+	const int colMin = static_cast<int>(floorf((-halfWidth - x0) / GRID_CELL_SIZE));
+	const int colMax = static_cast<int>(ceilf((halfWidth - x0) / GRID_CELL_SIZE)) - 1;
+	const int rowMin = static_cast<int>(floorf((-halfHeight - y0) / GRID_CELL_SIZE));
+	const int rowMax = static_cast<int>(ceilf((halfHeight - y0) / GRID_CELL_SIZE)) - 1;
+	const int nbCols = colMax - colMin + 1, nbRows = rowMax - rowMin + 1;
+
+	cellCount.assign(nbCols * nbRows, 0u);
+	for (const VisibleCopy& copy : visibleList)
+	{
+		const BoundingBox& box = copy.obj->getAbsoluteBoundingBox();
+		int col0 = max(colMin, static_cast<int>(floorf((box.getXmin() + copy.dx - x0) / GRID_CELL_SIZE)));
+		int col1 = min(colMax, static_cast<int>(floorf((box.getXmax() + copy.dx - x0) / GRID_CELL_SIZE)));
+		int row0 = max(rowMin, static_cast<int>(floorf((box.getYmin() + copy.dy - y0) / GRID_CELL_SIZE)));
+		int row1 = min(rowMax, static_cast<int>(floorf((box.getYmax() + copy.dy - y0) / GRID_CELL_SIZE)));
+		for (int row = row0; row <= row1; row++)
+			for (int col = col0; col <= col1; col++)
+				cellCount[(row - rowMin) * nbCols + col - colMin]++;
 	}
-}
 
+	//	one segment per grid line
+	for (int col = colMin; col <= colMax + 1; col++)
+	{
+		float x = min(max(x0 + col * GRID_CELL_SIZE, -halfWidth), halfWidth);
+		const float line[2][2] = {{x, -halfHeight}, {x, halfHeight}};
+		renderer.addLineStrip(RenderBatch::DEBUG, Transform2D::identity(), line, 2,
+							  grey[0], grey[1], grey[2]);
+	}
+	for (int row = rowMin; row <= rowMax + 1; row++)
+	{
+		float y = min(max(y0 + row * GRID_CELL_SIZE, -halfHeight), halfHeight);
+		const float line[2][2] = {{-halfWidth, y}, {halfWidth, y}};
+		renderer.addLineStrip(RenderBatch::DEBUG, Transform2D::identity(), line, 2,
+							  grey[0], grey[1], grey[2]);
+	}
 
+	//	a cell inset by a pixel, so that neighbouring highlights don't merge
+	const float inset = World2D::pixelToWorldRatio;
+	for (int row = rowMin; row <= rowMax; row++)
+		for (int col = colMin; col <= colMax; col++)
+			if (cellCount[(row - rowMin) * nbCols + col - colMin] > 1)
+			{
+				float xmin = max(x0 + col * GRID_CELL_SIZE, -halfWidth) + inset,
+					  ymin = max(y0 + row * GRID_CELL_SIZE, -halfHeight) + inset;
+				float xmax = min(x0 + (col + 1) * GRID_CELL_SIZE, halfWidth) - inset,
+					  ymax = min(y0 + (row + 1) * GRID_CELL_SIZE, halfHeight) - inset;
+				const float cell[4][2] = {{xmin, ymin}, {xmax, ymin}, {xmax, ymax}, {xmin, ymax}};
+				renderer.addLineLoop(RenderBatch::DEBUG, Transform2D::identity(), cell, 4,
+									 yellow[0], yellow[1], yellow[2]);
+			}
+}
 
-void myTimerFunc(int value)
+//	Records all the objects (and their ghosts) in view as commands, sorted
+//	by batch, in parallel when there are enough of them.  The debug layers
+//	that are enabled are recorded with them, in the debug batch.
+void recordSnapshot(WorldSnapshot& snapshot)
 {
-	static int updateFrameIndex = 0;
-	static chrono::high_resolution_clock::time_point lastTime = chrono::high_resolution_clock::now();
-	static float timeSinceLastAsteroid = 0.0f;  // Track time for asteroid spawning
-	const float asteroidSpawnInterval = 1.0f;    // Spawn every 1 seconds
-
-	// Re-prime the timer
-	glutTimerFunc(physicsHeartBeat, myTimerFunc, value);
-
-	if (isAnimated)
+	camera.follow(simulation->getWorld(), spaceship->getX(), spaceship->getY());
+	snapshot.nbCopiesCulled = collectVisibleCopies(visibleList);
+	snapshot.nbCopiesDrawn = static_cast<unsigned int>(visibleList.size());
+	snapshot.liveCount = static_cast<unsigned int>(GraphicObject2D::getBaseLiveCount());
+	snapshot.createdCount = static_cast<unsigned int>(GraphicObject2D::getBaseCount());
+
+	if (recorderPool == nullptr)
+		recorderPool = make_unique<WorkerPool>(min(max(1u, thread::hardware_concurrency()),
+												   MAX_RECORD_THREADS));
+	//	Each thread takes a contiguous slice of the list, so that the buffers
+	//	appended in order keep the list order
+	unsigned int nbSlices = min(recorderPool->getThreadCount(),
+								max(1u, snapshot.nbCopiesDrawn / MIN_COPIES_PER_RECORD_THREAD));
+	//	All the model transformations in one batch, rather than one object at
+	//	a time from the draw functions
+	size_t nbCopies = visibleList.size();
+	poseX.resize(nbCopies);
+	poseY.resize(nbCopies);
+	poseAngle.resize(nbCopies);
+	modelList.resize(nbCopies);
+	for (size_t k = 0; k < nbCopies; k++)
 	{
-		chrono::high_resolution_clock::time_point currentTime = chrono::high_resolution_clock::now();
-		float dt = chrono::duration_cast<chrono::duration<float>>(currentTime - lastTime).count();
-		if (animationJustStarted)
+		const VisibleCopy& copy = visibleList[k];
+		poseX[k] = copy.obj->getX() + copy.dx;
+		poseY[k] = copy.obj->getY() + copy.dy;
+		poseAngle[k] = copy.obj->getAngle();
+	}
+	computeModelTransforms(poseX.data(), poseY.data(), poseAngle.data(),
+						   static_cast<int>(nbCopies), modelList.data());
+
+	snapshot.commands.clear();
+	if (drawGridCells)
+		recordGridCells(snapshot.commands);
+	drawReferenceFrame(snapshot.commands, Transform2D::translation(-camera.getCenterX(),
+																   -camera.getCenterY()));
+	auto recordSlice = [nbSlices, &snapshot](unsigned int slice)
+	{
+		RenderCommandBuffer& buffer = (slice == 0) ? snapshot.commands : sliceBuffer[slice-1];
+		size_t first = visibleList.size() * slice / nbSlices;
+		size_t last = visibleList.size() * (slice + 1) / nbSlices;
+		for (size_t k = first; k < last; k++)
 		{
-			dt = 0.f;
-			animationJustStarted = false;
+			const VisibleCopy& copy = visibleList[k];
+			copy.obj->drawModel(buffer, modelList[k]);
+			copy.obj->drawDebug(buffer, Transform2D::translation(copy.dx, copy.dy));
 		}
-		lastTime = currentTime;
+	};
+	recorderPool->run(nbSlices, recordSlice);
 
-		// Update all objects in objList
-		for (auto iter = objList.begin(); iter != objList.end(); )
+	for (unsigned int slice = 1; slice < nbSlices; slice++)
+	{
+		snapshot.commands.append(sliceBuffer[slice-1]);
+		sliceBuffer[slice-1].clear();
+	}
+	snapshot.commands.flush();
+}
+
+//	Runs on its own thread: steps the simulation at the pace of real time,
+//	and publishes a snapshot of the world whenever a frame is due.
+void simulationLoop()
+{
+	while (simulationRunning)
+	{
 		{
-			UpdateStatus status = (*iter)->update(dt);
-			if (status == UpdateStatus::DEAD)
+			lock_guard<mutex> lock(worldLock);
+
+			if (isAnimated)
 			{
-				iter = objList.erase(iter);  // Remove dead objects
+				TraceScope tickScope("tick", "sim");
+				if (animationJustStarted)
+				{
+					frameScheduler.restartClock();
+					animationJustStarted = false;
+				}
+
+				//	Run as many fixed steps as the real time elapsed calls for
+				//	(within the limits set by the scheduler)
+				const float dt = frameScheduler.getStepDuration();
+				int nbSteps = frameScheduler.beginTick();
+				chrono::steady_clock::time_point tickStart = chrono::steady_clock::now();
+				for (int step = 0; step < nbSteps; step++)
+					simulation->step(dt);
+				frameScheduler.endTick(nbSteps, static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+													chrono::steady_clock::now() - tickStart).count()));
 			}
-			else
+
+			if (frameScheduler.shouldRender())
 			{
-				++iter;
+				TraceScope recordScope("record", "sim");
+				recordSnapshot(snapshots.getBack());
+				snapshots.publish();
 			}
 		}
 
-		// Periodically generate new asteroids
-		timeSinceLastAsteroid += dt;
-		if (timeSinceLastAsteroid >= asteroidSpawnInterval && spaceship->isAlive()) {
-			generateRandomAsteroid();
-			timeSinceLastAsteroid = 0.0f;  // Reset the spawn timer
-		}
+		this_thread::sleep_for(chrono::milliseconds(physicsHeartBeat));
 	}
+}
 
-	// Trigger rendering as needed
-	if (updateFrameIndex++ % renderRate == 0)
-		glutPostRedisplay();
+//	Registered with atexit, so that the simulation thread is stopped before
+//	the objects get destroyed
+void stopSimulation()
+{
+	simulationRunning = false;
+	if (simulationThread.joinable())
+		simulationThread.join();
 }
 
+void myTimerFunc(int value)
+{
+	// Re-prime the timer
+	glutTimerFunc(physicsHeartBeat, myTimerFunc, value);
+
+	TraceRecorder::poll();
 
+	// Trigger rendering when the simulation thread has published a frame
+	if (snapshots.hasFresh())
+		glutPostRedisplay();
+}
 
 
 //	This  is where the menu item selected is identified.  This is
@@ -790,7 +1132,7 @@ void drawSquare(float cx, float cy, float size, float r,
 {
 	float halfSize = 0.5f * size;
 
-	glColor3f(r, g, b);
+	GLStateCache::setColor(r, g, b);
 	glBegin(GL_POLYGON);
 	glVertex2f(cx - halfSize, cy - halfSize);
 	glVertex2f(cx + halfSize, cy - halfSize);
@@ -801,7 +1143,7 @@ void drawSquare(float cx, float cy, float size, float r,
 	if (drawContour)
 	{
 		// simply invert the filling color
-		glColor3f(1.f - r, 1.f - g, 1.f - b);
+		GLStateCache::setColor(1.f - r, 1.f - g, 1.f - b);
 		glBegin(GL_LINE_LOOP);
 		glVertex2f(cx - halfSize, cy - halfSize);
 		glVertex2f(cx + halfSize, cy - halfSize);
@@ -881,7 +1223,7 @@ void displayTextualInfo(const char* infoStr, int textRow)
 	//-----------------------------------------------
 	if (bgndColorIndex != 0)
 	{
-		glColor3fv(BGND_COLOR[bgndColorIndex]);
+		GLStateCache::setColor(BGND_COLOR[bgndColorIndex]);
 		glBegin(GL_POLYGON);
 		glVertex2i(0, 0);
 		glVertex2i(0, fontHeight + 2 * TEXT_V_PAD);
@@ -900,7 +1242,7 @@ void displayTextualInfo(const char* infoStr, int textRow)
 	int xPos = displayTextOnLeft ? TEXT_H_PAD : winWidth - textWidth - TEXT_H_PAD;
 	int yPos = fontHeight + TEXT_V_PAD;
 
-	glColor3fv(TEXT_COLOR[textColorIndex]);
+	GLStateCache::setColor(TEXT_COLOR[textColorIndex]);
 	int x = xPos;
 	switch (fontSize)
 	{
@@ -949,6 +1291,125 @@ void displayTextualInfo(const char* infoStr, int textRow)
 	glPopMatrix();
 }
 
+void parseCommandLine(int argc, char* argv[])
+{
+	//	glutInit has already removed the options it recognized
+	for (int k = 1; k < argc; k++)
+	{
+		string arg = argv[k];
+		if (arg == "--trace" && k + 1 < argc)
+		{
+			traceSeconds = static_cast<float>(atof(argv[++k]));
+			traceAtLaunch = traceSeconds > 0.f;
+		}
+		else if (arg == "--trace-file" && k + 1 < argc)
+		{
+			traceFilePath = argv[++k];
+		}
+		else if (arg == "--capture" && k + 1 < argc)
+		{
+			captureFilePath = argv[++k];
+			captureAtLaunch = true;
+		}
+		else if (arg == "--perf-counters")
+		{
+			usePerfCounters = true;
+		}
+		else if (arg == "--profile-json" && k + 1 < argc)
+		{
+			profileJSONPath = argv[++k];
+		}
+		else if (arg == "--frame-budget" && k + 1 < argc)
+		{
+			float budgetMs = static_cast<float>(atof(argv[++k]));
+			if (budgetMs > 0.f)
+				frameScheduler.setFrameBudget(budgetMs / 1000.f);
+		}
+		else if (arg == "--asteroids" && k + 1 < argc)
+		{
+			nbInitialAsteroids = max(0, atoi(argv[++k]));
+		}
+		else if (arg == "--world-scale" && k + 1 < argc)
+		{
+			worldScale = max(1.f, static_cast<float>(atof(argv[++k])));
+		}
+		else if (arg == "--headless" && k + 1 < argc)
+		{
+			headlessFrames = max(1, atoi(argv[++k]));
+		}
+		else if (arg == "--render-out" && k + 1 < argc)
+		{
+			renderOutPath = argv[++k];
+		}
+		else if (arg == "--render-threads" && k + 1 < argc)
+		{
+			renderThreads = static_cast<unsigned int>(max(0, atoi(argv[++k])));
+		}
+		else if (arg == "--seed" && k + 1 < argc)
+		{
+			randomSeed = static_cast<unsigned int>(strtoul(argv[++k], nullptr, 10));
+		}
+		else if (arg == "--batch" && k + 1 < argc)
+		{
+			batchWorlds = max(1, atoi(argv[++k]));
+		}
+		else if (arg == "--batch-steps" && k + 1 < argc)
+		{
+			batchSteps = max(1, atoi(argv[++k]));
+		}
+		else if (arg == "--batch-threads" && k + 1 < argc)
+		{
+			batchThreads = static_cast<unsigned int>(max(0, atoi(argv[++k])));
+		}
+		else if (arg == "--batch-vectorized")
+		{
+			batchVectorized = true;
+		}
+		else if (arg == "--batch-check")
+		{
+			batchVectorized = batchCheck = true;
+		}
+		else
+		{
+			cerr << "Ignored unknown option " << arg << endl;
+		}
+	}
+
+	//	Before any mode starts, so that all of them are measured
+	if (usePerfCounters && !PerfCounters::enable())
+		cerr << "Hardware counters " << PerfCounters::getStatus() << endl;
+}
+
+//	Registered with atexit, since glutMainLoop never returns
+void writeProfileJSON()
+{
+	ofstream out(profileJSONPath);
+	if (out)
+		Profiler::writeJSON(out);
+	else
+		cerr << "Could not write profiling report " << profileJSONPath << endl;
+}
+
+//	The view is the camera's rectangle (see myResizeFunc).  Each copy of the
+//	objects of the sectors around it is tested against it directly.
+bool isInView(const BoundingBox& box, float dx, float dy)
+{
+	return	box.getXmax() + dx >= camera.getXmin() && box.getXmin() + dx <= camera.getXmax() &&
+			box.getYmax() + dy >= camera.getYmin() && box.getYmin() + dy <= camera.getYmax();
+}
+
+string getRenderSummaryLine(const WorldSnapshot& snapshot)
+{
+	char line[200];
+	snprintf(line, sizeof(line),
+			 "Render: %u drawn, %u culled | %u commands, %u states | "
+			 "%u draw calls, %u vertices, %u instances",
+			 snapshot.nbCopiesDrawn, snapshot.nbCopiesCulled, snapshot.commands.getCommandCount(),
+			 snapshot.commands.getStateChangeCount(),
+			 renderer.getDrawCallCount(), renderer.getVertexCount(), renderer.getInstanceCount());
+	return line;
+}
+
 void printMatrix(const GLfloat* m) {
 	cout << "((" << m[0] << "\t" << m[4] << "\t" << m[8] << "\t" << m[12] << ")" << endl;
 	cout << " (" << m[1] << "\t" << m[5] << "\t" << m[9] << "\t" << m[13] << ")" << endl;
@@ -990,9 +1451,18 @@ void applicationInit()
 	glutAddMenuEntry("-", MenuItemID::SEPARATOR);
 	glutAttachMenu(GLUT_RIGHT_BUTTON);
 
-	spaceship = std::make_shared<SpaceShip>(0.f, 0.f, 0.f, 0.5f, 1.0f, 0.f, 0.f, true,
-		0.f, 0.f, 0.f);
-	objList.push_back(spaceship);
+	createWorld();
+}
+
+//	Creates the spaceship (and the initial asteroids) and sets up the world.
+//	Needs no window: also used by the headless mode.
+void createWorld()
+{
+	//	sectors as large as the view
+	simulation = make_unique<Simulation>(worldScale * X_MIN, worldScale * X_MAX,
+										 worldScale * Y_MIN, worldScale * Y_MAX, WORLD_TYPE,
+										 randomSeed, nbInitialAsteroids, camera.getWidth());
+	spaceship = simulation->getSpaceShip();
 
 	////	Create a bunch of objects
 	//for (int k=0; k< NUM_OBJECTS; k++)
@@ -1032,22 +1502,231 @@ void applicationInit()
 	//}
 
 
-	World2D::setWorld2DBounds(X_MIN, X_MAX, Y_MIN, Y_MAX, winWidth, winHeight);
+	World2D::setView(camera.getWidth(), camera.getHeight(), winWidth, winHeight);
 
 	//	time really starts now
 	startTime = time(nullptr);
 }
 
+//	Runs the simulation at 60 frames per second of simulated time, and draws
+//	each frame with the CPU rasterizer instead of OpenGL.  No window (nor
+//	display) is needed.
+int runHeadless()
+{
+	createWorld();
+
+	const World2D& world = simulation->getWorld();
+	SoftwareRenderer software(winWidth, winHeight, renderThreads);
+	software.setView(-0.5f * camera.getWidth(), 0.5f * camera.getWidth(),
+					 -0.5f * camera.getHeight(), 0.5f * camera.getHeight());
+	software.setClearColor(WIN_CLEAR_COLOR[0], WIN_CLEAR_COLOR[1], WIN_CLEAR_COLOR[2]);
+
+	const float dt = frameScheduler.getStepDuration();
+	const int stepsPerFrame = max(1, static_cast<int>(roundf(1.f / (60.f * dt))));
+	WorldSnapshot snapshot;
+	vector<double> renderMs;
+	renderMs.reserve(headlessFrames);
+	double stepMs = 0.0;
+	for (int frame = 0; frame < headlessFrames; frame++)
+	{
+		chrono::steady_clock::time_point stepStart = chrono::steady_clock::now();
+		for (int step = 0; step < stepsPerFrame; step++)
+			simulation->step(dt);
+		stepMs += chrono::duration<double, milli>(chrono::steady_clock::now() - stepStart).count();
+
+		chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+		{
+			ProfileScope drawScope(ProfileZone::DRAW, world.getObjects().size());
+			software.clear();
+			recordSnapshot(snapshot);
+			snapshot.commands.submit(software);
+			software.flush();
+		}
+		renderMs.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() -
+														   frameStart).count());
+	}
+
+	vector<double> sorted = renderMs;
+	sort(sorted.begin(), sorted.end());
+	double total = 0.0;
+	for (double ms : renderMs)
+		total += ms;
+	char line[256];
+	snprintf(line, sizeof(line),
+			 "Headless: %d frames of %dx%d, %u threads | %u objects drawn, %u triangles | "
+			 "render mean %.3f ms, p50 %.3f ms, max %.3f ms",
+			 headlessFrames, software.getWidth(), software.getHeight(), software.getThreadCount(),
+			 snapshot.nbCopiesDrawn, software.getTriangleCount(), total / renderMs.size(),
+			 sorted[sorted.size() / 2], sorted.back());
+	cout << line << endl;
+	snprintf(line, sizeof(line),
+			 "World: %zu objects in %d sectors (%d awake, %d slow, the others asleep) | "
+			 "step mean %.3f ms",
+			 world.getObjects().size(), world.getSectorCount(), simulation->getAwakeSectorCount(),
+			 simulation->getSlowSectorCount(), stepMs / (static_cast<double>(headlessFrames) * stepsPerFrame));
+	cout << line << endl;
+
+	if (usePerfCounters)
+		Profiler::report(cout);
+
+	if (renderOutPath != "" && !software.writePPM(renderOutPath))
+	{
+		cerr << "Could not write image " << renderOutPath << endl;
+		return 1;
+	}
+	if (profileJSONPath != "")
+		writeProfileJSON();
+	return 0;
+}
+
+//	Runs a batch of independent worlds without a window, one per seed from
+//	randomSeed on, all of them for the same number of steps, and reports
+//	the throughput and how the ships fared (for balance tests and sweeps).
+//	With --batch-check, the worlds are run both ways and compared.
+int runBatch()
+{
+	const float dt = frameScheduler.getStepDuration();
+	BatchRunner runner(batchThreads);
+	vector<WorldOutcome> outcome;
+	double seconds = batchVectorized ? runVectorizedBatch(runner, dt, outcome) :
+									   runScalarBatch(runner, dt, outcome);
+
+	unsigned int nbSurvivors = 0;
+	double totalHealth = 0.0, totalObjects = 0.0, totalAsteroids = 0.0;
+	for (const WorldOutcome& world : outcome)
+	{
+		if (world.shipAlive)
+			nbSurvivors++;
+		totalHealth += max(0, world.health);
+		totalObjects += world.nbObjects;
+		totalAsteroids += world.nbAsteroids;
+	}
+	char line[320];
+	snprintf(line, sizeof(line),
+			 "Batch%s: %d worlds x %d steps (%.1f s simulated each), %u threads | %.3f s, "
+			 "%.0f env steps/s | ship survived in %.1f%%, mean health %.1f, "
+			 "mean %.1f asteroids created, %.1f objects left",
+			 batchVectorized ? " (vectorized)" : "", batchWorlds, batchSteps, batchSteps * dt,
+			 runner.getThreadCount(), seconds, static_cast<double>(batchWorlds) * batchSteps / seconds,
+			 100.0 * nbSurvivors / batchWorlds, totalHealth / batchWorlds,
+			 totalAsteroids / batchWorlds, totalObjects / batchWorlds);
+	cout << line << endl;
+	if (usePerfCounters)
+		Profiler::report(cout);
+
+	int status = 0;
+	if (batchCheck)
+	{
+		vector<WorldOutcome> reference;
+		double scalarSeconds = runScalarBatch(runner, dt, reference);
+		int nbDiffer = 0;
+		for (int k = 0; k < batchWorlds; k++)
+		{
+			const WorldOutcome &a = outcome[k], &b = reference[k];
+			if (a.shipAlive != b.shipAlive || a.health != b.health ||
+				a.nbObjects != b.nbObjects || a.nbAsteroids != b.nbAsteroids)
+			{
+				if (nbDiffer++ < 10)
+					cerr << "Seed " << randomSeed + k << ": health " << a.health << " vs " << b.health
+						 << ", " << a.nbObjects << " vs " << b.nbObjects << " objects left" << endl;
+			}
+		}
+		snprintf(line, sizeof(line),
+				 "Check: %d of %d worlds differ from the scalar simulation | scalar %.3f s, "
+				 "vectorized %.1f times as fast",
+				 nbDiffer, batchWorlds, scalarSeconds, scalarSeconds / seconds);
+		cout << line << endl;
+		status = nbDiffer == 0 ? 0 : 1;
+	}
+
+	if (profileJSONPath != "")
+		writeProfileJSON();
+	return status;
+}
+
+//	One Simulation per world
+double runScalarBatch(const BatchRunner& runner, float dt, vector<WorldOutcome>& outcome)
+{
+	vector<unique_ptr<Simulation>> batch;
+	batch.reserve(batchWorlds);
+	for (int k = 0; k < batchWorlds; k++)
+		batch.push_back(make_unique<Simulation>(X_MIN, X_MAX, Y_MIN, Y_MAX, WORLD_TYPE,
+												randomSeed + k, nbInitialAsteroids));
+
+	double seconds = runner.run(batch, batchSteps, dt);
+
+	outcome.clear();
+	for (const auto& sim : batch)
+		outcome.push_back({sim->getSpaceShip()->isAlive(), sim->getSpaceShip()->getHealth(),
+						   static_cast<unsigned int>(sim->getWorld().getObjects().size()),
+						   sim->getAsteroidCount()});
+	return seconds;
+}
+
+//	Blocks of worlds stepped in SIMD lanes
+double runVectorizedBatch(const BatchRunner& runner, float dt, vector<WorldOutcome>& outcome)
+{
+	vector<unique_ptr<WorldBatch>> blocks;
+	for (int first = 0; first < batchWorlds; first += WORLDS_PER_BLOCK)
+		blocks.push_back(make_unique<WorldBatch>(min(WORLDS_PER_BLOCK, batchWorlds - first),
+												 X_MIN, X_MAX, Y_MIN, Y_MAX, WORLD_TYPE,
+												 randomSeed + first, nbInitialAsteroids));
+
+	double seconds = runner.run(blocks, batchSteps, dt);
+
+	outcome.clear();
+	for (const auto& block : blocks)
+		for (int w = 0; w < block->getWorldCount(); w++)
+			outcome.push_back({block->isShipAlive(w), block->getHealth(w),
+							   block->getLiveCount(w), block->getAsteroidCount(w)});
+	return seconds;
+}
+
 int main(int argc, char* argv[])
 {
+	//	Without a window, glut must not even be initialized
+	for (int k = 1; k < argc; k++)
+	{
+		if (string(argv[k]) == "--headless")
+		{
+			parseCommandLine(argc, argv);
+			return runHeadless();
+		}
+		if (string(argv[k]) == "--batch")
+		{
+			parseCommandLine(argc, argv);
+			return runBatch();
+		}
+	}
+
 	//	Initialize glut and create a new window
 	glutInit(&argc, argv);
-	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
+	parseCommandLine(argc, argv);
+	glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
 
 	glutInitWindowSize(winWidth, winHeight);
 	glutInitWindowPosition(INIT_WIN_X, INIT_WIN_Y);
 	glutCreateWindow("Earshooter Demo");
 	glClearColor(WIN_CLEAR_COLOR[0], WIN_CLEAR_COLOR[1], WIN_CLEAR_COLOR[2], 1.f);
+	//	needs the GL context of the window
+	renderer.initialize();
+	switch (fontSize)
+	{
+	case SMALL_FONT_SIZE:
+		hudText.initialize(SMALL_DISPLAY_FONT, 10);
+		break;
+
+	case MEDIUM_FONT_SIZE:
+		hudText.initialize(MEDIUM_DISPLAY_FONT, 12);
+		break;
+
+	case LARGE_FONT_SIZE:
+		hudText.initialize(LARGE_DISPLAY_FONT, 16);
+		break;
+
+	default:
+		break;
+	}
 
 	//	set up the callbacks
 	glutDisplayFunc(myDisplayFunc);
@@ -1063,12 +1742,24 @@ int main(int argc, char* argv[])
 	glutTimerFunc(physicsHeartBeat, myTimerFunc, 0);
 	//			  time	    name of		value to pass
 	//			  in ms		function	to the func
-	SpaceShip::setObjectList(&objList);
-	Projectile::setObjectList(&objList);
 
 	//	Now we can do application-level
 	applicationInit();
 
+	if (traceAtLaunch)
+		TraceRecorder::start(traceSeconds, traceFilePath);
+
+	if (captureAtLaunch)
+		frameCapture.start(captureFilePath, winWidth, winHeight);
+
+	if (profileJSONPath != "")
+		atexit(writeProfileJSON);
+
+	//	The simulation takes over from here
+	simulationRunning = true;
+	simulationThread = thread(simulationLoop);
+	atexit(stopSimulation);
+
 	//	Now we enter the main loop of the program and to a large extend
 	//	"lose control" over its execution.  The callback functions that
 	//	we set up earlier will be called when the corresponding event